@@ -238,6 +238,7 @@ FSoundChan *SoundEngine::GetChannel(void *syschan)
 
 void SoundEngine::ReturnChannel(FSoundChan *chan)
 {
+	UnindexChannel(chan);
 	UnlinkChannel(chan);
 	memset(chan, 0, sizeof(*chan));
 	LinkChannel(chan, &FreeChannels);
@@ -275,6 +276,103 @@ void SoundEngine::LinkChannel(FSoundChan *chan, FSoundChan **head)
 	chan->PrevChan = head;
 }
 
+//==========================================================================
+//
+// S_IndexChannel
+//
+// Files the channel under its source and sound so that the functions
+// which look for these do not have to check every playing channel.
+// Sourceless channels are only found by walking the full list.
+//
+//==========================================================================
+
+void SoundEngine::IndexChannel(FSoundChan *chan)
+{
+	const void *source = chan->Source;
+	int sound = chan->SoundID.index();
+
+	if (source == chan->IndexedSource && sound == chan->IndexedSound)
+	{
+		return;
+	}
+	UnindexChannel(chan);
+
+	if (source != nullptr)
+	{
+		FSoundChan *&head = SourceChannels[source];
+		chan->NextSourceChan = head;
+		chan->PrevSourceChan = nullptr;
+		if (head != nullptr) head->PrevSourceChan = chan;
+		head = chan;
+		chan->IndexedSource = source;
+	}
+	if (sound > 0)
+	{
+		if ((unsigned)sound >= SoundChannels.Size())
+		{
+			unsigned oldsize = SoundChannels.Size();
+			SoundChannels.Resize(sound + 1);
+			for (unsigned i = oldsize; i < SoundChannels.Size(); i++) SoundChannels[i] = nullptr;
+		}
+		FSoundChan *&head = SoundChannels[sound];
+		chan->NextSoundChan = head;
+		chan->PrevSoundChan = nullptr;
+		if (head != nullptr) head->PrevSoundChan = chan;
+		head = chan;
+		chan->IndexedSound = sound;
+	}
+}
+
+//==========================================================================
+//
+// S_UnindexChannel
+//
+//==========================================================================
+
+void SoundEngine::UnindexChannel(FSoundChan *chan)
+{
+	if (chan->IndexedSource != nullptr)
+	{
+		if (chan->PrevSourceChan != nullptr) chan->PrevSourceChan->NextSourceChan = chan->NextSourceChan;
+		else if (chan->NextSourceChan != nullptr) SourceChannels[chan->IndexedSource] = chan->NextSourceChan;
+		else SourceChannels.Remove(chan->IndexedSource);
+		if (chan->NextSourceChan != nullptr) chan->NextSourceChan->PrevSourceChan = chan->PrevSourceChan;
+		chan->NextSourceChan = chan->PrevSourceChan = nullptr;
+		chan->IndexedSource = nullptr;
+	}
+	if (chan->IndexedSound > 0)
+	{
+		if (chan->PrevSoundChan != nullptr) chan->PrevSoundChan->NextSoundChan = chan->NextSoundChan;
+		else SoundChannels[chan->IndexedSound] = chan->NextSoundChan;
+		if (chan->NextSoundChan != nullptr) chan->NextSoundChan->PrevSoundChan = chan->PrevSoundChan;
+		chan->NextSoundChan = chan->PrevSoundChan = nullptr;
+		chan->IndexedSound = 0;
+	}
+}
+
+//==========================================================================
+//
+// Walks the channels indexed under a source, or all channels if there is
+// no source. Since sources can be detached from a channel without
+// reindexing it, callers still need to check the channel's actual source.
+//
+//==========================================================================
+
+FSoundChan *SoundEngine::FirstChannel(const void *source)
+{
+	if (source == nullptr)
+	{
+		return Channels;
+	}
+	FSoundChan **head = SourceChannels.CheckKey(source);
+	return head != nullptr ? *head : nullptr;
+}
+
+FSoundChan *SoundEngine::NextChannel(FSoundChan *chan, const void *source)
+{
+	return source != nullptr ? chan->NextSourceChan : chan->NextChan;
+}
+
 //==========================================================================
 //
 //
@@ -544,8 +642,12 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 	// If this actor is already playing something on the selected channel, stop it.
 	if (!(chanflags & CHANF_OVERLAP) && type != SOURCE_None && ((source == NULL && channel != CHAN_AUTO) || (source != NULL && IsChannelUsed(type, source, channel, &seen))))
 	{
-		for (chan = Channels; chan != NULL; chan = chan->NextChan)
+		// Unattached channels are matched by position and are never indexed.
+		const void *key = type != SOURCE_Unattached ? source : nullptr;
+		FSoundChan *next;
+		for (chan = FirstChannel(key); chan != NULL; chan = next)
 		{
+			next = NextChannel(chan, key);
 			if (chan->SourceType == type && chan->EntChannel == channel)
 			{
 				const bool foundit = (type == SOURCE_Unattached)
@@ -630,6 +732,7 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		{
 			chan->Source = source;
 		}
+		IndexChannel(chan);
 	}
 
 	return chan;
@@ -688,7 +791,7 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 			return;
 		}
 
-		chan->ChanFlags &= ~(CHANF_EVICTED|CHANF_ABSTIME);
+		chan->ChanFlags &= ~(CHANF_EVICTED|CHANF_ABSTIME|CHANF_INAUDIBLE);
         ochan = (FSoundChan*)GSnd->StartSound3D(sfx->data, &listener, chan->Volume, &chan->Rolloff, chan->DistanceScale, chan->Pitch,
             chan->Priority, pos, vel, chan->EntChannel, startflags, chan);
 	}
@@ -828,11 +931,16 @@ bool SoundEngine::CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_
 {
 	FSoundChan *chan;
 	int count;
+	unsigned sound = unsigned(sfx - &S_sfx[0]);
 
-	for (chan = Channels, count = 0; chan != NULL && count < near_limit; chan = chan->NextChan)
+	if (sound >= SoundChannels.Size())
+	{
+		return false;
+	}
+	for (chan = SoundChannels[sound], count = 0; chan != NULL && count < near_limit; chan = chan->NextSoundChan)
 	{
 		if (chan->ChanFlags & CHANF_FORGETTABLE) continue;
-		if (!(chan->ChanFlags & CHANF_EVICTED) && &S_sfx[chan->SoundID.index()] == sfx)
+		if (!(chan->ChanFlags & CHANF_EVICTED))
 		{
 			FVector3 chanorigin;
 
@@ -908,10 +1016,10 @@ void SoundEngine::StopSound (int channel, FSoundID sound_id)
 
 void SoundEngine::StopSound(int sourcetype, const void* actor, int channel, FSoundID sound_id)
 {
-	FSoundChan* chan = Channels;
+	FSoundChan* chan = FirstChannel(actor);
 	while (chan != NULL)
 	{
-		FSoundChan* next = chan->NextChan;
+		FSoundChan* next = NextChannel(chan, actor);
 		if (chan->SourceType == sourcetype &&
 			chan->Source == actor &&
 			(sound_id == INVALID_SOUND? (chan->EntChannel == channel || channel < 0) : (chan->OrgID == sound_id)))
@@ -935,10 +1043,10 @@ void SoundEngine::StopActorSounds(int sourcetype, const void* actor, int chanmin
 	const bool all = (chanmin == 0 && chanmax == 0);
 	if (chanmax < chanmin) std::swap(chanmin, chanmax);
 
-	FSoundChan* chan = Channels;
+	FSoundChan* chan = FirstChannel(actor);
 	while (chan != nullptr)
 	{
-		FSoundChan* next = chan->NextChan;
+		FSoundChan* next = NextChannel(chan, actor);
 		if (chan->SourceType == sourcetype &&
 			chan->Source == actor &&
 			(all || (chan->EntChannel >= chanmin && chan->EntChannel <= chanmax)))
@@ -982,15 +1090,16 @@ void SoundEngine::RelinkSound (int sourcetype, const void *from, const void *to,
 	if (from == NULL)
 		return;
 
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = FirstChannel(from);
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
+		FSoundChan *next = NextChannel(chan, from);
 		if (chan->SourceType == sourcetype && chan->Source == from)
 		{
 			if (to != NULL)
 			{
 				chan->Source = to;
+				IndexChannel(chan);
 			}
 			else if (!(chan->ChanFlags & CHANF_LOOP) && optpos)
 			{
@@ -999,6 +1108,7 @@ void SoundEngine::RelinkSound (int sourcetype, const void *from, const void *to,
 				chan->Point[0] = optpos->X;
 				chan->Point[1] = optpos->Y;
 				chan->Point[2] = optpos->Z;
+				IndexChannel(chan);
 			}
 			else
 			{
@@ -1025,7 +1135,7 @@ void SoundEngine::ChangeSoundVolume(int sourcetype, const void *source, int chan
 	else if (volume > 1.0)
 		volume = 1.0;
 
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = FirstChannel(source); chan != NULL; chan = NextChannel(chan, source))
 	{
 		if (chan->SourceType == sourcetype &&
 			chan->Source == source &&
@@ -1056,7 +1166,7 @@ void SoundEngine::SetVolume(FSoundChan* chan, float volume)
 
 void SoundEngine::ChangeSoundPitch(int sourcetype, const void *source, int channel, double pitch, FSoundID sound_id)
 {
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = FirstChannel(source); chan != NULL; chan = NextChannel(chan, source))
 	{
 		if (chan->SourceType == sourcetype &&
 			chan->Source == source &&
@@ -1085,9 +1195,11 @@ void SoundEngine::SetPitch(FSoundChan *chan, float pitch)
 int SoundEngine::GetSoundPlayingInfo (int sourcetype, const void *source, FSoundID sound_id, int chann)
 {
 	int count = 0;
+	const void *key = sourcetype != SOURCE_Any ? source : nullptr;
+
 	if (sound_id.isvalid())
 	{
-		for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+		for (FSoundChan *chan = FirstChannel(key); chan != NULL; chan = NextChannel(chan, key))
 		{
 			if (chann != -1 && chann != chan->EntChannel) continue;
 			if (chan->OrgID == sound_id && (sourcetype == SOURCE_Any ||
@@ -1100,7 +1212,7 @@ int SoundEngine::GetSoundPlayingInfo (int sourcetype, const void *source, FSound
 	}
 	else
 	{
-		for (FSoundChan* chan = Channels; chan != NULL; chan = chan->NextChan)
+		for (FSoundChan* chan = FirstChannel(key); chan != NULL; chan = NextChannel(chan, key))
 		{
 			if (chann != -1 && chann != chan->EntChannel) continue;
 			if ((sourcetype == SOURCE_Any || (chan->SourceType == sourcetype &&	chan->Source == source)))
@@ -1128,7 +1240,7 @@ bool SoundEngine::IsChannelUsed(int sourcetype, const void *actor, int channel,
 	{
 		return true;
 	}
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = FirstChannel(actor); chan != NULL; chan = NextChannel(chan, actor))
 	{
 		if (chan->SourceType == sourcetype && chan->Source == actor)
 		{
@@ -1150,7 +1262,8 @@ bool SoundEngine::IsChannelUsed(int sourcetype, const void *actor, int channel,
 
 bool SoundEngine::IsSourcePlayingSomething (int sourcetype, const void *actor, int channel, FSoundID sound_id)
 {
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	const void *key = sourcetype != SOURCE_None && sourcetype != SOURCE_Unattached ? actor : nullptr;
+	for (FSoundChan *chan = FirstChannel(key); chan != NULL; chan = NextChannel(chan, key))
 	{
 		if (chan->SourceType == sourcetype && (sourcetype == SOURCE_None || sourcetype == SOURCE_Unattached || chan->Source == actor))
 		{
@@ -1267,7 +1380,17 @@ void SoundEngine::UpdateSounds(int time)
 
 			if (ValidatePosVel(chan, pos, vel))
 			{
-				GSnd->UpdateSoundParams3D(&listener, chan, !!(chan->ChanFlags & CHANF_AREA), pos, vel);
+				// A sound that is out of hearing range only needs to be told so once.
+				// Log rolloff never goes silent so it never gets skipped.
+				bool inaudible = !(chan->ChanFlags & CHANF_AREA) && chan->Rolloff.MinDistance > 0 &&
+					GetRolloff(&chan->Rolloff, (pos - listener.position).Length() * chan->DistanceScale) <= 0;
+
+				if (!inaudible || !(chan->ChanFlags & CHANF_INAUDIBLE))
+				{
+					GSnd->UpdateSoundParams3D(&listener, chan, !!(chan->ChanFlags & CHANF_AREA), pos, vel);
+				}
+				if (inaudible) chan->ChanFlags |= CHANF_INAUDIBLE;
+				else chan->ChanFlags &= ~CHANF_INAUDIBLE;
 			}
 		}
 		chan->ChanFlags &= ~CHANF_JUSTSTARTED;
@@ -129,6 +129,20 @@ struct FSoundChan : public FISoundChannel
 	float		LimitRange;
 	const void *Source;
 	float Point[3];	// Sound is not attached to any source.
+
+	// Secondary lists of the channels playing from the same source and playing the same sound.
+	// These use the source and sound the channel was indexed with, which need not be current.
+	FSoundChan	*NextSourceChan, *PrevSourceChan;
+	FSoundChan	*NextSoundChan, *PrevSoundChan;
+	const void	*IndexedSource;
+	int			IndexedSound;
+};
+
+// Sound sources are heap objects so the lowest bits of their address carry no information.
+struct FSoundSourceHashTraits
+{
+	hash_t Hash(const void *key) { return (hash_t)((uintptr_t)key >> 4); }
+	int Compare(const void *left, const void *right) { return left != right; }
 };
 
 
@@ -190,6 +204,10 @@ protected:
 	FSoundChan* Channels = nullptr;
 	FSoundChan* FreeChannels = nullptr;
 
+	// Heads of the per-source and per-sound channel lists.
+	TMap<const void*, FSoundChan*, FSoundSourceHashTraits> SourceChannels;
+	TArray<FSoundChan*> SoundChannels;
+
 	// the complete set of sound effects
 	TArray<sfxinfo_t> S_sfx;
 	FRolloffInfo S_Rolloff{};
@@ -202,6 +220,9 @@ protected:
 private:
 	void LinkChannel(FSoundChan* chan, FSoundChan** head);
 	void UnlinkChannel(FSoundChan* chan);
+	void UnindexChannel(FSoundChan* chan);
+	FSoundChan* FirstChannel(const void* source);
+	FSoundChan* NextChannel(FSoundChan* chan, const void* source);
 	void ReturnChannel(FSoundChan* chan);
 	void RestartChannel(FSoundChan* chan);
 	void RestoreEvictedChannel(FSoundChan* chan);
@@ -271,6 +292,8 @@ public:
 	void SetVolume(FSoundChan* chan, float vol);
 
 	FSoundChan* GetChannel(void* syschan);
+	// Must be called whenever a channel's source or sound has been set from the outside.
+	void IndexChannel(FSoundChan* chan);
 	void RestoreEvictedChannels();
 	void CalcPosVel(FSoundChan* chan, FVector3* pos, FVector3* vel);
 
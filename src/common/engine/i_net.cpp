@@ -75,6 +75,8 @@
 #include "cmdlib.h"
 #include "printf.h"
 #include "i_interface.h"
+#include "c_cvars.h"
+#include "stats.h"
 
 
 #include "i_net.h"
@@ -160,6 +162,33 @@ struct PreGamePacket
 
 uint8_t TransmitBuffer[TRANSMIT_SIZE];
 
+// Packets shorter than this rarely get smaller and aren't worth the effort.
+#define MIN_COMPRESS_LENGTH	16
+
+// After this many packets in a row that didn't get smaller, a node's packets are
+// sent uncompressed for a while before trying again.
+#define COMPRESS_MAX_FAILURES	4
+#define COMPRESS_SKIP_PACKETS	35
+
+// Every level is decoded by the same zlib stream format, so this can be
+// changed freely without affecting the other nodes.
+CUSTOM_CVAR(Int, net_compression, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > 9) self = 9;
+}
+
+struct FNetCompressStats
+{
+	uint64_t SentPackets, CompressedPackets, SentBytes, SentRawBytes;
+	uint64_t RecvPackets, RecvBytes, RecvRawBytes;
+	cycle_t CompressTime, DecompressTime;
+	int Failures;
+	int SkipPackets;
+};
+
+static FNetCompressStats NetCompressStats[MAXNETNODES];
+
 FString GetPlayerName(int num)
 {
 	if (sysCallbacks.GetPlayerName) return sysCallbacks.GetPlayerName(sendplayer[num]);
@@ -233,20 +262,39 @@ void PacketSend (void)
 	}
 	assert(!(doomcom.data[0] & NCMD_COMPRESSED));
 
+	auto& stats = NetCompressStats[doomcom.remotenode];
 	uLong size = TRANSMIT_SIZE - 1;
-	if (doomcom.datalength >= 10)
+	// Packets that don't fit into the transmit buffer can only be sent compressed.
+	bool mustcompress = doomcom.datalength > TRANSMIT_SIZE;
+	if (mustcompress || (net_compression > 0 && doomcom.datalength >= MIN_COMPRESS_LENGTH && stats.SkipPackets == 0))
 	{
 		TransmitBuffer[0] = doomcom.data[0] | NCMD_COMPRESSED;
-		c = compress2(TransmitBuffer + 1, &size, doomcom.data + 1, doomcom.datalength - 1, 9);
+		stats.CompressTime.Clock();
+		// Oversized packets are compressed as well as possible so that they are certain to fit, whatever the player chose for the others.
+		c = compress2(TransmitBuffer + 1, &size, doomcom.data + 1, doomcom.datalength - 1, mustcompress ? 9 : (int)net_compression);
+		stats.CompressTime.Unclock();
 		size += 1;
+
+		// If this node's packets don't get any smaller, stop wasting time on them for a while.
+		if (c == Z_OK && size < (uLong)doomcom.datalength) stats.Failures = 0;
+		else if (++stats.Failures >= COMPRESS_MAX_FAILURES)
+		{
+			stats.Failures = 0;
+			stats.SkipPackets = COMPRESS_SKIP_PACKETS;
+		}
 	}
 	else
 	{
+		if (stats.SkipPackets > 0) stats.SkipPackets--;
 		c = -1;	// Just some random error code to avoid sending the compressed buffer.
 	}
+	stats.SentPackets++;
+	stats.SentRawBytes += doomcom.datalength;
 	if (c == Z_OK && size < (uLong)doomcom.datalength)
 	{
 //		Printf("send %lu/%d\n", size, doomcom.datalength);
+		stats.CompressedPackets++;
+		stats.SentBytes += size;
 		c = sendto(mysocket, (char *)TransmitBuffer, size,
 			0, (sockaddr *)&sendaddress[doomcom.remotenode],
 			sizeof(sendaddress[doomcom.remotenode]));
@@ -260,6 +308,7 @@ void PacketSend (void)
 		else
 		{
 //			Printf("send %d\n", doomcom.datalength);
+			stats.SentBytes += doomcom.datalength;
 			c = sendto(mysocket, (char *)doomcom.data, doomcom.datalength,
 				0, (sockaddr *)&sendaddress[doomcom.remotenode],
 				sizeof(sendaddress[doomcom.remotenode]));
@@ -318,11 +367,16 @@ void PacketGet (void)
 	}
 	else if (node >= 0 && c > 0)
 	{
+		auto& stats = NetCompressStats[node];
+		stats.RecvPackets++;
+		stats.RecvBytes += c;
 		doomcom.data[0] = TransmitBuffer[0] & ~NCMD_COMPRESSED;
 		if (TransmitBuffer[0] & NCMD_COMPRESSED)
 		{
 			uLongf msgsize = MAX_MSGLEN - 1;
+			stats.DecompressTime.Clock();
 			int err = uncompress(doomcom.data + 1, &msgsize, TransmitBuffer + 1, c - 1);
+			stats.DecompressTime.Unclock();
 //			Printf("recv %d/%lu\n", c, msgsize + 1);
 			if (err != Z_OK)
 			{
@@ -350,10 +404,31 @@ void PacketGet (void)
 		return;
 	}
 
+	if (node >= 0) NetCompressStats[node].RecvRawBytes += c;
 	doomcom.remotenode = node;
 	doomcom.datalength = (short)c;
 }
 
+//
+// Packet compression statistics
+//
+ADD_STAT(netcompress)
+{
+	FString out;
+	for (int i = 0; i < doomcom.numnodes && i < MAXNETNODES; i++)
+	{
+		auto& stats = NetCompressStats[i];
+		if (stats.SentPackets == 0 && stats.RecvPackets == 0) continue;
+
+		int64_t saved = stats.SentRawBytes - stats.SentBytes;
+		int64_t recvsaved = stats.RecvRawBytes - stats.RecvBytes;
+		out.AppendFormat("node %d: sent %llu/%llu packets compressed, %lld bytes saved, %.2f ms  recv %llu packets, %lld bytes saved, %.2f ms\n", i,
+			(unsigned long long)stats.CompressedPackets, (unsigned long long)stats.SentPackets, (long long)saved, stats.CompressTime.TimeMS(),
+			(unsigned long long)stats.RecvPackets, (long long)recvsaved, stats.DecompressTime.TimeMS());
+	}
+	return out;
+}
+
 sockaddr_in *PreGet (void *buffer, int bufferlen, bool noabort)
 {
 	static sockaddr_in fromaddress;
@@ -49,6 +49,7 @@
 #include "name.h"
 #include <inttypes.h>
 #include "filesystem.h"
+#include "vmcache.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -204,6 +205,7 @@ void FScanner :: OpenLumpNum (int lump)
 		auto buff = ScriptBuffer.LockNewBuffer(len);
 		fileSystem.ReadFile(lump, buff);
 		buff[len] = 0;
+		VMCache_AddSource(buff, len);
 		ScriptBuffer.UnlockBuffer();
 	}
 	ScriptName = fileSystem.GetFileFullPath(lump).c_str();
@@ -118,18 +118,185 @@ const char *UnicodeToString(const char *cc)
 	return &out[0];
 }
 
+//==========================================================================
+//
+// Binary serializer data is converted straight into the JSON DOM
+// so that the reader does not need to care where it came from.
+//
+//==========================================================================
+
+bool IsBinarySerializerData(const char *buffer, size_t length)
+{
+	return length > sizeof(BinarySerializerMagic) && !memcmp(buffer, BinarySerializerMagic, sizeof(BinarySerializerMagic));
+}
+
+struct FBinarySerializerReader
+{
+	const uint8_t *p, *end;
+	TArray<std::pair<const char *, unsigned>> keys;
+
+	struct Container
+	{
+		bool isobject;
+		bool expectkey;
+		unsigned count;
+	};
+	TArray<Container> stack;
+
+	bool Varint(uint64_t &v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64 && p < end; shift += 7)
+		{
+			uint8_t b = *p++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	bool Chars(const char *&str, unsigned &len)
+	{
+		uint64_t l;
+		if (!Varint(l) || l > uint64_t(end - p)) return false;
+		str = (const char*)p;
+		len = (unsigned)l;
+		p += l;
+		return true;
+	}
+
+	template<class Handler>
+	bool operator()(Handler &h)
+	{
+		while (p < end)
+		{
+			uint8_t tag = *p++;
+			bool iskey = tag == BST_KeyNew || tag == BST_KeyRef || tag == BST_KeyLiteral;
+			bool isend = tag == BST_EndObject || tag == BST_EndArray;
+
+			// Validate the structure before passing anything on. The document's handler
+			// does not check anything itself and would corrupt its stack on bad data.
+			if (stack.Size() == 0)
+			{
+				if (tag != BST_StartObject && tag != BST_StartArray) return false;
+			}
+			else if (stack.Last().isobject && stack.Last().expectkey)
+			{
+				if (!iskey && tag != BST_EndObject) return false;
+			}
+			else if (iskey || isend)
+			{
+				if (stack.Last().isobject || tag != BST_EndArray) return false;
+			}
+			if (!iskey && !isend && stack.Size() > 0)
+			{
+				stack.Last().count++;
+				stack.Last().expectkey = true;
+			}
+
+			const char *str;
+			unsigned len;
+			uint64_t v;
+
+			switch (tag)
+			{
+			case BST_Null:
+				h.Null();
+				break;
+
+			case BST_False:
+			case BST_True:
+				h.Bool(tag == BST_True);
+				break;
+
+			case BST_Int:
+				if (!Varint(v)) return false;
+				h.Int64(int64_t(v >> 1) ^ -int64_t(v & 1));
+				break;
+
+			case BST_Uint:
+				if (!Varint(v)) return false;
+				h.Uint64(v);
+				break;
+
+			case BST_Double:
+			{
+				if (end - p < 8) return false;
+				uint64_t bits = 0;
+				for (int i = 0; i < 8; i++) bits |= uint64_t(*p++) << (i * 8);
+				double d;
+				memcpy(&d, &bits, 8);
+				h.Double(d);
+				break;
+			}
+
+			case BST_String:
+				if (!Chars(str, len)) return false;
+				h.String(str, len, true);
+				break;
+
+			case BST_KeyNew:
+			case BST_KeyLiteral:
+				if (!Chars(str, len)) return false;
+				if (tag == BST_KeyNew) keys.Push(std::make_pair(str, len));
+				h.Key(str, len, true);
+				stack.Last().expectkey = false;
+				break;
+
+			case BST_KeyRef:
+				if (!Varint(v) || v >= keys.Size()) return false;
+				h.Key(keys[(unsigned)v].first, keys[(unsigned)v].second, true);
+				stack.Last().expectkey = false;
+				break;
+
+			case BST_StartObject:
+			case BST_StartArray:
+				if (tag == BST_StartObject) h.StartObject();
+				else h.StartArray();
+				stack.Push({ tag == BST_StartObject, true, 0 });
+				break;
+
+			case BST_EndObject:
+			case BST_EndArray:
+				if (tag == BST_EndObject) h.EndObject(stack.Last().count);
+				else h.EndArray(stack.Last().count);
+				stack.Pop();
+				if (stack.Size() == 0) return true;
+				break;
+
+			default:
+				return false;
+			}
+		}
+		return false;
+	}
+};
+
+bool ReadBinarySerializerData(rapidjson::Document &doc, const char *buffer, size_t length)
+{
+	if (!IsBinarySerializerData(buffer, length) || (uint8_t)buffer[sizeof(BinarySerializerMagic)] != BINARYSERIALIZER_VERSION)
+	{
+		return false;
+	}
+	FBinarySerializerReader reader;
+	reader.p = (const uint8_t*)buffer + sizeof(BinarySerializerMagic) + 1;
+	reader.end = (const uint8_t*)buffer + length;
+	doc.Populate(reader);
+	return doc.IsObject() || doc.IsArray();
+}
+
 //==========================================================================
 //
 //
 //
 //==========================================================================
 
-bool FSerializer::OpenWriter(bool pretty)
+bool FSerializer::OpenWriter(bool pretty, bool binary)
 {
 	if (w != nullptr || r != nullptr) return false;
 
 	mErrors = 0;
-	w = new FWriter(pretty);
+	w = new FWriter(pretty, binary);
 	BeginObject(nullptr);
 	return true;
 }
@@ -749,9 +916,9 @@ const char *FSerializer::GetOutput(unsigned *len)
 	EndObject();
 	if (len != nullptr)
 	{
-		*len = (unsigned)w->mOutString.GetSize();
+		*len = (unsigned)w->OutputSize();
 	}
-	return w->mOutString.GetString();
+	return w->OutputData();
 }
 
 //==========================================================================
@@ -760,22 +927,42 @@ const char *FSerializer::GetOutput(unsigned *len)
 //
 //==========================================================================
 
-FCompressedBuffer FSerializer::GetCompressedOutput()
+FCompressedBuffer FSerializer::GetCompressedOutput(bool compress)
 {
 	if (isReading()) return{ 0,0,0,0,0,nullptr };
 	FCompressedBuffer buff;
 	WriteObjects();
 	EndObject();
 	buff.filename = nullptr;
-	buff.mSize = (unsigned)w->mOutString.GetSize();
-	buff.mCRC32 = crc32(0, (const Bytef*)w->mOutString.GetString(), buff.mSize);
+	buff.mSize = (unsigned)w->OutputSize();
+	buff.mCompressedSize = buff.mSize;
+	buff.mMethod = METHOD_STORED;
+	buff.mCRC32 = 0;
+	buff.mBuffer = new char[buff.mSize + 1];
+	memcpy(buff.mBuffer, w->OutputData(), buff.mSize);
+	buff.mBuffer[buff.mSize] = 0;
+
+	if (compress) CompressBuffer(buff);
+	return buff;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void CompressBuffer(FCompressedBuffer &buff)
+{
+	if (buff.mMethod != METHOD_STORED) return;
+	buff.mCRC32 = crc32(0, (const Bytef*)buff.mBuffer, buff.mSize);
 
 	uint8_t *compressbuf = new uint8_t[buff.mSize+1];
 
 	z_stream stream;
 	int err;
 
-	stream.next_in = (Bytef *)w->mOutString.GetString();
+	stream.next_in = (Bytef *)buff.mBuffer;
 	stream.avail_in = (unsigned)buff.mSize;
 	stream.next_out = (Bytef*)compressbuf;
 	stream.avail_out = (unsigned)buff.mSize;
@@ -785,34 +972,24 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 
 	// create output in zip-compatible form as required by FCompressedBuffer
 	err = deflateInit2(&stream, 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
-	if (err != Z_OK)
-	{
-		goto error;
-	}
-
-	err = deflate(&stream, Z_FINISH);
-	if (err != Z_STREAM_END) 
-	{
-		deflateEnd(&stream);
-		goto error;
-	}
-	buff.mCompressedSize = stream.total_out;
-
-	err = deflateEnd(&stream);
 	if (err == Z_OK)
 	{
-		buff.mBuffer = new char[buff.mCompressedSize];
-		buff.mMethod = METHOD_DEFLATE;
-		memcpy(buff.mBuffer, compressbuf, buff.mCompressedSize);
-		delete[] compressbuf;
-		return buff;
+		err = deflate(&stream, Z_FINISH);
+		if (err != Z_STREAM_END)
+		{
+			deflateEnd(&stream);
+		}
+		else if (deflateEnd(&stream) == Z_OK)
+		{
+			buff.mCompressedSize = stream.total_out;
+			delete[] buff.mBuffer;
+			buff.mBuffer = new char[buff.mCompressedSize];
+			buff.mMethod = METHOD_DEFLATE;
+			memcpy(buff.mBuffer, compressbuf, buff.mCompressedSize);
+		}
 	}
-
-error:
-	memcpy(compressbuf, w->mOutString.GetString(), buff.mSize + 1);
-	buff.mCompressedSize = buff.mSize;
-	buff.mMethod = METHOD_STORED;
-	return buff;
+	// If compression failed the buffer is left as it is, i.e. uncompressed.
+	delete[] compressbuf;
 }
 
 //==========================================================================
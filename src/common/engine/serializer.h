@@ -84,7 +84,7 @@ public:
 		Close();
 	}
 	void SetUniqueSoundNames() { soundNamesAreUnique = true; }
-	bool OpenWriter(bool pretty = true);
+	bool OpenWriter(bool pretty = true, bool binary = false);	// binary output cannot be pretty.
 	bool OpenReader(const char *buffer, size_t length);
 	bool OpenReader(FileSys::FCompressedBuffer *input);
 	void Close();
@@ -98,7 +98,7 @@ public:
 	unsigned GetSize(const char *group);
 	const char *GetKey();
 	const char *GetOutput(unsigned *len = nullptr);
-	FileSys::FCompressedBuffer GetCompressedOutput();
+	FileSys::FCompressedBuffer GetCompressedOutput(bool compress = true);
 	// The sprite serializer is a special case because it is needed by the VM to handle its 'spriteid' type.
 	virtual FSerializer &Sprite(const char *key, int32_t &spritenum, int32_t *def);
 	// This is only needed by the type system.
@@ -422,6 +422,10 @@ inline SaveRecord::SaveRecord(const char* nm, void (*handler)(FSerializer& arc))
 	saveRecords.records.Push(this);
 }
 
+// Deflates an uncompressed buffer returned by GetCompressedOutput(false) and calculates its checksum.
+// This does not touch any global state so it may be called from a background thread.
+void CompressBuffer(FileSys::FCompressedBuffer &buff);
+
 FString DictionaryToString(const Dictionary &dict);
 Dictionary *DictionaryFromString(const FString &string);
 
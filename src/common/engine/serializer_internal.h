@@ -25,6 +25,131 @@ struct FJSONObject
 	}
 };
 
+//==========================================================================
+//
+// Compact binary alternative to the JSON text output.
+//
+// The stream is a sequence of tagged SAX events, i.e. it has the same
+// structure as the JSON it replaces and the reader turns it directly into
+// a JSON DOM, so the rest of the serializer cannot tell the difference.
+// Numbers are stored as varints or raw doubles so nothing needs to be
+// formatted or parsed. Keys are interned: each distinct key is written
+// once and afterward only referenced by its index.
+//
+//==========================================================================
+
+static const char BinarySerializerMagic[4] = { 'G', 'Z', 'S', 'B' };
+enum { BINARYSERIALIZER_VERSION = 1 };
+
+enum EBinarySerializerTag : uint8_t
+{
+	BST_Null,
+	BST_False,
+	BST_True,
+	BST_Int,			// zigzag encoded varint
+	BST_Uint,			// varint
+	BST_Double,			// 8 bytes, little endian
+	BST_String,			// varint length + characters
+	BST_KeyNew,			// varint length + characters, gets the next key index
+	BST_KeyRef,			// varint key index
+	BST_KeyLiteral,		// varint length + characters, not interned
+	BST_StartObject,
+	BST_EndObject,
+	BST_StartArray,
+	BST_EndArray,
+};
+
+struct FBinaryWriter
+{
+	TArray<uint8_t> mBuffer;
+	TMap<FString, unsigned> mKeyMap;	// key -> key index
+
+	FBinaryWriter()
+	{
+		mBuffer.Grow(65536);
+		Bytes(BinarySerializerMagic, 4);
+		mBuffer.Push(BINARYSERIALIZER_VERSION);
+	}
+
+	void Tag(EBinarySerializerTag tag)
+	{
+		mBuffer.Push(tag);
+	}
+
+	void Bytes(const char *k, size_t len)
+	{
+		if (len > 0) memcpy(&mBuffer[mBuffer.Reserve(len)], k, len);
+	}
+
+	void Varint(uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			mBuffer.Push(uint8_t(v | 0x80));
+			v >>= 7;
+		}
+		mBuffer.Push(uint8_t(v));
+	}
+
+	void Chars(EBinarySerializerTag tag, const char *k, size_t len)
+	{
+		Tag(tag);
+		Varint(len);
+		Bytes(k, len);
+	}
+
+	void Key(const char *k)
+	{
+		// Keys are looked up in a table private to this archive. Going through FName
+		// would add every key of every archive to the global name table.
+		FString key = k;
+		auto check = mKeyMap.CheckKey(key);
+		if (check == nullptr)
+		{
+			mKeyMap.Insert(key, mKeyMap.CountUsed());
+			Chars(BST_KeyNew, k, key.Len());
+		}
+		else
+		{
+			Tag(BST_KeyRef);
+			Varint(*check);
+		}
+	}
+
+	void String(const char *k)
+	{
+		Chars(BST_String, k, strlen(k));
+	}
+
+	void Bool(bool k)
+	{
+		Tag(k ? BST_True : BST_False);
+	}
+
+	void Int64(int64_t k)
+	{
+		Tag(BST_Int);
+		Varint((uint64_t(k) << 1) ^ uint64_t(k >> 63));
+	}
+
+	void Uint64(uint64_t k)
+	{
+		Tag(BST_Uint);
+		Varint(k);
+	}
+
+	void Double(double k)
+	{
+		uint64_t bits;
+		memcpy(&bits, &k, 8);
+		Tag(BST_Double);
+		for (int i = 0; i < 8; i++, bits >>= 8) mBuffer.Push(uint8_t(bits));
+	}
+};
+
+bool IsBinarySerializerData(const char *buffer, size_t length);
+bool ReadBinarySerializerData(rapidjson::Document &doc, const char *buffer, size_t length);
+
 //==========================================================================
 //
 // some wrapper stuff to keep the RapidJSON dependencies out of the global headers.
@@ -39,21 +164,27 @@ struct FWriter
 
 	Writer *mWriter1;
 	PrettyWriter *mWriter2;
+	FBinaryWriter *mWriter3;
 	TArray<bool> mInObject;
 	rapidjson::StringBuffer mOutString;
 	TArray<DObject *> mDObjects;
 	TMap<DObject *, int> mObjectMap;
 
-	FWriter(bool pretty)
+	FWriter(bool pretty, bool binary = false)
 	{
-		if (!pretty)
+		mWriter1 = nullptr;
+		mWriter2 = nullptr;
+		mWriter3 = nullptr;
+		if (binary)
+		{
+			mWriter3 = new FBinaryWriter;
+		}
+		else if (!pretty)
 		{
 			mWriter1 = new Writer(mOutString);
-			mWriter2 = nullptr;
 		}
 		else
 		{
-			mWriter1 = nullptr;
 			mWriter2 = new PrettyWriter(mOutString);
 		}
 	}
@@ -62,6 +193,19 @@ struct FWriter
 	{
 		if (mWriter1) delete mWriter1;
 		if (mWriter2) delete mWriter2;
+		if (mWriter3) delete mWriter3;
+	}
+
+	const char *OutputData() const
+	{
+		if (mWriter3) return (const char*)mWriter3->mBuffer.Data();
+		return mOutString.GetString();
+	}
+
+	size_t OutputSize() const
+	{
+		if (mWriter3) return mWriter3->mBuffer.Size();
+		return mOutString.GetSize();
 	}
 
 
@@ -74,36 +218,42 @@ struct FWriter
 	{
 		if (mWriter1) mWriter1->StartObject();
 		else if (mWriter2) mWriter2->StartObject();
+		else if (mWriter3) mWriter3->Tag(BST_StartObject);
 	}
 
 	void EndObject()
 	{
 		if (mWriter1) mWriter1->EndObject();
 		else if (mWriter2) mWriter2->EndObject();
+		else if (mWriter3) mWriter3->Tag(BST_EndObject);
 	}
 
 	void StartArray()
 	{
 		if (mWriter1) mWriter1->StartArray();
 		else if (mWriter2) mWriter2->StartArray();
+		else if (mWriter3) mWriter3->Tag(BST_StartArray);
 	}
 
 	void EndArray()
 	{
 		if (mWriter1) mWriter1->EndArray();
 		else if (mWriter2) mWriter2->EndArray();
+		else if (mWriter3) mWriter3->Tag(BST_EndArray);
 	}
 
 	void Key(const char *k)
 	{
 		if (mWriter1) mWriter1->Key(k);
 		else if (mWriter2) mWriter2->Key(k);
+		else if (mWriter3) mWriter3->Key(k);
 	}
 
 	void Null()
 	{
 		if (mWriter1) mWriter1->Null();
 		else if (mWriter2) mWriter2->Null();
+		else if (mWriter3) mWriter3->Tag(BST_Null);
 	}
 
 	void StringU(const char *k, bool encode)
@@ -111,6 +261,7 @@ struct FWriter
 		if (encode) k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void String(const char *k)
@@ -118,6 +269,7 @@ struct FWriter
 		k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void String(const char *k, int size)
@@ -125,36 +277,42 @@ struct FWriter
 		k = StringToUnicode(k, size);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mWriter3) mWriter3->String(k);
 	}
 
 	void Bool(bool k)
 	{
 		if (mWriter1) mWriter1->Bool(k);
 		else if (mWriter2) mWriter2->Bool(k);
+		else if (mWriter3) mWriter3->Bool(k);
 	}
 
 	void Int(int32_t k)
 	{
 		if (mWriter1) mWriter1->Int(k);
 		else if (mWriter2) mWriter2->Int(k);
+		else if (mWriter3) mWriter3->Int64(k);
 	}
 
 	void Int64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Int64(k);
 		else if (mWriter2) mWriter2->Int64(k);
+		else if (mWriter3) mWriter3->Int64(k);
 	}
 
 	void Uint(uint32_t k)
 	{
 		if (mWriter1) mWriter1->Uint(k);
 		else if (mWriter2) mWriter2->Uint(k);
+		else if (mWriter3) mWriter3->Uint64(k);
 	}
 
 	void Uint64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Uint64(k);
 		else if (mWriter2) mWriter2->Uint64(k);
+		else if (mWriter3) mWriter3->Uint64(k);
 	}
 
 	void Double(double k)
@@ -167,6 +325,10 @@ struct FWriter
 		{
 			mWriter2->Double(k);
 		}
+		else if (mWriter3)
+		{
+			mWriter3->Double(k);
+		}
 	}
 
 };
@@ -187,7 +349,8 @@ struct FReader
 
 	FReader(const char *buffer, size_t length)
 	{
-		mDoc.Parse(buffer, length);
+		if (IsBinarySerializerData(buffer, length)) ReadBinarySerializerData(mDoc, buffer, length);
+		else mDoc.Parse(buffer, length);
 		mObjects.Push(FJSONObject(&mDoc));
 	}
 
@@ -42,6 +42,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <functional>
+#include <memory>
 #include <vector>
 #include "fs_swap.h"
 
@@ -74,11 +75,13 @@ public:
 class FileReader;
 
 // an opaque memory buffer to the file's content. Can either own the memory or just point to an external buffer.
+// An external buffer may be kept alive by a shared reference, e.g. for data held by the lump cache.
 class FileData
 {
 	void* memory;
 	size_t length;
 	bool owned;
+	std::shared_ptr<const FileData> backing;
 
 public:
 	using value_type = uint8_t;
@@ -99,6 +102,13 @@ public:
 			owned = false;
 		}
 	}
+	FileData(std::shared_ptr<const FileData> shared)
+	{
+		memory = (void*)shared->data();
+		length = shared->size();
+		owned = false;
+		backing = std::move(shared);
+	}
 	uint8_t* writable() const { return owned? (uint8_t*)memory : nullptr; }
 	const void* data() const { return memory; }
 	size_t size() const { return length; }
@@ -110,6 +120,7 @@ public:
 		if (owned && memory) free(memory);
 		length = copy.length;
 		owned = copy.owned;
+		backing = copy.backing;
 		if (owned)
 		{
 			memory = malloc(length);
@@ -125,6 +136,7 @@ public:
 		length = copy.length;
 		owned = copy.owned;
 		memory = copy.memory;
+		backing = std::move(copy.backing);
 		copy.memory = nullptr;
 		copy.length = 0;
 		copy.owned = true;
@@ -147,6 +159,7 @@ public:
 		if (!owned) memory = nullptr;
 		length = len;
 		owned = true;
+		backing.reset();
 		memory = realloc(memory, length);
 		return memory;
 	}
@@ -156,6 +169,7 @@ public:
 		memory = (void*)mem;
 		length = len;
 		owned = false;
+		backing.reset();
 	}
 
 	void clear()
@@ -164,6 +178,7 @@ public:
 		memory = nullptr;
 		length = 0;
 		owned = true;
+		backing.reset();
 	}
 
 };
@@ -247,6 +262,7 @@ public:
 	}
 
 	bool OpenFile(const char *filename, Size start = 0, Size length = -1, bool buffered = false);
+	bool OpenFileMapped(const char *filename);	// map the entire file into memory, falls back to OpenFile if that's not possible
 	bool OpenFilePart(FileReader &parent, Size start, Size length);
 	bool OpenMemory(const void *mem, Size length);	// read directly from the buffer
 	bool OpenMemoryArray(FileData& data);	// take the given array
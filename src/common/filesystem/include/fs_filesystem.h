@@ -171,10 +171,12 @@ protected:
 
 	int IwadIndex = -1;
 	int MaxIwadIndex = -1;
+	int NextSkinNamespace = ns_firstskin;	// each skin gets a different number, assigned in load order.
 
 	StringPool* stringpool = nullptr;
 
 private:
+	void AddResourceFile(const char* filename, FResourceFile* resfile, FileReader& filereader, double time, LumpFilterInfo* filter, FileSystemMessageFunc Printf, FILE* hashfile);
 	void DeleteAll();
 	void MoveLumpsInFolder(const char *);
 
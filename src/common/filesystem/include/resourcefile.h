@@ -6,6 +6,7 @@
 #include <limits.h>
 #include <vector>
 #include <string>
+#include <mutex>
 #include "fs_files.h"
 #include "fs_decompress.h"
 
@@ -109,6 +110,20 @@ struct FResourceEntry
 
 void SetMainThread();
 
+// Process wide cache for the contents of compressed entries, so that reading one repeatedly doesn't decompress it each time.
+struct LumpCacheStats
+{
+	size_t Budget;
+	size_t Size;
+	size_t Entries;
+	uint64_t Hits;
+	uint64_t Misses;
+	uint64_t Evictions;
+};
+
+void SetLumpCacheBudget(size_t bytes);
+LumpCacheStats GetLumpCacheStats();
+
 class FResourceFile
 {
 public:
@@ -125,12 +140,15 @@ protected:
 	uint32_t NumLumps;
 	char Hash[48];
 	StringPool* stringpool;
+	bool SkinFile = false;	// all entries are in ns_firstskin until the file system assigns the skin its own namespace.
+	std::mutex EntryMutex;	// entries can be resolved from any thread that reads them.
 
 	// for archives that can contain directories
 	virtual void SetEntryAddress(uint32_t entry)
 	{
 		Entries[entry].Flags &= ~RESFF_NEEDFILESTART;
 	}
+	void ResolveEntryAddress(uint32_t entry);
 	bool IsFileInFolder(const char* const resPath);
 	void CheckEmbedded(uint32_t entry, LumpFilterInfo* lfi);
 
@@ -154,6 +172,7 @@ public:
 	uint32_t GetFirstEntry() const { return FirstLump; }
 	void SetFirstLump(uint32_t f) { FirstLump = f; }
 	const char* GetHash() const { return Hash; }
+	bool IsSkinFile() const { return SkinFile; }
 
 	int EntryCount() const { return NumLumps; }
 	int FindEntry(const char* name);
@@ -40,6 +40,8 @@
 #include "fs_findfile.h"
 #include "unicode.h"
 #include "critsec.h"
+#include "fs_lumpcache.h"
+#include "files_internal.h"
 #include <mutex>
 
 
@@ -117,10 +119,7 @@ struct C7zArchive
 
 	C7zArchive(FileReader &file) : ArchiveStream(file)
 	{
-		if (g_CrcTable[1] == 0)
-		{
-			CrcGenerateTable();
-		}
+		InitCrcTable();
 		file.Seek(0, FileReader::SeekSet);
 		LookToRead2_CreateVTable(&LookStream, false);
 		LookStream.realStream = &ArchiveStream.s;
@@ -319,11 +318,17 @@ FileData F7ZFile::Read(uint32_t entry)
 	FileData buffer;
 	if (entry < NumLumps && Entries[entry].Length > 0)
 	{
+		if (LumpCacheFind(this, entry, buffer)) return buffer;
+
 		auto p = buffer.allocate(Entries[entry].Length);
-		// There is no realistic way to keep multiple references to a 7z file open without massive overhead so to make this thread-safe a mutex is the only option.
-		std::lock_guard<FCriticalSection> lock(critsec);
-		SRes code = Archive->Extract((UInt32)Entries[entry].Position, (char*)p);
+		SRes code;
+		{
+			// There is no realistic way to keep multiple references to a 7z file open without massive overhead so to make this thread-safe a mutex is the only option.
+			std::lock_guard<FCriticalSection> lock(critsec);
+			code = Archive->Extract((UInt32)Entries[entry].Position, (char*)p);
+		}
 		if (code != SZ_OK) buffer.clear();
+		else buffer = LumpCacheAdd(this, entry, std::move(buffer));
 	}
 	return buffer;
 }
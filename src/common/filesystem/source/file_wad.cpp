@@ -348,8 +348,6 @@ void FWadFile::SetNamespace(const char *startmarker, const char *endmarker, name
 
 void FWadFile::SkinHack (FileSystemMessageFunc Printf)
 {
-	// this being static is not a problem. The only relevant thing is that each skin gets a different number.
-	static int namespc = ns_firstskin;
 	bool skinned = false;
 	bool hasmap = false;
 	uint32_t i;
@@ -366,11 +364,12 @@ void FWadFile::SkinHack (FileSystemMessageFunc Printf)
 				skinned = true;
 				uint32_t j;
 
+				// Archives may be opened on multiple threads, so the skin's own namespace is assigned when it gets added to the file system.
 				for (j = 0; j < NumLumps; j++)
 				{
-					Entries[j].Namespace = namespc;
+					Entries[j].Namespace = ns_firstskin;
 				}
-				namespc++;
+				SkinFile = true;
 			}
 		}
 		// needless to say, this check is entirely useless these days as map names can be more diverse..
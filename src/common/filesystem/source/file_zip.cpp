@@ -46,6 +46,8 @@
 namespace FileSys {
 	using namespace byteswap;
 
+extern thread_local bool mainThread;
+
 #define BUFREADCOMMENT (0x400)
 
 //-----------------------------------------------------------------------
@@ -341,9 +343,23 @@ FCompressedBuffer FZipFile::GetRawData(uint32_t entry)
 	{
 		auto& e = Entries[entry];
 		cbuf = { e.Length, e.CompressedSize, e.Method, e.CRC32, new char[e.CompressedSize] };
-		if (e.Flags & RESFF_NEEDFILESTART) SetEntryAddress(entry);
-		Reader.Seek(e.Position, FileReader::SeekSet);
-		Reader.Read(cbuf.mBuffer, e.CompressedSize);
+		ResolveEntryAddress(entry);
+		auto buf = Reader.GetBuffer();
+		if (buf != nullptr)
+		{
+			memcpy(cbuf.mBuffer, buf + e.Position, e.CompressedSize);
+		}
+		else if (!mainThread)
+		{
+			FileReader fr;
+			fr.OpenFile(FileName, e.Position, e.CompressedSize);
+			fr.Read(cbuf.mBuffer, e.CompressedSize);
+		}
+		else
+		{
+			Reader.Seek(e.Position, FileReader::SeekSet);
+			Reader.Read(cbuf.mBuffer, e.CompressedSize);
+		}
 	}
 	
 	return cbuf;
@@ -360,11 +376,28 @@ void FZipFile::SetEntryAddress(uint32_t entry)
 	// This file is inside a zip and has not been opened before.
 	// Position points to the start of the local file header, which we must
 	// read and skip so that we can get to the actual file data.
-	FZipLocalFileHeader localHeader;
+	// This is called with EntryMutex held, but the main thread uses the
+	// shared reader without locking, so other threads must not touch it.
+	FZipLocalFileHeader localHeader = {};
 	int skiplen;
 
-	Reader.Seek(Entries[entry].Position, FileReader::SeekSet);
-	Reader.Read(&localHeader, sizeof(localHeader));
+	auto buf = Reader.GetBuffer();
+	if (buf != nullptr)
+	{
+		if (Entries[entry].Position + sizeof(localHeader) <= (size_t)Reader.GetLength())
+			memcpy(&localHeader, buf + Entries[entry].Position, sizeof(localHeader));
+	}
+	else if (!mainThread)
+	{
+		FileReader fr;
+		fr.OpenFile(FileName, Entries[entry].Position, sizeof(localHeader));
+		fr.Read(&localHeader, sizeof(localHeader));
+	}
+	else
+	{
+		Reader.Seek(Entries[entry].Position, FileReader::SeekSet);
+		Reader.Read(&localHeader, sizeof(localHeader));
+	}
 	skiplen = LittleShort(localHeader.NameLength) + LittleShort(localHeader.ExtraLength);
 	Entries[entry].Position += sizeof(localHeader) + skiplen;
 	Entries[entry].Flags &= ~RESFF_NEEDFILESTART;
@@ -40,6 +40,18 @@
 #include <string.h>
 #include "files_internal.h"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace FileSys {
 	
 #ifdef _WIN32
@@ -171,6 +183,83 @@ private:
 	}
 };
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// maps an entire file into memory. Since this is a MemoryReader, anything
+// stored uncompressed can be accessed through GetBuffer without copying.
+//
+// The file is not locked against other programs. On Windows writes to it
+// are allowed just like with regular file access. On POSIX systems
+// truncating a mapped file while it is in use makes accessing the lost
+// pages raise SIGBUS, so files must not be truncated while the engine has
+// them open.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = nullptr;
+#endif
+
+public:
+	MappedFileReader()
+	{}
+
+	~MappedFileReader()
+	{
+#ifdef _WIN32
+		if (bufptr != nullptr) UnmapViewOfFile(bufptr);
+		if (hMapping != nullptr) CloseHandle(hMapping);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+#else
+		if (bufptr != nullptr) munmap((void*)bufptr, Length);
+#endif
+		bufptr = nullptr;
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		hFile = CreateFileW(toWide(filename).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || !CanMap(size.QuadPart)) return false;
+		hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (hMapping == nullptr) return false;
+		bufptr = (const char*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (bufptr == nullptr) return false;
+		Length = (ptrdiff_t)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || !CanMap(info.st_size))
+		{
+			close(fd);
+			return false;
+		}
+		void *mem = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);	// the mapping keeps its own reference to the file.
+		if (mem == MAP_FAILED) return false;
+		bufptr = (const char*)mem;
+		Length = (ptrdiff_t)info.st_size;
+#endif
+		FilePos = 0;
+		return true;
+	}
+
+private:
+	static bool CanMap(int64_t size)
+	{
+		// Empty files cannot be mapped and 32 bit builds must not burn their address space on large archives.
+		return size > 0 && (sizeof(void*) >= 8 || size <= 256 * 1024 * 1024);
+	}
+};
+
 //==========================================================================
 //
 // FileReaderRedirect
@@ -380,6 +469,20 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenFileMapped(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		// mapping is only an optimization, so try again with regular file access.
+		return OpenFile(filename);
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, start, length);
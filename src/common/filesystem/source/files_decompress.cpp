@@ -42,6 +42,7 @@
 #include <miniz.h>
 #include <bzlib.h>
 #include <algorithm>
+#include <mutex>
 #include <stdexcept>
 
 #include "fs_files.h"
@@ -97,6 +98,18 @@ void DecompressorBase::DecompressionError(const char *error, ...) const
 	}
 }
 
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void InitCrcTable()
+{
+	static std::once_flag crcinit;
+	std::call_once(crcinit, CrcGenerateTable);
+}
+
 ptrdiff_t DecompressorBase::Tell () const
 {
 	DecompressionError("Cannot get position of decompressor stream");
@@ -584,10 +597,7 @@ public:
 			return 0;
 		}
 
-		if (g_CrcTable[1] == 0)
-		{
-			CrcGenerateTable();
-		}
+		InitCrcTable();
 
 		int err;
 		Byte *next_out = (Byte *)buffer;
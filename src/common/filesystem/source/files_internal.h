@@ -88,5 +88,7 @@ public:
 		Length = buf.size();
 	}
 };
+// Sets up the CRC table used by the 7z and XZ decoders. Archives may be opened and read on multiple threads.
+void InitCrcTable();
 
 }
@@ -41,6 +41,12 @@
 #include <ctype.h>
 #include <string.h>
 #include <inttypes.h>
+#include <stdarg.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <thread>
 
 #include "resourcefile.h"
 #include "fs_filesystem.h"
@@ -54,6 +60,12 @@ namespace FileSys {
 
 #define NULL_INDEX		(0xffffffff)
 
+// Archives are mostly read from a single disk, so more threads than this won't help.
+static const size_t MaxOpenThreads = 8;
+
+// Below this the hash chains are built faster on a single thread.
+static const uint32_t MinParallelHashEntries = 16384;
+
 static void UpperCopy(char* to, const char* from)
 {
 	int i;
@@ -217,10 +229,130 @@ void FileSystem::DeleteAll ()
 		delete Files[i];
 	}
 	Files.clear();
+	NextSkinNamespace = ns_firstskin;
 	if (stringpool != nullptr) delete stringpool;
 	stringpool = nullptr;
 }
 
+//==========================================================================
+//
+// OpenArchive
+//
+// Opens a file or directory as a resource file.
+//
+//==========================================================================
+
+static FResourceFile* OpenArchive(const char* filename, FileReader& filereader, bool isopen, LumpFilterInfo* filter, FileSystemMessageFunc Printf, StringPool* sp)
+{
+	bool isdir = false;
+
+	if (!isopen)
+	{
+		// Does this exist? If so, is it a directory?
+		if (!FS_DirEntryExists(filename, &isdir))
+		{
+			if (Printf)
+			{
+				Printf(FSMessageLevel::Error, "%s: File or Directory not found\n", filename);
+				PrintLastError(Printf);
+			}
+			return nullptr;
+		}
+
+		if (!isdir)
+		{
+			if (!filereader.OpenFileMapped(filename))
+			{ // Didn't find file
+				if (Printf)
+				{
+					Printf(FSMessageLevel::Error, "%s: File not found\n", filename);
+					PrintLastError(Printf);
+				}
+				return nullptr;
+			}
+		}
+	}
+
+	if (!isdir)
+		return FResourceFile::OpenResourceFile(filename, filereader, false, filter, Printf, sp);
+	else
+		return FResourceFile::OpenDirectory(filename, filter, Printf, sp);
+}
+
+//==========================================================================
+//
+// OpenArchives
+//
+// Opens all the given files on multiple threads. Each archive gets its own
+// string pool because the shared one is not thread safe and all messages
+// are deferred so that they can be printed in load order afterward.
+//
+//==========================================================================
+
+struct DeferredMessage
+{
+	FSMessageLevel Level;
+	std::string Text;
+};
+
+struct OpenedArchive
+{
+	FResourceFile* ResFile = nullptr;
+	FileReader Reader;
+	double Time = 0;
+	std::vector<DeferredMessage> Messages;
+	std::exception_ptr Exception;
+};
+
+static thread_local std::vector<DeferredMessage>* DeferredMessages;
+
+static int DeferredPrintf(FSMessageLevel level, const char* fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	int len = vsnprintf(nullptr, 0, fmt, ap);
+	va_end(ap);
+	if (len <= 0) return 0;
+
+	std::string text(len, 0);
+	va_start(ap, fmt);
+	vsnprintf(&text[0], len + 1, fmt, ap);
+	va_end(ap);
+	DeferredMessages->push_back({ level, std::move(text) });
+	return len;
+}
+
+static void OpenArchives(const std::vector<std::string>& filenames, std::vector<OpenedArchive>& archives, LumpFilterInfo* filter, FileSystemMessageFunc Printf)
+{
+	std::atomic<size_t> next = { 0 };
+	auto work = [&]()
+	{
+		for (size_t i = next++; i < filenames.size(); i = next++)
+		{
+			auto& archive = archives[i];
+			DeferredMessages = &archive.Messages;
+			try
+			{
+				auto starttime = std::chrono::steady_clock::now();
+				archive.ResFile = OpenArchive(filenames[i].c_str(), archive.Reader, false, filter, Printf ? DeferredPrintf : nullptr, nullptr);
+				std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - starttime;
+				archive.Time = time.count();
+			}
+			catch (...)
+			{
+				archive.Exception = std::current_exception();
+			}
+			DeferredMessages = nullptr;
+		}
+	};
+
+	size_t numthreads = std::min<size_t>({ std::max(std::thread::hardware_concurrency(), 1u), MaxOpenThreads, filenames.size() });
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < numthreads; i++) threads.emplace_back(work);
+	work();
+	for (auto& thread : threads) thread.join();
+}
+
 //==========================================================================
 //
 // InitMultipleFiles
@@ -267,9 +399,24 @@ bool FileSystem::InitMultipleFiles (std::vector<std::string>& filenames, LumpFil
 		}
 	}
 
+	// Opening an archive and reading its directory does not depend on any other file, so this is done
+	// on multiple threads. Registering the lumps determines their numbering and must happen in load order.
+	std::vector<OpenedArchive> archives(filenames.size());
+	OpenArchives(filenames, archives, filter, Printf);
+
 	for(size_t i=0;i<filenames.size(); i++)
 	{
-		AddFile(filenames[i].c_str(), nullptr, filter, Printf, hashfile);
+		auto& archive = archives[i];
+		if (Printf)
+		{
+			for (auto& msg : archive.Messages) Printf(msg.Level, "%s", msg.Text.c_str());
+		}
+		if (archive.Exception)
+		{
+			for (size_t j = i + 1; j < archives.size(); j++) delete archives[j].ResFile;
+			std::rethrow_exception(archive.Exception);
+		}
+		AddResourceFile(filenames[i].c_str(), archive.ResFile, archive.Reader, archive.Time, filter, Printf, hashfile);
 
 		if (i == (unsigned)MaxIwadIndex) MoveLumpsInFolder("after_iwad/");
 		std::string path = "filter/%s";
@@ -329,62 +476,41 @@ int FileSystem::AddFromBuffer(const char* name, char* data, int size, int id, in
 
 void FileSystem::AddFile (const char *filename, FileReader *filer, LumpFilterInfo* filter, FileSystemMessageFunc Printf, FILE* hashfile)
 {
-	int startlump;
-	bool isdir = false;
 	FileReader filereader;
+	if (filer != nullptr) filereader = std::move(*filer);
 
-	if (filer == nullptr)
-	{
-		// Does this exist? If so, is it a directory?
-		if (!FS_DirEntryExists(filename, &isdir))
-		{
-			if (Printf)
-			{
-				Printf(FSMessageLevel::Error, "%s: File or Directory not found\n", filename);
-				PrintLastError(Printf);
-			}
-			return;
-		}
-
-		if (!isdir)
-		{
-			if (!filereader.OpenFile(filename))
-			{ // Didn't find file
-				if (Printf)
-				{
-					Printf(FSMessageLevel::Error, "%s: File not found\n", filename);
-					PrintLastError(Printf);
-				}
-				return;
-			}
-		}
-	}
-	else filereader = std::move(*filer);
-
-	startlump = NumEntries;
-
-	FResourceFile *resfile;
-
+	auto starttime = std::chrono::steady_clock::now();
+	auto resfile = OpenArchive(filename, filereader, filer != nullptr, filter, Printf, stringpool);
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - starttime;
+	AddResourceFile(filename, resfile, filereader, time.count(), filter, Printf, hashfile);
+}
 
-	if (!isdir)
-		resfile = FResourceFile::OpenResourceFile(filename, filereader, false, filter, Printf, stringpool);
-	else
-		resfile = FResourceFile::OpenDirectory(filename, filter, Printf, stringpool);
+//==========================================================================
+//
+// AddResourceFile
+//
+// Adds the lumps of an opened archive to the directory.
+//
+//==========================================================================
 
+void FileSystem::AddResourceFile(const char* filename, FResourceFile* resfile, FileReader& filereader, double time, LumpFilterInfo* filter, FileSystemMessageFunc Printf, FILE* hashfile)
+{
 	if (resfile != NULL)
 	{
 		if (Printf) 
-			Printf(FSMessageLevel::Message, "adding %s, %d lumps\n", filename, resfile->EntryCount());
+			Printf(FSMessageLevel::Message, "adding %s, %d lumps (%.1f ms)\n", filename, resfile->EntryCount(), time);
 
 		uint32_t lumpstart = (uint32_t)FileInfo.size();
 
 		resfile->SetFirstLump(lumpstart);
 		Files.push_back(resfile);
+		int skinnamespace = resfile->IsSkinFile() ? NextSkinNamespace++ : ns_hidden;
 		for (int i = 0; i < resfile->EntryCount(); i++)
 		{
 			FileInfo.resize(FileInfo.size() + 1);
 			FileSystem::LumpRecord* lump_p = &FileInfo.back();
 			lump_p->SetFromLump(resfile, i, (int)Files.size() - 1, stringpool);
+			if (skinnamespace != ns_hidden && lump_p->Namespace == ns_firstskin) lump_p->Namespace = skinnamespace;
 		}
 
 		for (int i = 0; i < resfile->EntryCount(); i++)
@@ -809,8 +935,6 @@ int FileSystem::GetFileFlags (int lump)
 
 void FileSystem::InitHashChains (void)
 {
-	unsigned int i, j;
-
 	NumEntries = (uint32_t)FileInfo.size();
 	Hashes.resize(8 * NumEntries);
 	// Mark all buckets as empty
@@ -825,34 +949,59 @@ void FileSystem::InitHashChains (void)
 	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
 
 
-	// Now set up the chains
-	for (i = 0; i < (unsigned)NumEntries; i++)
+	// Now set up the chains. The four sets are independent of each other so each can get its own thread,
+	// but every set must still be built in lump order so that later lumps come first in each chain.
+	auto buildchains = [&](int set)
 	{
-		j = MakeHash (FileInfo[i].shortName.String, 8) % NumEntries;
-		NextLumpIndex[i] = FirstLumpIndex[j];
-		FirstLumpIndex[j] = i;
-
-		// Do the same for the full paths
-		if (FileInfo[i].LongName[0] != 0)
+		for (uint32_t i = 0; i < NumEntries; i++)
 		{
-			j = MakeHash(FileInfo[i].LongName) % NumEntries;
-			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
-			FirstLumpIndex_FullName[j] = i;
-
-			std::string nameNoExt = FileInfo[i].LongName;
-			auto dot = nameNoExt.find_last_of('.');
-			auto slash = nameNoExt.find_last_of('/');
-			if ((dot > slash || slash == std::string::npos) && dot != std::string::npos) nameNoExt.resize(dot);
-
-			j = MakeHash(nameNoExt.c_str()) % NumEntries;
-			NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
-			FirstLumpIndex_NoExt[j] = i;
-
-			j = FileInfo[i].resourceId % NumEntries;
-			NextLumpIndex_ResId[i] = FirstLumpIndex_ResId[j];
-			FirstLumpIndex_ResId[j] = i;
-
+			uint32_t j;
+			if (set == 0)
+			{
+				j = MakeHash(FileInfo[i].shortName.String, 8) % NumEntries;
+				NextLumpIndex[i] = FirstLumpIndex[j];
+				FirstLumpIndex[j] = i;
+			}
+			// Do the same for the full paths
+			else if (FileInfo[i].LongName[0] != 0)
+			{
+				if (set == 1)
+				{
+					j = MakeHash(FileInfo[i].LongName) % NumEntries;
+					NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
+					FirstLumpIndex_FullName[j] = i;
+				}
+				else if (set == 2)
+				{
+					const char* name = FileInfo[i].LongName;
+					auto dot = strrchr(name, '.');
+					auto slash = strrchr(name, '/');
+					size_t len = (dot != nullptr && (slash == nullptr || dot > slash)) ? dot - name : SIZE_MAX;
+
+					j = MakeHash(name, len) % NumEntries;
+					NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
+					FirstLumpIndex_NoExt[j] = i;
+				}
+				else
+				{
+					j = FileInfo[i].resourceId % NumEntries;
+					NextLumpIndex_ResId[i] = FirstLumpIndex_ResId[j];
+					FirstLumpIndex_ResId[j] = i;
+				}
+			}
 		}
+	};
+
+	if (NumEntries < MinParallelHashEntries || std::thread::hardware_concurrency() < 2)
+	{
+		for (int set = 0; set < 4; set++) buildchains(set);
+	}
+	else
+	{
+		std::thread threads[3];
+		for (int set = 1; set < 4; set++) threads[set - 1] = std::thread(buildchains, set);
+		buildchains(0);
+		for (auto& thread : threads) thread.join();
 	}
 	FileInfo.shrink_to_fit();
 	Files.shrink_to_fit();
@@ -0,0 +1,179 @@
+/*
+** lumpcache.cpp
+** cache for the decompressed contents of resource file entries
+**
+**---------------------------------------------------------------------------
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "fs_lumpcache.h"
+#include "resourcefile.h"
+#include "critsec.h"
+
+namespace FileSys {
+
+//==========================================================================
+//
+// The cached data is shared with all FileData objects returned for it,
+// so evicting an entry only drops the cache's own reference.
+//
+//==========================================================================
+
+struct LumpCacheKey
+{
+	const FResourceFile* File;
+	uint32_t Entry;
+
+	bool operator==(const LumpCacheKey& other) const { return File == other.File && Entry == other.Entry; }
+};
+
+struct LumpCacheKeyHash
+{
+	size_t operator()(const LumpCacheKey& key) const { return std::hash<const void*>()(key.File) ^ (size_t(key.Entry) * 0x9E3779B97F4A7C15ull); }
+};
+
+struct LumpCacheNode
+{
+	LumpCacheKey Key;
+	std::shared_ptr<const FileData> Data;
+};
+
+class LumpCache
+{
+	FCriticalSection critsec;
+	std::list<LumpCacheNode> LRU;	// most recently used first
+	std::unordered_map<LumpCacheKey, std::list<LumpCacheNode>::iterator, LumpCacheKeyHash> Map;
+	LumpCacheStats Stats = { 64 * 1024 * 1024, 0, 0, 0, 0, 0 };
+
+	void Evict(size_t budget)
+	{
+		while (Stats.Size > budget && !LRU.empty())
+		{
+			auto& node = LRU.back();
+			Stats.Size -= node.Data->size();
+			Stats.Evictions++;
+			Map.erase(node.Key);
+			LRU.pop_back();
+		}
+		Stats.Entries = LRU.size();
+	}
+
+public:
+	bool Find(const FResourceFile* file, uint32_t entry, FileData& data)
+	{
+		std::lock_guard<FCriticalSection> lock(critsec);
+		auto it = Map.find({ file, entry });
+		if (it == Map.end()) return false;
+		LRU.splice(LRU.begin(), LRU, it->second);
+		data = FileData(it->second->Data);
+		Stats.Hits++;
+		return true;
+	}
+
+	FileData Add(const FResourceFile* file, uint32_t entry, FileData&& data)
+	{
+		std::lock_guard<FCriticalSection> lock(critsec);
+		Stats.Misses++;
+		// A single large entry should not be able to flush everything else.
+		if (data.size() == 0 || data.size() > Stats.Budget / 8 || Map.count({ file, entry }))
+		{
+			return std::move(data);
+		}
+		auto shared = std::make_shared<FileData>();
+		*shared = std::move(data);
+		Stats.Size += shared->size();
+		LRU.push_front({ { file, entry }, shared });
+		Map[{ file, entry }] = LRU.begin();
+		Evict(Stats.Budget);
+		return FileData(std::move(shared));
+	}
+
+	void Remove(const FResourceFile* file)
+	{
+		std::lock_guard<FCriticalSection> lock(critsec);
+		for (auto it = LRU.begin(); it != LRU.end();)
+		{
+			if (it->Key.File == file)
+			{
+				Stats.Size -= it->Data->size();
+				Map.erase(it->Key);
+				it = LRU.erase(it);
+			}
+			else ++it;
+		}
+		Stats.Entries = LRU.size();
+	}
+
+	void SetBudget(size_t bytes)
+	{
+		std::lock_guard<FCriticalSection> lock(critsec);
+		Stats.Budget = bytes;
+		Evict(bytes);
+	}
+
+	LumpCacheStats GetStats()
+	{
+		std::lock_guard<FCriticalSection> lock(critsec);
+		return Stats;
+	}
+};
+
+static LumpCache& GetLumpCache()
+{
+	// Resource files may be deleted during static destruction, so this must outlive them.
+	static LumpCache* cache = new LumpCache;
+	return *cache;
+}
+
+bool LumpCacheFind(const FResourceFile* file, uint32_t entry, FileData& data)
+{
+	return GetLumpCache().Find(file, entry, data);
+}
+
+FileData LumpCacheAdd(const FResourceFile* file, uint32_t entry, FileData&& data)
+{
+	return GetLumpCache().Add(file, entry, std::move(data));
+}
+
+void LumpCacheRemove(const FResourceFile* file)
+{
+	GetLumpCache().Remove(file);
+}
+
+void SetLumpCacheBudget(size_t bytes)
+{
+	GetLumpCache().SetBudget(bytes);
+}
+
+LumpCacheStats GetLumpCacheStats()
+{
+	return GetLumpCache().GetStats();
+}
+
+}
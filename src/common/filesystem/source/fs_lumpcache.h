@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+#include "fs_files.h"
+
+namespace FileSys {
+
+class FResourceFile;
+
+// Entries are identified by their resource file and index. All entries of a resource file must be removed before it gets deleted.
+bool LumpCacheFind(const FResourceFile* file, uint32_t entry, FileData& data);
+FileData LumpCacheAdd(const FResourceFile* file, uint32_t entry, FileData&& data);
+void LumpCacheRemove(const FResourceFile* file);
+
+}
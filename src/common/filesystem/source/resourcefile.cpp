@@ -44,6 +44,7 @@
 #include "fs_findfile.h"
 #include "fs_decompress.h"
 #include "wildcards.hpp"
+#include "fs_lumpcache.h"
 
 namespace FileSys {
 
@@ -181,7 +182,7 @@ FResourceFile *FResourceFile::OpenResourceFile(const char *filename, FileReader
 FResourceFile *FResourceFile::OpenResourceFile(const char *filename, bool containeronly, LumpFilterInfo* filter, FileSystemMessageFunc Printf, StringPool* sp)
 {
 	FileReader file;
-	if (!file.OpenFile(filename)) return nullptr;
+	if (!file.OpenFileMapped(filename)) return nullptr;
 	return DoOpenResourceFile(filename, file, containeronly, filter, Printf, sp);
 }
 
@@ -211,6 +212,7 @@ FResourceFile::FResourceFile(const char *filename, FileReader &r, StringPool* sp
 
 FResourceFile::~FResourceFile()
 {
+	LumpCacheRemove(this);
 	if (!stringpool->shared) delete stringpool;
 }
 
@@ -655,6 +657,22 @@ int FResourceFile::FindEntry(const char *name)
 }
 
 
+//==========================================================================
+//
+// Entries get resolved on first access, which can happen on any thread,
+// so the check and the update must not be interleaved with another one.
+//
+//==========================================================================
+
+void FResourceFile::ResolveEntryAddress(uint32_t entry)
+{
+	std::lock_guard<std::mutex> lock(EntryMutex);
+	if (Entries[entry].Flags & RESFF_NEEDFILESTART)
+	{
+		SetEntryAddress(entry);
+	}
+}
+
 //==========================================================================
 //
 // Caches a lump's content and increases the reference counter
@@ -664,12 +682,10 @@ int FResourceFile::FindEntry(const char *name)
 FileReader FResourceFile::GetEntryReader(uint32_t entry, int readertype, int readerflags)
 {
 	FileReader fr;
+	FileData cached;
 	if (entry < NumLumps)
 	{
-		if (Entries[entry].Flags & RESFF_NEEDFILESTART)
-		{
-			SetEntryAddress(entry);
-		}
+		ResolveEntryAddress(entry);
 		if (!(Entries[entry].Flags & RESFF_COMPRESSED))
 		{
 			auto buf = Reader.GetBuffer();
@@ -680,7 +696,8 @@ FileReader FResourceFile::GetEntryReader(uint32_t entry, int readertype, int rea
 			}
 			else
 			{
-				if (readertype == READER_SHARED && !mainThread)
+				// other threads must not move the shared reader's file position.
+				if (readertype != READER_NEW && !mainThread)
 					readertype = READER_NEW;
 				if (readertype == READER_SHARED)
 				{
@@ -698,10 +715,18 @@ FileReader FResourceFile::GetEntryReader(uint32_t entry, int readertype, int rea
 				}
 			}
 		}
+		else if (LumpCacheFind(this, entry, cached))
+		{
+			// the cached data is shared, so the reader can keep it alive.
+			fr.OpenMemoryArray(cached);
+		}
 		else
 		{
 			FileReader fri;
-			if (readertype == READER_NEW || !mainThread) fri.OpenFile(FileName, Entries[entry].Position, Entries[entry].CompressedSize);
+			auto buf = Reader.GetBuffer();
+			// a memory backed archive can feed the decompressor directly and is safe to share between threads.
+			if (buf != nullptr) fri.OpenMemory(buf + Entries[entry].Position, Entries[entry].CompressedSize);
+			else if (readertype == READER_NEW || !mainThread) fri.OpenFile(FileName, Entries[entry].Position, Entries[entry].CompressedSize);
 			else fri.OpenFilePart(Reader, Entries[entry].Position, Entries[entry].CompressedSize);
 			int flags = DCF_TRANSFEROWNER | DCF_EXCEPTIONS;
 			if (readertype == READER_CACHED) flags |= DCF_CACHED;
@@ -720,10 +745,19 @@ FileData FResourceFile::Read(uint32_t entry)
 		// if this is backed by a memory buffer, we can just return a reference to the backing store.
 		if (buf != nullptr)
 		{
+			ResolveEntryAddress(entry);
 			return FileData(buf + Entries[entry].Position, Entries[entry].Length, false);
 		}
 	}
 
+	if (entry < NumLumps && (Entries[entry].Flags & RESFF_COMPRESSED))
+	{
+		FileData data;
+		if (LumpCacheFind(this, entry, data)) return data;
+		auto fr = GetEntryReader(entry, READER_SHARED, 0);
+		return LumpCacheAdd(this, entry, fr.Read(Entries[entry].Length));
+	}
+
 	auto fr = GetEntryReader(entry, READER_SHARED, 0);
 	return fr.Read(entry < NumLumps ? Entries[entry].Length : 0);
 }
@@ -266,18 +266,18 @@ private:
 
 	void *operator new(size_t len, nonew&)
 	{
-		return M_Calloc(len, 1);
+		return memset(GC::AllocObject(len), 0, len);
 	}
 public:
 
 	void operator delete (void *mem, nonew&)
 	{
-		M_Free(mem);
+		GC::FreeObject(mem);
 	}
 
 	void operator delete (void *mem)
 	{
-		M_Free(mem);
+		GC::FreeObject(mem);
 	}
 
 	// GC fiddling
@@ -344,7 +344,7 @@ protected:
 
 	void operator delete (void *mem, EInPlace *)
 	{
-		M_Free (mem);
+		GC::FreeObject (mem);
 	}
 
 	template<typename T, typename... Args>
@@ -56,6 +56,11 @@
 
 // HEADER FILES ------------------------------------------------------------
 
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
 #include "dobject.h"
 
 #include "c_dispatch.h"
@@ -63,6 +68,8 @@
 #include "stats.h"
 #include "printf.h"
 #include "cmdlib.h"
+#include "c_cvars.h"
+#include "ctpl.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -107,6 +114,21 @@
 // Cost of destroying an object
 #define GCDESTROYCOST		15
 
+// Steps smaller than this are never worth marking in parallel
+#define GCPARALLELMARKSIZE	(64*1024)
+
+// Number of gray objects a marking thread takes from the shared list at once
+#define GCGRAYCHUNK			32
+
+// Object pools hand out blocks in multiples of this size
+#define POOLGRANULARITY		32
+
+// Objects larger than this (including the pool header) are not pooled
+#define POOLMAXSIZE			8192
+
+// Minimum amount of memory to allocate for a new slab
+#define POOLSLABSIZE		65536
+
 // TYPES -------------------------------------------------------------------
 
 class FAveragizer
@@ -147,6 +169,12 @@ static size_t CalcStepSize();
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
+CUSTOM_CVAR(Int, gc_markthreads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > 16) self = 16;
+}
+
 namespace GC
 {
 size_t AllocBytes;
@@ -154,7 +182,7 @@ size_t RunningAllocBytes;
 size_t RunningDeallocBytes;
 size_t Threshold;
 size_t Estimate;
-DObject *Gray;
+thread_local DObject *Gray;
 DObject *Root;
 DObject *SoftRoots;
 DObject **SweepPos;
@@ -172,6 +200,40 @@ bool HadToDestroy;
 
 static FAveragizer AllocHistory;// Tracks allocation rate over time
 static cycle_t GCTime;			// Track time spent in GC
+static double MaxPause;			// Longest step in the current collection
+static double PrevMaxPause;		// Longest step in the previous collection
+
+// Parallel marking
+static thread_local DObject *GrayTail;	// Last object in this thread's gray list, valid while it is not empty
+static bool MarkingInParallel;
+static bool PointersPrepared;
+static ctpl::thread_pool MarkPool;	// no threads until the first parallel mark
+
+// Placed in front of every object so that FreeObject knows where it came from.
+struct alignas(16) FPoolHeader
+{
+	uint32_t SizeClass;
+};
+
+struct FPoolBlock
+{
+	FPoolBlock *Next;
+};
+
+struct FObjectPool
+{
+	FPoolBlock *FreeList;
+	size_t NumSlots;
+	size_t NumUsed;
+};
+
+enum { POOL_LARGE = ~0u };
+
+// Plain data so that objects can be allocated before static constructors have run.
+static FObjectPool ObjectPools[POOLMAXSIZE / POOLGRANULARITY];
+static size_t PoolUsedBytes;
+static size_t PoolReservedBytes;
+static size_t NumLargeObjects;
 
 // CODE --------------------------------------------------------------------
 
@@ -307,6 +369,53 @@ static size_t DestroyObjects(size_t count)
 	return bytes_destroyed;
 }
 
+//==========================================================================
+//
+// ClaimWhite
+//
+// Turns a white object gray. While several threads are marking, only one
+// of them may succeed, so the flags are updated atomically.
+//
+//==========================================================================
+
+static inline bool ClaimWhite(DObject *obj)
+{
+	if (!MarkingInParallel)
+	{
+		obj->White2Gray();
+		return true;
+	}
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomic flags must have the same layout");
+	auto flags = reinterpret_cast<std::atomic<uint32_t> *>(&obj->ObjectFlags);
+	uint32_t old = flags->load(std::memory_order_relaxed);
+	while (old & OF_WhiteBits)
+	{
+		if (flags->compare_exchange_weak(old, old & ~OF_WhiteBits))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//==========================================================================
+//
+// PushGray
+//
+// Adds an object to the calling thread's gray list.
+//
+//==========================================================================
+
+void PushGray(DObject *obj)
+{
+	if (Gray == nullptr)
+	{
+		GrayTail = obj;
+	}
+	obj->GCNext = Gray;
+	Gray = obj;
+}
+
 //==========================================================================
 //
 // Mark
@@ -326,11 +435,9 @@ void Mark(DObject **obj)
 		{
 			*obj = (DObject *)NULL;
 		}
-		else if (lobj->IsWhite())
+		else if (lobj->IsWhite() && ClaimWhite(lobj))
 		{
-			lobj->White2Gray();
-			lobj->GCNext = Gray;
-			Gray = lobj;
+			PushGray(lobj);
 		}
 	}
 }
@@ -384,6 +491,9 @@ static void MarkRoot()
 {
 	PrevStepStats = StepStats;
 	StepStats.Reset();
+	PrevMaxPause = MaxPause;
+	MaxPause = 0;
+	PointersPrepared = false;
 
 	Gray = nullptr;
 
@@ -440,6 +550,99 @@ static void SweepDone()
 	State = HadToDestroy ? GCS_Destroy : GCS_Done;
 }
 
+//==========================================================================
+//
+// PreparePointers
+//
+// The pointer tables of a class are built on first use, which must not
+// happen on several threads at once, so build all of them up front.
+//
+//==========================================================================
+
+static void PreparePointers()
+{
+	if (PointersPrepared) return;
+	for (auto cls : PClass::AllClasses)
+	{
+		cls->BuildFlatPointers();
+		cls->BuildArrayPointers();
+		cls->BuildMapPointers();
+	}
+	PointersPrepared = true;
+}
+
+//==========================================================================
+//
+// ParallelPropagate
+//
+// Propagates marks on gc_markthreads threads until at least lim bytes are
+// covered or no gray objects are left. The game is not running while this
+// happens, so the only thing the threads can conflict on is the gray
+// state of the objects themselves.
+//
+//==========================================================================
+
+static size_t ParallelPropagate(size_t lim, int numthreads)
+{
+	PreparePointers();
+
+	std::mutex sharedLock;
+	DObject *shared = Gray;
+	std::atomic<size_t> done{ 0 };
+
+	auto work = [&](int)
+	{
+		Gray = nullptr;
+		size_t did = 0;
+		while (done.load(std::memory_order_relaxed) < lim)
+		{
+			if (Gray == nullptr)
+			{
+				// Take the next chunk off the shared list.
+				std::lock_guard<std::mutex> lock(sharedLock);
+				if (shared == nullptr) break;
+				Gray = GrayTail = shared;
+				for (int i = 1; i < GCGRAYCHUNK && GrayTail->GCNext != nullptr; i++)
+				{
+					GrayTail = GrayTail->GCNext;
+				}
+				shared = GrayTail->GCNext;
+				GrayTail->GCNext = nullptr;
+			}
+			did += PropagateMark();
+			if (did >= 4096)
+			{
+				done += did;
+				did = 0;
+			}
+		}
+		done += did;
+		if (Gray != nullptr)
+		{
+			// Give back what is left.
+			std::lock_guard<std::mutex> lock(sharedLock);
+			GrayTail->GCNext = shared;
+			shared = Gray;
+			Gray = nullptr;
+		}
+	};
+
+	if (MarkPool.size() < numthreads - 1) MarkPool.resize(numthreads - 1);
+
+	MarkingInParallel = true;
+	std::vector<std::future<void>> futures(numthreads - 1);
+	for (int i = 0; i < numthreads - 1; i++)
+	{
+		futures[i] = MarkPool.push(work);
+	}
+	work(0);
+	for (auto &f : futures) f.wait();
+	MarkingInParallel = false;
+
+	Gray = shared;
+	return done;
+}
+
 //==========================================================================
 //
 // SingleStep
@@ -521,9 +724,14 @@ void Step()
 	size_t did = 0;
 	size_t lim = CalcStepSize();
 
+	// Marking is spread over several threads only after all classes have
+	// been finalized, since their pointer tables cannot change afterward.
+	int markthreads = gc_markthreads;
+	bool parallel = markthreads > 1 && lim >= GCPARALLELMARKSIZE && PClass::bVMOperational && !PClass::bShutdown && !FinalGC;
+
 	do
 	{
-		size_t done = SingleStep();
+		size_t done = parallel && State == GCS_Propagate && Gray != nullptr ? ParallelPropagate(lim, markthreads) : SingleStep();
 		did += done;
 		if (done < lim)
 		{
@@ -550,6 +758,7 @@ void Step()
 	StepStats.Clock[enter_state].Unclock();
 	StepStats.BytesCovered[enter_state] += did;
 	GCTime.Unclock();
+	MaxPause = std::max(MaxPause, GCTime.TimeMS());
 }
 
 //==========================================================================
@@ -612,8 +821,7 @@ void Barrier(DObject *pointing, DObject *pointed)
 	if (State == GCS_Propagate)
 	{
 		pointed->White2Gray();
-		pointed->GCNext = Gray;
-		Gray = pointed;
+		PushGray(pointed);
 	}
 	// In other states, we can mark the pointing object white so this
 	// barrier won't be triggered again, saving a few cycles in the future.
@@ -708,6 +916,106 @@ void DelSoftRoot(DObject *obj)
 	}
 }
 
+//==========================================================================
+//
+// FillPool
+//
+// Adds a new slab of blocks to a pool's free list.
+//
+//==========================================================================
+
+static void FillPool(FObjectPool &pool, size_t blocksize)
+{
+	size_t count = std::max<size_t>(POOLSLABSIZE / blocksize, 8);
+	uint8_t *slab = (uint8_t *)malloc(count * blocksize);
+	if (slab == nullptr)
+	{
+		I_FatalError("Could not allocate %zu bytes for object pool", count * blocksize);
+	}
+	for (size_t i = count; i-- > 0; )
+	{
+		auto block = (FPoolBlock *)(slab + i * blocksize);
+		block->Next = pool.FreeList;
+		pool.FreeList = block;
+	}
+	pool.NumSlots += count;
+	PoolReservedBytes += count * blocksize;
+}
+
+//==========================================================================
+//
+// AllocObject
+//
+// Objects are carved out of slabs, one pool per size class. Freed blocks
+// go to the front of their pool's free list, so newly spawned objects
+// reuse the most recently released and most likely still cached memory.
+// Slabs are never returned to the system.
+//
+//==========================================================================
+
+void *AllocObject(size_t size)
+{
+	size_t blocksize = size + sizeof(FPoolHeader);
+	FPoolHeader *header;
+
+	if (blocksize > POOLMAXSIZE)
+	{
+		header = (FPoolHeader *)M_Malloc(blocksize);
+		header->SizeClass = POOL_LARGE;
+		NumLargeObjects++;
+	}
+	else
+	{
+		unsigned sizeclass = unsigned((blocksize - 1) / POOLGRANULARITY);
+		auto &pool = ObjectPools[sizeclass];
+		blocksize = (sizeclass + 1) * POOLGRANULARITY;
+
+		if (pool.FreeList == nullptr)
+		{
+			FillPool(pool, blocksize);
+		}
+		header = (FPoolHeader *)pool.FreeList;
+		pool.FreeList = pool.FreeList->Next;
+		pool.NumUsed++;
+		header->SizeClass = sizeclass;
+		PoolUsedBytes += blocksize;
+		ReportAlloc(blocksize);
+	}
+	return header + 1;
+}
+
+//==========================================================================
+//
+// FreeObject
+//
+//==========================================================================
+
+void FreeObject(void *mem)
+{
+	if (mem == nullptr)
+	{
+		return;
+	}
+	FPoolHeader *header = (FPoolHeader *)mem - 1;
+	if (header->SizeClass == POOL_LARGE)
+	{
+		NumLargeObjects--;
+		M_Free(header);
+	}
+	else
+	{
+		auto &pool = ObjectPools[header->SizeClass];
+		size_t blocksize = (header->SizeClass + 1) * POOLGRANULARITY;
+		auto block = (FPoolBlock *)header;
+
+		block->Next = pool.FreeList;
+		pool.FreeList = block;
+		pool.NumUsed--;
+		PoolUsedBytes -= blocksize;
+		ReportDealloc(blocksize);
+	}
+}
+
 }
 
 //==========================================================================
@@ -787,6 +1095,13 @@ ADD_STAT(gc)
 		(GC::AllocBytes + 1023) >> 10,
 		(GC::Estimate + 1023) >> 10,
 		(GC::Threshold + 1023) >> 10);
+	out.AppendFormat("\nPause: %.2fms max (%.2fms in last collection)  Mark threads: %d",
+		GC::MaxPause, GC::PrevMaxPause, std::max<int>(gc_markthreads, 1));
+	out.AppendFormat("\nPools: %6zuK of %6zuK in use (%3.0f%%)  Large objects: %zu",
+		(GC::PoolUsedBytes + 1023) >> 10,
+		(GC::PoolReservedBytes + 1023) >> 10,
+		GC::PoolReservedBytes > 0 ? GC::PoolUsedBytes * 100. / GC::PoolReservedBytes : 0.,
+		GC::NumLargeObjects);
 	return out;
 }
 
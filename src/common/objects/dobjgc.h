@@ -56,8 +56,8 @@ namespace GC
 	// Amount of memory to allocate before triggering a collection.
 	extern size_t Threshold;
 
-	// List of gray objects.
-	extern DObject *Gray;
+	// List of gray objects. Each thread that is marking has its own.
+	extern thread_local DObject *Gray;
 
 	// List of every object.
 	extern DObject *Root;
@@ -130,6 +130,9 @@ namespace GC
 		Threshold = AllocBytes;
 	}
 
+	// Adds a gray object to the calling thread's gray list.
+	void PushGray(DObject *obj);
+
 	// Marks a white object gray. If the object wants to die, the pointer
 	// is NULLed instead.
 	void Mark(DObject **obj);
@@ -175,6 +178,12 @@ namespace GC
 	using GCMarkerFunc = void(*)();
 	void AddMarkerFunc(GCMarkerFunc func);
 
+	// Allocates memory for an object from the size-class pools.
+	void *AllocObject(size_t size);
+
+	// Returns memory obtained from AllocObject.
+	void FreeObject(void *mem);
+
 	// Report an allocation to the GC
 	static inline void ReportAlloc(size_t alloc)
 	{
@@ -7377,45 +7377,70 @@ FxExpression *FxCVar::Resolve(FCompileContext &ctx)
 	return this;
 }
 
+void *FxCVar::ValueAddress(FBaseCVar *cvar)
+{
+	switch (cvar->GetRealType())
+	{
+	case CVAR_Int:
+		return &static_cast<FIntCVar *>(cvar)->Value;
+
+	case CVAR_Color:
+		return &static_cast<FColorCVar *>(cvar)->Value;
+
+	case CVAR_Float:
+		return &static_cast<FFloatCVar *>(cvar)->Value;
+
+	case CVAR_Bool:
+		return &static_cast<FBoolCVar *>(cvar)->Value;
+
+	case CVAR_String:
+		return &static_cast<FStringCVar *>(cvar)->mValue;
+
+	case CVAR_Flag:
+		return &static_cast<FFlagCVar *>(cvar)->ValueVar.Value;
+
+	case CVAR_Mask:
+		return &static_cast<FMaskCVar *>(cvar)->ValueVar.Value;
+
+	default:
+		return nullptr;
+	}
+}
+
 ExpEmit FxCVar::Emit(VMFunctionBuilder *build)
 {
 	ExpEmit dest(build, CVar->GetRealType() == CVAR_String ? REGT_STRING : ValueType->GetRegType());
 	ExpEmit addr(build, REGT_POINTER);
 	int nul = build->GetConstantInt(0);
+	void *pVal = ValueAddress(CVar);
+	if (pVal != nullptr)
+	{
+		// remember where this address came from so that the compiled code can be relocated by the script cache.
+		build->ConstantCVars[pVal] = CVar;
+		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(pVal));
+	}
 	switch (CVar->GetRealType())
 	{
 	case CVAR_Int:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FIntCVar *>(CVar)->Value));
-		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
-		break;
-
 	case CVAR_Color:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FColorCVar *>(CVar)->Value));
 		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_Float:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FFloatCVar *>(CVar)->Value));
 		build->Emit(OP_LSP, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_Bool:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FBoolCVar *>(CVar)->Value));
 		build->Emit(OP_LBU, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_String:
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&static_cast<FStringCVar *>(CVar)->mValue));
 		build->Emit(OP_LS, dest.RegNum, addr.RegNum, nul);
 		break;
 
 	case CVAR_Flag:
 	{
-		int *pVal;
 		auto cv = static_cast<FFlagCVar *>(CVar);
-		auto vcv = &cv->ValueVar;
-		pVal = &vcv->Value;
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(pVal));
 		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
 		build->Emit(OP_SRL_RI, dest.RegNum, dest.RegNum, cv->BitNum);
 		build->Emit(OP_AND_RK, dest.RegNum, dest.RegNum, build->GetConstantInt(1));
@@ -7425,7 +7450,6 @@ ExpEmit FxCVar::Emit(VMFunctionBuilder *build)
 	case CVAR_Mask:
 	{
 		auto cv = static_cast<FMaskCVar *>(CVar);
-		build->Emit(OP_LKP, addr.RegNum, build->GetConstantAddress(&cv->ValueVar.Value));
 		build->Emit(OP_LW, dest.RegNum, addr.RegNum, nul);
 		build->Emit(OP_AND_RK, dest.RegNum, dest.RegNum, build->GetConstantInt(cv->BitVal));
 		build->Emit(OP_SRL_RI, dest.RegNum, dest.RegNum, cv->BitNum);
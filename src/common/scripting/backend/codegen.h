@@ -1462,6 +1462,7 @@ public:
 	FxCVar(FBaseCVar*, const FScriptPosition&);
 	FxExpression *Resolve(FCompileContext&);
 	ExpEmit Emit(VMFunctionBuilder *build);
+	static void *ValueAddress(FBaseCVar *cvar);
 };
 
 
@@ -38,6 +38,7 @@
 #include "c_cvars.h"
 #include "jit.h"
 #include "filesystem.h"
+#include "vmcache.h"
 
 CVAR(Bool, strictdecorate, false, CVAR_GLOBALCONFIG | CVAR_ARCHIVE)
 
@@ -838,6 +839,7 @@ VMFunction *FFunctionBuildList::AddFunction(PNamespace *gnspc, const VersionInfo
 void FFunctionBuildList::Build()
 {
 	VMDisassemblyDumper disasmdump(VMDisassemblyDumper::Overwrite);
+	FScriptCache cache;
 
 	for (auto &item : mItems)
 	{
@@ -847,6 +849,28 @@ void FFunctionBuildList::Build()
 
 		assert(item.Code != NULL);
 
+		// If the function is in the cache, nothing needs to be generated.
+		if (cache.Restore(item.Function, item.Func, item.PrintableName))
+		{
+			disasmdump.Write(item.Function, item.PrintableName);
+			#if HAVE_VM_JIT
+				if(vm_jit && vm_jit_aot)
+				{
+					try
+					{
+						item.Function->JitCompile();
+					}
+					catch (CRecoverableError &err)
+					{
+						item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", err.GetMessage(), item.PrintableName.GetChars());
+					}
+				}
+			#endif
+			delete item.Code;
+			disasmdump.Flush();
+			continue;
+		}
+
 		// We don't know the return type in advance for anonymous functions.
 		FCompileContext ctx(item.CurGlobals, item.Func, item.Func->SymbolName == NAME_None ? nullptr : item.Func->Variants[0].Proto, item.FromDecorate, item.StateIndex, item.StateCount, item.Lump, item.Version);
 
@@ -889,6 +913,7 @@ void FFunctionBuildList::Build()
 			if (item.Proto == nullptr)
 			{
 				item.Code->ScriptPosition.Message(MSG_ERROR, "Function %s without prototype", item.PrintableName.GetChars());
+				cache.Skip(item.PrintableName);
 				continue;
 			}
 
@@ -938,13 +963,16 @@ void FFunctionBuildList::Build()
 						sfunc->JitCompile();
 					}
 				#endif
+				cache.Store(sfunc, item.Func, item.PrintableName, buildit);
 			}
 			catch (CRecoverableError &err)
 			{
 				// catch errors from the code generator and pring something meaningful.
 				item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", err.GetMessage(), item.PrintableName.GetChars());
+				cache.Skip(item.PrintableName);
 			}
 		}
+		else cache.Skip(item.PrintableName);
 		delete item.Code;
 		disasmdump.Flush();
 	}
@@ -953,6 +981,7 @@ void FFunctionBuildList::Build()
 
 	if (FScriptPosition::ErrorCounter == 0)
 	{
+		cache.Save();
 		if (Args->CheckParm("-dumpjit")) DumpJit(true);
 		else if (Args->CheckParm("-dumpjitmod")) DumpJit(false);
 	}
@@ -1118,6 +1147,7 @@ ExpEmit FunctionCallEmitter::EmitCall(VMFunctionBuilder *build, TArray<ExpEmit>
 		// It would really be nicer to actually pass real types but that'd require a far more complex interface on the compiler side than what we have.
 		uint8_t *regbuffer = (uint8_t*)ClassDataAllocator.Alloc(reginfo.Size());	// Allocate in the arena so that the pointer does not need to be maintained.
 		memcpy(regbuffer, reginfo.Data(), reginfo.Size());
+		build->ConstantBlobs[regbuffer] = reginfo.Size();
 		build->Emit(OP_PARAM, REGT_POINTER | REGT_KONST, build->GetConstantAddress(regbuffer));
 		paramcount++;
 	}
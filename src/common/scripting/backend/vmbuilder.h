@@ -7,6 +7,7 @@
 #include <functional>
 
 class VMFunctionBuilder;
+class FBaseCVar;
 class FxExpression;
 class FxLocalVariableDeclaration;
 
@@ -110,6 +111,10 @@ public:
 	ExpEmit FramePointer;
 	TArray<FxLocalVariableDeclaration *> ConstructedStructs;
 
+	// Origin of address constants that point to data which is not owned by a type, class or function, so that the script cache can relocate them.
+	TMap<void *, unsigned> ConstantBlobs;		// arena allocated data and its size.
+	TMap<void *, FBaseCVar *> ConstantCVars;	// a CVar's value storage.
+
 private:
 	TArray<FStatementInfo> LineNumbers;
 	TArray<FxExpression *> StatementStack;
@@ -0,0 +1,886 @@
+/*
+** vmcache.cpp
+** On-disk cache for compiled script functions
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "vmcache.h"
+#include "vmbuilder.h"
+#include "codegen.h"
+#include "c_cvars.h"
+#include "filesystem.h"
+#include "cmdlib.h"
+#include "md5.h"
+#include "i_specialpaths.h"
+#include "texturemanager.h"
+#include "printf.h"
+#include "version.h"
+#include <memory>
+
+CVAR(Bool, vm_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+EXTERN_CVAR(Bool, vm_jit)
+EXTERN_CVAR(Bool, strictdecorate)
+
+FScriptCacheHooks ScriptCacheHooks;
+
+static const char *ScriptCacheMagic = "ZSCC";
+enum { SCRIPTCACHE_VERSION = 2 };
+
+static MD5Context SourceHash;
+static bool SourceHashActive = true;
+
+// Relocation records for address constants.
+enum
+{
+	RELOC_Raw,			// null or a small integer disguised as a pointer (e.g. a field offset)
+	RELOC_Function,		// index into VMFunction::AllFunctions
+	RELOC_Class,		// class name
+	RELOC_CVar,			// a CVar's value
+	RELOC_Blob,			// arena allocated data, stored inline
+	RELOC_TextureCount,	// the texture manager's texture count
+	RELOC_Hook,			// game specific data, see ScriptCacheHooks
+};
+
+// Type records.
+enum
+{
+	TREC_Basic,
+	TREC_Class,
+	TREC_Struct,
+	TREC_Enum,
+	TREC_Pointer,
+	TREC_ClassPointer,
+	TREC_StaticArray,
+	TREC_Array,
+	TREC_DynArray,
+	TREC_Map,
+	TREC_MapIterator,
+
+	OUTER_Namespace = 0,
+	OUTER_Type,
+};
+
+//==========================================================================
+//
+// VMCache_AddSource
+//
+// Everything the scanner reads before the functions get built contributes
+// to the cache key. This is a superset of what really matters but it is
+// cheap and cannot miss an included file.
+//
+//==========================================================================
+
+void VMCache_AddSource(const void *data, size_t length)
+{
+	if (SourceHashActive)
+	{
+		SourceHash.Update((const uint8_t *)data, (unsigned)length);
+	}
+}
+
+//==========================================================================
+//
+// VMCache_BeginSources
+//
+// Must be called before the scripts get read, on every init, because the
+// hash gets finalized by the cache that is created after compiling them.
+//
+//==========================================================================
+
+void VMCache_BeginSources()
+{
+	SourceHash.Init();
+	SourceHashActive = true;
+}
+
+//==========================================================================
+//
+// serialization helpers
+//
+//==========================================================================
+
+struct FCacheWriter
+{
+	TArray<uint8_t> &Out;
+
+	FCacheWriter(TArray<uint8_t> &out) : Out(out) {}
+
+	void Bytes(const void *data, size_t len)
+	{
+		if (len > 0)
+		{
+			auto pos = Out.Reserve((unsigned)len);
+			memcpy(&Out[pos], data, len);
+		}
+	}
+	void UInt8(uint8_t v) { Bytes(&v, 1); }
+	void UInt16(uint16_t v) { Bytes(&v, 2); }
+	void UInt32(uint32_t v) { Bytes(&v, 4); }
+	void UInt64(uint64_t v) { Bytes(&v, 8); }
+	void String(const char *s)
+	{
+		auto len = (uint32_t)strlen(s);
+		UInt32(len);
+		Bytes(s, len);
+	}
+};
+
+struct FCacheReader
+{
+	const uint8_t *Pos, *End;
+	bool Error = false;
+
+	FCacheReader(const uint8_t *data, size_t len) : Pos(data), End(data + len) {}
+
+	bool Bytes(void *data, size_t len)
+	{
+		if (Error || (size_t)(End - Pos) < len)
+		{
+			Error = true;
+			if (len > 0) memset(data, 0, len);
+			return false;
+		}
+		if (len > 0) memcpy(data, Pos, len);
+		Pos += len;
+		return true;
+	}
+	uint8_t UInt8() { uint8_t v; Bytes(&v, 1); return v; }
+	uint16_t UInt16() { uint16_t v; Bytes(&v, 2); return v; }
+	uint32_t UInt32() { uint32_t v; Bytes(&v, 4); return v; }
+	uint64_t UInt64() { uint64_t v; Bytes(&v, 8); return v; }
+	FString String()
+	{
+		uint32_t len = UInt32();
+		if (Error || (size_t)(End - Pos) < len)
+		{
+			Error = true;
+			return "";
+		}
+		FString s((const char *)Pos, len);
+		Pos += len;
+		return s;
+	}
+};
+
+//==========================================================================
+//
+// Types are stored structurally because the type table is hashed by
+// pointer values and does not have a stable order.
+//
+//==========================================================================
+
+static PType **BasicTypes[] =
+{
+	(PType**)&TypeVoid, (PType**)&TypeSInt8, (PType**)&TypeUInt8, (PType**)&TypeSInt16, (PType**)&TypeUInt16,
+	(PType**)&TypeSInt32, (PType**)&TypeUInt32, (PType**)&TypeBool, (PType**)&TypeFloat32, (PType**)&TypeFloat64,
+	(PType**)&TypeString, (PType**)&TypeName, (PType**)&TypeSound, (PType**)&TypeColor, (PType**)&TypeTextureID,
+	(PType**)&TypeTranslationID, (PType**)&TypeSpriteID, (PType**)&TypeVector2, (PType**)&TypeVector3, (PType**)&TypeVector4,
+	(PType**)&TypeFVector2, (PType**)&TypeFVector3, (PType**)&TypeFVector4, (PType**)&TypeQuaternion, (PType**)&TypeFQuaternion,
+	(PType**)&TypeColorStruct, (PType**)&TypeStringStruct, (PType**)&TypeQuaternionStruct, (PType**)&TypeState, (PType**)&TypeFont,
+	(PType**)&TypeStateLabel, (PType**)&TypeNullPtr, (PType**)&TypeVoidPtr, (PType**)&TypeRawFunction, (PType**)&TypeVMFunction,
+};
+
+static bool WriteType(FCacheWriter &w, PType *type);
+
+static bool WriteOuter(FCacheWriter &w, PTypeBase *outer)
+{
+	auto &ns = Namespaces.AllNamespaces;
+	for (unsigned i = 0; i < ns.Size(); i++)
+	{
+		if (ns[i] == outer)
+		{
+			w.UInt8(OUTER_Namespace);
+			w.UInt32(i);
+			return true;
+		}
+	}
+	// Anything that is not a namespace must be a container type.
+	auto outertype = static_cast<PType *>(outer);
+	if (outer == nullptr || !outertype->isContainer()) return false;
+	w.UInt8(OUTER_Type);
+	return WriteType(w, outertype);
+}
+
+static bool WriteType(FCacheWriter &w, PType *type)
+{
+	if (type == nullptr) return false;
+	for (unsigned i = 0; i < countof(BasicTypes); i++)
+	{
+		if (*BasicTypes[i] == type)
+		{
+			w.UInt8(TREC_Basic);
+			w.UInt8(i);
+			return true;
+		}
+	}
+	if (type->isClass())
+	{
+		w.UInt8(TREC_Class);
+		w.String(static_cast<PClassType *>(type)->Descriptor->TypeName.GetChars());
+		return true;
+	}
+	if (type->isStruct())
+	{
+		auto stype = static_cast<PStruct *>(type);
+		w.UInt8(TREC_Struct);
+		w.String(stype->TypeName.GetChars());
+		return WriteOuter(w, stype->Outer);
+	}
+	if (type->isEnum())
+	{
+		auto etype = static_cast<PEnum *>(type);
+		w.UInt8(TREC_Enum);
+		w.String(etype->EnumName.GetChars());
+		return WriteOuter(w, etype->Outer);
+	}
+	if (type->isClassPointer())
+	{
+		w.UInt8(TREC_ClassPointer);
+		w.String(static_cast<PClassPointer *>(type)->ClassRestriction->TypeName.GetChars());
+		return true;
+	}
+	if (type->isRealPointer())
+	{
+		auto ptype = static_cast<PPointer *>(type);
+		w.UInt8(TREC_Pointer);
+		w.UInt8(ptype->IsConst);
+		return WriteType(w, ptype->PointedType);
+	}
+	if (type->isStaticArray())
+	{
+		w.UInt8(TREC_StaticArray);
+		return WriteType(w, static_cast<PStaticArray *>(type)->ElementType);
+	}
+	if (type->isArray())
+	{
+		auto atype = static_cast<PArray *>(type);
+		w.UInt8(TREC_Array);
+		w.UInt32(atype->ElementCount);
+		return WriteType(w, atype->ElementType);
+	}
+	if (type->isDynArray())
+	{
+		w.UInt8(TREC_DynArray);
+		return WriteType(w, static_cast<PDynArray *>(type)->ElementType);
+	}
+	if (type->isMap())
+	{
+		auto mtype = static_cast<PMap *>(type);
+		w.UInt8(TREC_Map);
+		return WriteType(w, mtype->KeyType) && WriteType(w, mtype->ValueType);
+	}
+	if (type->isMapIterator())
+	{
+		auto mtype = static_cast<PMapIterator *>(type);
+		w.UInt8(TREC_MapIterator);
+		return WriteType(w, mtype->KeyType) && WriteType(w, mtype->ValueType);
+	}
+	// function pointers and prototypes are not needed here.
+	return false;
+}
+
+static PClass *ReadClass(FCacheReader &r)
+{
+	FName name(r.String(), true);
+	return name == NAME_None ? nullptr : PClass::FindClass(name);
+}
+
+static PType *ReadType(FCacheReader &r);
+
+static PTypeBase *ReadOuter(FCacheReader &r)
+{
+	switch (r.UInt8())
+	{
+	case OUTER_Namespace:
+	{
+		unsigned index = r.UInt32();
+		return index < Namespaces.AllNamespaces.Size() ? Namespaces.AllNamespaces[index] : nullptr;
+	}
+	case OUTER_Type:
+		return ReadType(r);
+
+	default:
+		return nullptr;
+	}
+}
+
+static PType *ReadType(FCacheReader &r)
+{
+	int tag = r.UInt8();
+	if (r.Error) return nullptr;
+	switch (tag)
+	{
+	case TREC_Basic:
+	{
+		unsigned index = r.UInt8();
+		return index < countof(BasicTypes) ? *BasicTypes[index] : nullptr;
+	}
+
+	case TREC_Class:
+	{
+		auto cls = ReadClass(r);
+		return cls ? cls->VMType : nullptr;
+	}
+
+	case TREC_Struct:
+	case TREC_Enum:
+	{
+		// Only look up existing types here. Creating them would leave an incomplete type behind.
+		FName name(r.String(), true);
+		auto outer = ReadOuter(r);
+		if (name == NAME_None || outer == nullptr) return nullptr;
+		return TypeTable.FindType(tag == TREC_Struct ? NAME_Struct : NAME_Enum, (intptr_t)outer, name.GetIndex(), nullptr);
+	}
+
+	case TREC_Pointer:
+	{
+		bool isconst = !!r.UInt8();
+		auto pointed = ReadType(r);
+		return pointed ? NewPointer(pointed, isconst) : nullptr;
+	}
+
+	case TREC_ClassPointer:
+	{
+		auto cls = ReadClass(r);
+		return cls ? NewClassPointer(cls) : nullptr;
+	}
+
+	case TREC_StaticArray:
+	{
+		auto etype = ReadType(r);
+		return etype ? NewStaticArray(etype) : nullptr;
+	}
+
+	case TREC_Array:
+	{
+		unsigned count = r.UInt32();
+		auto etype = ReadType(r);
+		return etype ? NewArray(etype, count) : nullptr;
+	}
+
+	case TREC_DynArray:
+	{
+		auto etype = ReadType(r);
+		return etype ? NewDynArray(etype) : nullptr;
+	}
+
+	case TREC_Map:
+	case TREC_MapIterator:
+	{
+		auto ktype = ReadType(r);
+		auto vtype = ReadType(r);
+		if (ktype == nullptr || vtype == nullptr) return nullptr;
+		return tag == TREC_Map ? (PType *)NewMap(ktype, vtype) : (PType *)NewMapIterator(ktype, vtype);
+	}
+
+	default:
+		return nullptr;
+	}
+}
+
+//==========================================================================
+//
+// FScriptCache
+//
+//==========================================================================
+
+static FString ScriptCacheName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	if (create) CreatePath(path.GetChars());
+	path << "/scriptcache.zscc";
+	return path;
+}
+
+void *FScriptCache::TextureCountAddress()
+{
+	return &((FArray *)&TexMan.Textures)->Count;
+}
+
+FScriptCache::FScriptCache()
+{
+	FirstNewName = FName::GetNumNames();
+	Enabled = vm_cache;
+	if (Enabled)
+	{
+		CalcKey();
+		Loaded = Load();
+		if (!Loaded)
+		{
+			Data.Reset();
+			Entries.Reset();
+		}
+	}
+	SourceHashActive = false;
+}
+
+//==========================================================================
+//
+// The key covers everything that may change the generated code.
+//
+//==========================================================================
+
+void FScriptCache::CalcKey()
+{
+	MD5Context md5;
+	auto add = [&](const void *data, size_t len) { md5.Update((const uint8_t *)data, (unsigned)len); };
+	auto addstr = [&](const char *str) { add(str, strlen(str) + 1); };
+
+	const uint32_t header[] = { SCRIPTCACHE_VERSION, 0x01020304, (uint32_t)sizeof(void *), (uint32_t)sizeof(VMOP), NUM_OPS, (uint32_t)*vm_jit, (uint32_t)*strictdecorate };
+	add(header, sizeof(header));
+	addstr(GetVersionString());
+	addstr(GetGitHash());
+
+	int numlumps = fileSystem.GetNumEntries();
+	add(&numlumps, sizeof(numlumps));
+	for (int i = 0; i < numlumps; i++)
+	{
+		const int64_t lumpinfo[] = { (int64_t)fileSystem.FileLength(i), fileSystem.GetFileContainer(i), fileSystem.GetFileNamespace(i) };
+		add(lumpinfo, sizeof(lumpinfo));
+		addstr(fileSystem.GetFileFullName(i, false));
+	}
+
+	// The scripts have been completely read at this point.
+	uint8_t digest[16];
+	SourceHash.Final(digest);
+	SourceHashActive = false;
+	add(digest, 16);
+
+	// Names are stored as indices in the code so the name table must be identical.
+	int numnames = FName::GetNumNames();
+	add(&numnames, sizeof(numnames));
+	for (int i = 0; i < numnames; i++)
+	{
+		addstr(FName(ENamedName(i)).GetChars());
+	}
+
+	Key.Resize(16);
+	md5.Final(Key.Data());
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FScriptCache::Load()
+{
+	FileReader fr;
+	if (!fr.OpenFile(ScriptCacheName(false).GetChars())) return false;
+
+	Data.Resize((unsigned)fr.GetLength());
+	if (fr.Read(Data.Data(), Data.Size()) != (ptrdiff_t)Data.Size()) return false;
+
+	FCacheReader r(Data.Data(), Data.Size());
+	char magic[4];
+	uint8_t key[16];
+	r.Bytes(magic, 4);
+	uint32_t version = r.UInt32();
+	r.Bytes(key, 16);
+	if (r.Error || memcmp(magic, ScriptCacheMagic, 4) || version != SCRIPTCACHE_VERSION || memcmp(key, Key.Data(), 16)) return false;
+
+	// Recreate the names the compiler created so that the stored name constants remain valid.
+	int firstname = (int)r.UInt32();
+	unsigned numnames = r.UInt32();
+	if (r.Error || firstname != FirstNewName) return false;
+	for (unsigned i = 0; i < numnames; i++)
+	{
+		FString text = r.String();
+		if (r.Error || FName(text).GetIndex() != firstname + (int)i) return false;
+	}
+
+	unsigned numentries = r.UInt32();
+	for (unsigned i = 0; i < numentries && !r.Error; i++)
+	{
+		Entry &e = Entries[Entries.Reserve(1)];
+		e.Name = r.String();
+		e.Length = r.UInt32();
+		e.Offset = unsigned(r.Pos - Data.Data());
+		if ((size_t)(r.End - r.Pos) < e.Length) r.Error = true;
+		else r.Pos += e.Length;
+	}
+	return !r.Error;
+}
+
+//==========================================================================
+//
+// Restore
+//
+// Entries are stored in build order. Returns false if the function needs
+// to be compiled.
+//
+//==========================================================================
+
+bool FScriptCache::Restore(VMScriptFunction *func, PFunction *def, const FString &name)
+{
+	// Store needs to know if compiling the function added any generated data.
+	if (ScriptCacheHooks.GeneratedDataSize) GeneratedDataMark = ScriptCacheHooks.GeneratedDataSize();
+
+	if (!Loaded) return false;
+	if (NextEntry >= Entries.Size() || Entries[NextEntry].Name.Compare(name) != 0)
+	{
+		// Out of sync. This should not happen with a matching key, but if it does, stop using the cache.
+		Printf(TEXTCOLOR_ORANGE "Script cache is out of sync at %s\n", name.GetChars());
+		remove(ScriptCacheName(false).GetChars());
+		Loaded = Enabled = false;
+		return false;
+	}
+	auto &entry = Entries[NextEntry++];
+	if (entry.Length == 0) return false;
+
+	FCacheReader r(Data.Data() + entry.Offset, entry.Length);
+
+	unsigned codesize = r.UInt32();
+	unsigned numlines = r.UInt32();
+	unsigned numkd = r.UInt32();
+	unsigned numkf = r.UInt32();
+	unsigned numks = r.UInt32();
+	unsigned numka = r.UInt32();
+	if (r.Error || codesize == 0 || codesize > size_t(r.End - r.Pos) || numlines > 65535 || numkd > 65535 || numkf > 65535 || numks > 65535 || numka > 65535) return false;
+
+	TArray<VMOP> code(codesize, true);
+	TArray<FStatementInfo> lines(numlines, true);
+	TArray<int> konstd(numkd, true);
+	TArray<double> konstf(numkf, true);
+	TArray<FString> konsts(numks, true);
+	TArray<void *> konsta(numka, true);
+
+	r.Bytes(code.Data(), codesize * sizeof(VMOP));
+	r.Bytes(lines.Data(), numlines * sizeof(FStatementInfo));
+	r.Bytes(konstd.Data(), numkd * sizeof(int));
+	r.Bytes(konstf.Data(), numkf * sizeof(double));
+	for (auto &s : konsts) s = r.String();
+
+	for (auto &a : konsta)
+	{
+		if (r.Error) return false;
+		switch (r.UInt8())
+		{
+		case RELOC_Raw:
+			a = (void *)(uintptr_t)r.UInt64();
+			break;
+
+		case RELOC_Function:
+		{
+			unsigned index = r.UInt32();
+			FString fname = r.String();
+			auto &all = VMFunction::AllFunctions;
+			if (index >= all.Size() || fname.Compare(all[index]->Name.GetChars()) != 0) return false;
+			a = all[index];
+			break;
+		}
+
+		case RELOC_Class:
+			a = ReadClass(r);
+			if (a == nullptr) return false;
+			break;
+
+		case RELOC_CVar:
+		{
+			auto cvar = FindCVar(r.String().GetChars(), nullptr);
+			a = cvar ? FxCVar::ValueAddress(cvar) : nullptr;
+			if (a == nullptr) return false;
+			break;
+		}
+
+		case RELOC_Blob:
+		{
+			unsigned size = r.UInt32();
+			if (r.Error || size > size_t(r.End - r.Pos)) return false;
+			a = ClassDataAllocator.Alloc(size);
+			r.Bytes(a, size);
+			break;
+		}
+
+		case RELOC_TextureCount:
+			a = TextureCountAddress();
+			break;
+
+		case RELOC_Hook:
+		{
+			FName owner(r.String(), true);
+			int index = (int)r.UInt32();
+			a = ScriptCacheHooks.DecodePointer && !r.Error ? ScriptCacheHooks.DecodePointer(owner, index) : nullptr;
+			if (a == nullptr) return false;
+			break;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	uint8_t numregs[4];
+	r.Bytes(numregs, 4);
+	unsigned maxparam = r.UInt16();
+	unsigned numargs = r.UInt8();
+	int extraspace = (int)r.UInt32();
+	bool isunsafe = !!r.UInt8();
+	bool blockjit = !!r.UInt8();
+	FString sourcefile = r.String();
+
+	unsigned numinits = r.UInt32();
+	if (r.Error || numinits > size_t(r.End - r.Pos)) return false;
+	TArray<FTypeAndOffset> specialinits(numinits, true);
+	for (auto &init : specialinits)
+	{
+		init.first = ReadType(r);
+		init.second = r.UInt32();
+		if (init.first == nullptr) return false;
+	}
+
+	PPrototype *proto = nullptr;
+	if (r.UInt8())
+	{
+		unsigned numrets = r.UInt32();
+		if (r.Error || numrets > size_t(r.End - r.Pos)) return false;
+		TArray<PType *> rets(numrets, true);
+		for (auto &ret : rets)
+		{
+			ret = ReadType(r);
+			if (ret == nullptr) return false;
+		}
+		if (func->Proto == nullptr) proto = NewPrototype(rets, def->Variants[0].Proto->ArgumentTypes);
+	}
+	if (r.Error || r.Pos != r.End) return false;
+
+	// Everything checks out so now fill in the function.
+	func->Alloc(codesize, numkd, numkf, numks, numka, numlines);
+	memcpy(func->Code, code.Data(), codesize * sizeof(VMOP));
+	if (numlines > 0) memcpy(func->LineInfo, lines.Data(), numlines * sizeof(FStatementInfo));
+	if (numkd > 0) memcpy(func->KonstD, konstd.Data(), numkd * sizeof(int));
+	if (numkf > 0) memcpy(func->KonstF, konstf.Data(), numkf * sizeof(double));
+	for (unsigned i = 0; i < numks; i++) func->KonstS[i] = konsts[i];
+	for (unsigned i = 0; i < numka; i++) func->KonstA[i].v = konsta[i];
+
+	func->NumRegD = numregs[REGT_INT];
+	func->NumRegF = numregs[REGT_FLOAT];
+	func->NumRegS = numregs[REGT_STRING];
+	func->NumRegA = numregs[REGT_POINTER];
+	func->MaxParam = maxparam;
+	func->NumArgs = numargs;
+	func->ExtraSpace = extraspace;
+	func->StackSize = VMFrame::FrameSize(func->NumRegD, func->NumRegF, func->NumRegS, func->NumRegA, func->MaxParam, func->ExtraSpace);
+	func->Unsafe = isunsafe;
+	func->blockJit = blockjit;
+	func->SourceFileName = sourcefile;
+	func->SpecialInits = std::move(specialinits);
+	if (proto != nullptr)
+	{
+		func->Proto = proto;
+		func->ArgFlags = def->Variants[0].ArgFlags;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Store
+//
+// Records a freshly compiled function. Functions that reference data
+// that cannot be identified in another session get an empty entry.
+//
+//==========================================================================
+
+void FScriptCache::Store(VMScriptFunction *func, PFunction *def, const FString &name, VMFunctionBuilder &build)
+{
+	if (!Enabled || Loaded) return;
+
+	// Functions and classes cannot be created by the code generator so these maps only need to be set up once.
+	if (FunctionMap.CountUsed() == 0)
+	{
+		for (unsigned i = 0; i < VMFunction::AllFunctions.Size(); i++) FunctionMap.Insert(VMFunction::AllFunctions[i], i);
+		for (auto cls : PClass::AllClasses) ClassMap.Insert(cls, cls->TypeName);
+	}
+
+	TArray<uint8_t> buffer;
+	FCacheWriter w(buffer);
+	bool ok = !ScriptCacheHooks.GeneratedDataSize || ScriptCacheHooks.GeneratedDataSize() == GeneratedDataMark;
+
+	w.UInt32(func->CodeSize);
+	w.UInt32(func->LineInfoCount);
+	w.UInt32(func->NumKonstD);
+	w.UInt32(func->NumKonstF);
+	w.UInt32(func->NumKonstS);
+	w.UInt32(func->NumKonstA);
+	w.Bytes(func->Code, func->CodeSize * sizeof(VMOP));
+	w.Bytes(func->LineInfo, func->LineInfoCount * sizeof(FStatementInfo));
+	w.Bytes(func->KonstD, func->NumKonstD * sizeof(int));
+	w.Bytes(func->KonstF, func->NumKonstF * sizeof(double));
+	for (unsigned i = 0; i < func->NumKonstS; i++) w.String(func->KonstS[i].GetChars());
+
+	for (unsigned i = 0; i < func->NumKonstA && ok; i++)
+	{
+		void *ptr = func->KonstA[i].v;
+		unsigned *pindex;
+		FName *pname;
+		FName owner;
+		int index;
+
+		if ((uintptr_t)ptr < 0x10000)
+		{
+			w.UInt8(RELOC_Raw);
+			w.UInt64((uintptr_t)ptr);
+		}
+		else if ((pindex = build.ConstantBlobs.CheckKey(ptr)))
+		{
+			w.UInt8(RELOC_Blob);
+			w.UInt32(*pindex);
+			w.Bytes(ptr, *pindex);
+		}
+		else if (auto pcvar = build.ConstantCVars.CheckKey(ptr))
+		{
+			w.UInt8(RELOC_CVar);
+			w.String((*pcvar)->GetName());
+		}
+		else if (ptr == TextureCountAddress())
+		{
+			w.UInt8(RELOC_TextureCount);
+		}
+		else if ((pindex = FunctionMap.CheckKey(ptr)))
+		{
+			w.UInt8(RELOC_Function);
+			w.UInt32(*pindex);
+			w.String(VMFunction::AllFunctions[*pindex]->Name.GetChars());
+		}
+		else if ((pname = ClassMap.CheckKey(ptr)))
+		{
+			w.UInt8(RELOC_Class);
+			w.String(pname->GetChars());
+		}
+		else if (ScriptCacheHooks.EncodePointer && ScriptCacheHooks.EncodePointer(ptr, owner, index))
+		{
+			w.UInt8(RELOC_Hook);
+			w.String(owner.GetChars());
+			w.UInt32(index);
+		}
+		else ok = false;
+	}
+
+	w.UInt8(func->NumRegD);
+	w.UInt8(func->NumRegF);
+	w.UInt8(func->NumRegS);
+	w.UInt8(func->NumRegA);
+	w.UInt16(func->MaxParam);
+	w.UInt8(func->NumArgs);
+	w.UInt32(func->ExtraSpace);
+	w.UInt8(func->Unsafe);
+	w.UInt8(func->blockJit);
+	w.String(func->SourceFileName.GetChars());
+
+	w.UInt32(func->SpecialInits.Size());
+	for (auto &init : func->SpecialInits)
+	{
+		ok &= WriteType(w, const_cast<PType *>(init.first));
+		w.UInt32(init.second);
+	}
+
+	// Anonymous functions get their prototype from the code so it must be stored, too.
+	bool anonymous = def->SymbolName == NAME_None;
+	w.UInt8(anonymous);
+	if (anonymous)
+	{
+		auto &rets = func->Proto->ReturnTypes;
+		w.UInt32(rets.Size());
+		for (auto ret : rets) ok &= WriteType(w, ret);
+	}
+
+	Entry &e = OutEntries[OutEntries.Reserve(1)];
+	e.Name = name;
+	e.Offset = Output.Size();
+	e.Length = ok ? buffer.Size() : 0;
+	if (ok) Output.Append(buffer);
+}
+
+//==========================================================================
+//
+// Skip
+//
+// Keeps the entries in sync for functions that failed to compile.
+//
+//==========================================================================
+
+void FScriptCache::Skip(const FString &name)
+{
+	if (Loaded)
+	{
+		if (NextEntry < Entries.Size()) NextEntry++;
+	}
+	else if (Enabled)
+	{
+		Entry &e = OutEntries[OutEntries.Reserve(1)];
+		e.Name = name;
+		e.Offset = Output.Size();
+		e.Length = 0;
+	}
+}
+
+//==========================================================================
+//
+// Save
+//
+// Writes the cache file if it got rebuilt in this session.
+//
+//==========================================================================
+
+void FScriptCache::Save()
+{
+	if (!Enabled || Loaded || OutEntries.Size() == 0) return;
+
+	FString path = ScriptCacheName(true);
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(path.GetChars()));
+	if (fw == nullptr) return;
+
+	TArray<uint8_t> out;
+	FCacheWriter w(out);
+	w.Bytes(ScriptCacheMagic, 4);
+	w.UInt32(SCRIPTCACHE_VERSION);
+	w.Bytes(Key.Data(), 16);
+
+	int numnames = FName::GetNumNames();
+	w.UInt32(FirstNewName);
+	w.UInt32(numnames - FirstNewName);
+	for (int i = FirstNewName; i < numnames; i++)
+	{
+		w.String(FName(ENamedName(i)).GetChars());
+	}
+
+	w.UInt32(OutEntries.Size());
+	for (auto &e : OutEntries)
+	{
+		w.String(e.Name.GetChars());
+		w.UInt32(e.Length);
+		w.Bytes(Output.Data() + e.Offset, e.Length);
+	}
+	fw->Write(out.Data(), out.Size());
+}
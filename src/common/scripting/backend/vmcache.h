@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tarray.h"
+#include "zstring.h"
+#include "name.h"
+
+class VMScriptFunction;
+class VMFunctionBuilder;
+class PFunction;
+class PType;
+
+//==========================================================================
+//
+// On-disk cache for compiled script functions
+//
+// The cache is keyed by everything that can influence code generation:
+// the engine build, the loaded file list, the contents of every text lump
+// that went through the scanner before compilation and the name table.
+// If any of these differ the cache is discarded and rebuilt.
+//
+// Address constants are stored as relocation records. Any function
+// referencing something that cannot be identified across sessions is
+// not cached and will always be compiled normally.
+//
+//==========================================================================
+
+// Game-side address constants (e.g. actor states) the common code cannot identify by itself.
+struct FScriptCacheHooks
+{
+	bool (*EncodePointer)(void *ptr, FName &owner, int &index) = nullptr;
+	void *(*DecodePointer)(FName owner, int index) = nullptr;
+	// Size of game-side data the code generator appends to and refers to by offset (i.e. state labels).
+	// This data is not recreated for restored functions, so functions that add to it cannot be cached.
+	unsigned (*GeneratedDataSize)() = nullptr;
+};
+
+extern FScriptCacheHooks ScriptCacheHooks;
+
+// Called before the scripts get read.
+void VMCache_BeginSources();
+// Called by the scanner for every script lump it reads.
+void VMCache_AddSource(const void *data, size_t length);
+
+class FScriptCache
+{
+	struct Entry
+	{
+		FString Name;
+		unsigned Offset;
+		unsigned Length;
+	};
+
+	TArray<uint8_t> Key;
+	TArray<uint8_t> Data;
+	TArray<Entry> Entries;
+	TArray<FString> NewNames;
+	TArray<uint8_t> Output;
+	TArray<Entry> OutEntries;
+	TMap<void *, unsigned> FunctionMap;
+	TMap<void *, FName> ClassMap;
+	int FirstNewName = 0;
+	unsigned NextEntry = 0;
+	unsigned GeneratedDataMark = 0;
+	bool Loaded = false;
+	bool Enabled = false;
+
+	bool Load();
+	void CalcKey();
+	static void *TextureCountAddress();
+
+public:
+	FScriptCache();
+
+	bool Restore(VMScriptFunction *func, PFunction *def, const FString &name);
+	void Store(VMScriptFunction *func, PFunction *def, const FString &name, VMFunctionBuilder &build);
+	void Skip(const FString &name);
+	void Save();
+};
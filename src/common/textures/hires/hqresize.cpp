@@ -297,13 +297,9 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		HQnX_asm::InitLUTs();
-		initdone = true;
-	}
+	// Textures can be upscaled on several decoder threads at once.
+	static bool initdone = (HQnX_asm::InitLUTs(), true);
+	(void)initdone;
 
 	auto pImageIn = std::make_unique<HQnX_asm::CImage>();
 	auto& cImageIn = *pImageIn;
@@ -325,13 +321,9 @@ static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*,
 							  int &outWidth,
 							  int &outHeight )
 {
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		hqxInit();
-		initdone = true;
-	}
+	// Textures can be upscaled on several decoder threads at once.
+	static bool initdone = (hqxInit(), true);
+	(void)initdone;
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
@@ -40,6 +40,7 @@
 #include "files.h"
 #include "cmdlib.h"
 #include "palettecontainer.h"
+#include "texdecode.h"
 
 FMemArena ImageArena(32768);
 TArray<FImageSource *>FImageSource::ImageForLump;
@@ -86,6 +87,9 @@ PalettedPixels FImageSource::GetCachedPalettedPixels(int conversion, int frame)
 
 	auto imageID = ImageID;
 
+	// The cache is only accessible to the main thread. Decoder threads always create their own copy.
+	if (TexDecode_IsWorkerThread()) return CreatePalettedPixels(conversion, frame);
+
 	// Do we have this image in the cache?
 	unsigned index = conversion != normal? UINT_MAX : precacheDataPaletted.FindEx([=](PrecacheDataPaletted &entry) { return entry.ImageID == imageID && entry.Frame == frame; });
 	if (index < precacheDataPaletted.Size())
@@ -213,8 +217,8 @@ FBitmap FImageSource::GetCachedBitmap(const PalEntry *remap, int conversion, int
 	else
 	{
 		if (conversion == luminance) conversion = normal;	// luminance has no meaning for true color.
-		// Do we have this image in the cache?
-		unsigned index = conversion != normal? UINT_MAX : precacheDataRgba.FindEx([=](PrecacheDataRgba &entry) { return entry.ImageID == imageID && entry.Frame == frame; });
+		// Do we have this image in the cache? Decoder threads may not access it.
+		unsigned index = conversion != normal || TexDecode_IsWorkerThread() ? UINT_MAX : precacheDataRgba.FindEx([=](PrecacheDataRgba &entry) { return entry.ImageID == imageID && entry.Frame == frame; });
 		if (index < precacheDataRgba.Size())
 		{
 			auto cache = &precacheDataRgba[index];
@@ -243,7 +247,7 @@ FBitmap FImageSource::GetCachedBitmap(const PalEntry *remap, int conversion, int
 		else
 		{
 			// The image wasn't cached. Now there's two possibilities:
-			auto info = precacheInfo.CheckKey(ImageID);
+			auto info = TexDecode_IsWorkerThread() ? nullptr : precacheInfo.CheckKey(ImageID);
 			if (!info || info->first <= 1 || conversion != normal)
 			{
 				// This is either the only copy needed or some access outside the caching block. In these cases create a new one and directly return it.
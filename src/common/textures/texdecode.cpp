@@ -0,0 +1,292 @@
+/*
+** texdecode.cpp
+** Decodes textures on worker threads ahead of their upload
+**
+**---------------------------------------------------------------------------
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Creating a texture buffer means reading the image, compositing its
+** patches, optionally upscaling it and postprocessing the result. None of
+** that needs the graphics API so it can be done on a worker thread for
+** textures that are known to be needed soon. The upload itself still
+** happens on the main thread when the backend creates the hardware
+** texture and picks up the prepared buffer through CreateTexBuffer.
+**
+** There is at most one job per texture. A request for a texture whose job
+** has not started yet decodes it inline, a request for one that is being
+** decoded waits for the worker. What decoding finds out about the texture
+** itself, like its translucency, gets applied when the main thread takes
+** the result.
+**
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "textures.h"
+#include "texdecode.h"
+#include "c_cvars.h"
+#include "ctpl.h"
+
+CUSTOM_CVAR(Int, gl_texture_decodethreads, 2, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > 8) self = 8;
+}
+
+enum
+{
+	JOB_Queued,
+	JOB_Running,
+	JOB_Done,
+};
+
+struct FTexDecodeJob
+{
+	FTexture *Texture;
+	int Translation;
+	int Flags;
+	int State;
+	bool Failed;
+	FTextureBuffer Buffer;
+	FTextureDecodeInfo Info;	// applied to the texture by TexDecode_Take
+};
+
+static std::mutex DecodeMutex;
+static std::condition_variable DecodeDone;
+static TMap<FTexture *, FTexDecodeJob *> DecodeJobs;
+static std::atomic<int> NumJobs;
+static int RunningJobs;
+static thread_local bool DecodeThread;
+
+// Must come after everything the jobs access because its destructor waits for them.
+static ctpl::thread_pool DecodePool;
+
+//==========================================================================
+//
+// Must be called on the main thread because it releases the reference
+// to the texture.
+//
+//==========================================================================
+
+static void ReleaseJob(FTexDecodeJob *job)
+{
+	job->Texture->DecRef();
+	delete job;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void RunJob(FTexture *tex)
+{
+	FTexDecodeJob *job;
+	{
+		std::unique_lock<std::mutex> lock(DecodeMutex);
+		auto pjob = DecodeJobs.CheckKey(tex);
+		// The job may have been cancelled or taken over by the main thread.
+		if (pjob == nullptr || (*pjob)->State != JOB_Queued) return;
+		job = *pjob;
+		job->State = JOB_Running;
+		RunningJobs++;
+	}
+
+	DecodeThread = true;
+	FTextureBuffer buffer;
+	FTextureDecodeInfo info = job->Info;
+	bool failed = false;
+	try
+	{
+		buffer = tex->DecodeTexBuffer(job->Translation, job->Flags, info);
+	}
+	catch (...)
+	{
+		// Let the main thread run into the same error so that it gets reported properly.
+		failed = true;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(DecodeMutex);
+		job->Buffer = std::move(buffer);
+		job->Info = info;
+		job->Failed = failed;
+		job->State = JOB_Done;
+		RunningJobs--;
+	}
+	DecodeDone.notify_all();
+}
+
+//==========================================================================
+//
+// Queues a texture for decoding. Returns false if decoding on worker
+// threads is disabled.
+//
+//==========================================================================
+
+bool TexDecode_Queue(FTexture *tex, int translation, int flags)
+{
+	if (gl_texture_decodethreads <= 0) return false;
+	if (DecodePool.size() != gl_texture_decodethreads) DecodePool.resize(gl_texture_decodethreads);
+
+	{
+		std::unique_lock<std::mutex> lock(DecodeMutex);
+		if (DecodeJobs.CheckKey(tex)) return true;
+
+		auto job = new FTexDecodeJob;
+		job->Texture = tex;
+		job->Translation = translation;
+		job->Flags = flags;
+		job->State = JOB_Queued;
+		job->Failed = false;
+		job->Info = tex->GetDecodeInfo();
+		DecodeJobs.Insert(tex, job);
+		NumJobs++;
+	}
+	// Keep the texture alive while the job refers to it.
+	tex->IncRef();
+	DecodePool.push([=](int) { RunJob(tex); });
+	return true;
+}
+
+//==========================================================================
+//
+// Removes the texture's job, once it is no longer running.
+//
+//==========================================================================
+
+static FTexDecodeJob *FinishJob(FTexture *tex)
+{
+	if (NumJobs == 0 || DecodeThread) return nullptr;
+
+	std::unique_lock<std::mutex> lock(DecodeMutex);
+	auto pjob = DecodeJobs.CheckKey(tex);
+	if (pjob == nullptr) return nullptr;
+	FTexDecodeJob *job = *pjob;
+
+	// A job that has not started yet won't get done any faster on a
+	// worker than right here, but a running one is worth the wait.
+	if (job->State == JOB_Running)
+	{
+		DecodeDone.wait(lock, [=] { return job->State == JOB_Done; });
+	}
+	DecodeJobs.Remove(tex);
+	NumJobs--;
+	return job;
+}
+
+//==========================================================================
+//
+// Called by CreateTexBuffer on the main thread. If the texture has a job
+// the job is finished here, one way or the other. Returns true if the
+// result was moved into 'result'.
+//
+//==========================================================================
+
+bool TexDecode_Take(FTexture *tex, int translation, int flags, FTextureBuffer &result)
+{
+	auto job = FinishJob(tex);
+	if (job == nullptr) return false;
+
+	bool taken = false;
+	if (job->State == JOB_Done && !job->Failed && job->Translation == translation && job->Flags == flags)
+	{
+		result = std::move(job->Buffer);
+		tex->ApplyDecodeInfo(job->Info, result);
+		taken = true;
+	}
+	ReleaseJob(job);
+	return taken;
+}
+
+//==========================================================================
+//
+// For textures whose hardware texture turned out to exist already.
+//
+//==========================================================================
+
+void TexDecode_Cancel(FTexture *tex)
+{
+	auto job = FinishJob(tex);
+	if (job != nullptr) ReleaseJob(job);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+int TexDecode_State(FTexture *tex)
+{
+	if (NumJobs == 0) return TDS_None;
+
+	std::unique_lock<std::mutex> lock(DecodeMutex);
+	auto pjob = DecodeJobs.CheckKey(tex);
+	if (pjob == nullptr) return TDS_None;
+	return (*pjob)->State == JOB_Done ? TDS_Ready : TDS_Pending;
+}
+
+//==========================================================================
+//
+// Cancels all jobs that have not started yet, waits for the running ones
+// and discards all results. This must be done before the textures or the
+// images they are created from get deleted.
+//
+//==========================================================================
+
+void TexDecode_Clear()
+{
+	if (NumJobs == 0) return;
+
+	TArray<FTexDecodeJob *> jobs;
+	DecodePool.clear_queue();
+	{
+		std::unique_lock<std::mutex> lock(DecodeMutex);
+		decltype(DecodeJobs)::Iterator it(DecodeJobs);
+		decltype(DecodeJobs)::Pair *pair;
+		while (it.NextPair(pair)) jobs.Push(pair->Value);
+		DecodeJobs.Clear();
+		NumJobs = 0;
+
+		// Running jobs still write to their job object.
+		DecodeDone.wait(lock, [] { return RunningJobs == 0; });
+	}
+	for (auto job : jobs) ReleaseJob(job);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool TexDecode_IsWorkerThread()
+{
+	return DecodeThread;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+struct FTextureBuffer;
+class FTexture;
+
+enum ETexDecodeState
+{
+	TDS_None,		// no job for this texture
+	TDS_Pending,	// queued or being decoded
+	TDS_Ready,		// the buffer is waiting to be picked up
+};
+
+bool TexDecode_Queue(FTexture *tex, int translation, int flags);
+bool TexDecode_Take(FTexture *tex, int translation, int flags, FTextureBuffer &result);
+void TexDecode_Cancel(FTexture *tex);
+int TexDecode_State(FTexture *tex);
+void TexDecode_Clear();
+bool TexDecode_IsWorkerThread();
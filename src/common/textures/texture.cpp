@@ -45,6 +45,7 @@
 #include "m_fixed.h"
 #include "imagehelpers.h"
 #include "image.h"
+#include "texdecode.h"
 #include "formats/multipatchtexture.h"
 #include "texturemanager.h"
 #include "c_cvars.h"
@@ -207,11 +208,11 @@ bool FTexture::FindHoles(const unsigned char* buffer, int w, int h)
 //
 //----------------------------------------------------------------------------
 
-void FTexture::CheckTrans(unsigned char* buffer, int size, int trans)
+void FTexture::CheckTrans(unsigned char* buffer, int size, int trans, int8_t &translucent)
 {
-	if (bTranslucent == -1)
+	if (translucent == -1)
 	{
-		bTranslucent = trans;
+		translucent = trans;
 		if (trans == -1)
 		{
 			uint32_t* dwbuf = (uint32_t*)buffer;
@@ -221,11 +222,11 @@ void FTexture::CheckTrans(unsigned char* buffer, int size, int trans)
 
 				if (alpha != 0xff && alpha != 0)
 				{
-					bTranslucent = 1;
+					translucent = 1;
 					return;
 				}
 			}
-			bTranslucent = 0;
+			translucent = 0;
 		}
 	}
 }
@@ -307,23 +308,52 @@ bool FTexture::SmoothEdges(unsigned char* buffer, int w, int h)
 //
 //===========================================================================
 
-bool FTexture::ProcessData(unsigned char* buffer, int w, int h, bool ispatch)
+void FTexture::ProcessData(unsigned char* buffer, int w, int h, FTextureDecodeInfo &info)
 {
-	if (Masked)
+	if (info.Masked)
 	{
-		Masked = SmoothEdges(buffer, w, h);
-		if (Masked && !ispatch) FindHoles(buffer, w, h);
+		info.Masked = SmoothEdges(buffer, w, h);
+		info.FindHoles = info.Masked;
 	}
-	return true;
+}
+
+//===========================================================================
+// 
+// Must be called on the main thread.
+//
+//===========================================================================
+
+void FTexture::ApplyDecodeInfo(const FTextureDecodeInfo &info, const FTextureBuffer &buffer)
+{
+	if (bTranslucent == -1) bTranslucent = info.Translucent;
+	if (!info.Masked) Masked = false;
+	if (info.FindHoles && Masked) FindHoles(buffer.mBuffer, buffer.mWidth, buffer.mHeight);
 }
 
 //===========================================================================
 // 
 //	Initializes the buffer for the texture data
 //
+//	Buffers for hardware textures may already have been decoded by a
+//	worker thread. Other requests only need the texture's properties or
+//	are for the software renderer, so they are not worth waiting for.
+//
 //===========================================================================
 
 FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
+{
+	FTextureBuffer result;
+	if ((flags & (CTF_ProcessData | CTF_CheckOnly)) == CTF_ProcessData && TexDecode_Take(this, translation, flags, result))
+	{
+		return result;
+	}
+	auto info = GetDecodeInfo();
+	result = DecodeTexBuffer(translation, flags, info);
+	ApplyDecodeInfo(info, result);
+	return result;
+}
+
+FTextureBuffer FTexture::DecodeTexBuffer(int translation, int flags, FTextureDecodeInfo &info)
 {
 	FTextureBuffer result;
 	if (flags & CTF_Indexed)
@@ -384,8 +414,8 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 
 			if (remap == nullptr)
 			{
-				CheckTrans(buffer, W * H, trans);
-				isTransparent = bTranslucent;
+				CheckTrans(buffer, W * H, trans, info.Translucent);
+				isTransparent = info.Translucent;
 			}
 			else
 			{
@@ -414,7 +444,7 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 		{
 			if (flags & CTF_Upscale) CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
 
-			if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
+			if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, info);
 		}
 	}
 	return result;
@@ -44,6 +44,7 @@
 #include "c_dispatch.h"
 #include "sc_man.h"
 #include "image.h"
+#include "texdecode.h"
 #include "vectors.h"
 #include "animtexture.h"
 #include "formats/multipatchtexture.h"
@@ -89,6 +90,7 @@ FTextureManager::~FTextureManager ()
 
 void FTextureManager::DeleteAll()
 {
+	TexDecode_Clear();
 	for (unsigned int i = 0; i < Textures.Size(); ++i)
 	{
 		delete Textures[i].Texture;
@@ -118,6 +120,7 @@ void FTextureManager::DeleteAll()
 
 void FTextureManager::FlushAll()
 {
+	TexDecode_Clear();
 	for (int i = TexMan.NumTextures() - 1; i >= 0; i--)
 	{
 		for (int j = 0; j < 2; j++)
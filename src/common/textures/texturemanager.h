@@ -18,6 +18,7 @@ class FTextureManager
 {
 	void (*progressFunc)();
 	friend class FxAddSub;	// needs access to do a bounds check on the texture ID.
+	friend class FScriptCache;	// needs to relocate the address of the texture count in compiled code.
 public:
 	FTextureManager ();
 	~FTextureManager ();
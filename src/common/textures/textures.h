@@ -205,6 +205,15 @@ struct FTextureBuffer
 
 };
 
+// What decoding a texture finds out about it. Decoder threads must not touch the texture itself,
+// so this gets collected separately and only applied on the main thread.
+struct FTextureDecodeInfo
+{
+	int8_t Translucent;
+	bool Masked;
+	bool FindHoles = false;
+};
+
 // Base texture class
 class FTexture : public RefCountedBase
 {
@@ -292,6 +301,9 @@ public:
 
 public:
 	FTextureBuffer CreateTexBuffer(int translation, int flags = 0);
+	FTextureBuffer DecodeTexBuffer(int translation, int flags, FTextureDecodeInfo &info);
+	FTextureDecodeInfo GetDecodeInfo() const { return { bTranslucent, Masked }; }
+	void ApplyDecodeInfo(const FTextureDecodeInfo &info, const FTextureBuffer &buffer);
 	virtual bool DetermineTranslucency();
 	bool GetTranslucency()
 	{
@@ -300,8 +312,8 @@ public:
 
 public:
 
-	void CheckTrans(unsigned char * buffer, int size, int trans);
-	bool ProcessData(unsigned char * buffer, int w, int h, bool ispatch);
+	static void CheckTrans(unsigned char * buffer, int size, int trans, int8_t &translucent);
+	static void ProcessData(unsigned char * buffer, int w, int h, FTextureDecodeInfo &info);
 	int CheckRealHeight();
 
 	friend class FTextureManager;
@@ -45,7 +45,7 @@
 // that is just large enough to hold it.
 #define BLOCK_SIZE			4096
 
-// How many entries to grow the NameArray by when it needs to grow.
+// The minimum number of entries to grow the NameArray by when it needs to grow.
 #define NAME_GROW_AMOUNT	256
 
 // TYPES -------------------------------------------------------------------
@@ -84,6 +84,17 @@ static const char *PredefinedNames[] =
 
 // CODE --------------------------------------------------------------------
 
+//==========================================================================
+//
+// FName :: MakeHash
+//
+//==========================================================================
+
+unsigned int FName::MakeHash (const char *text, size_t textLen)
+{
+	return MakeKey (text, textLen);
+}
+
 //==========================================================================
 //
 // FName :: NameManager :: FindName
@@ -96,47 +107,37 @@ static const char *PredefinedNames[] =
 
 int FName::NameManager::FindName (const char *text, bool noCreate)
 {
-	if (!Inited)
-	{
-		InitBuckets ();
-	}
-
 	if (text == NULL)
 	{
 		return 0;
 	}
+	size_t textLen = strlen (text);
+	return FindName (text, textLen, MakeKey (text, textLen), noCreate);
+}
 
-	unsigned int hash = MakeKey (text);
-	unsigned int bucket = hash % HASH_SIZE;
-	int scanner = Buckets[bucket];
-
-	// See if the name already exists.
-	while (scanner >= 0)
-	{
-		if (NameArray[scanner].Hash == hash && stricmp (NameArray[scanner].Text, text) == 0)
-		{
-			return scanner;
-		}
-		scanner = NameArray[scanner].NextHash;
-	}
+//==========================================================================
+//
+// The same as above, but the text length is also passed, for creating
+// a name from a substring or for speed if the length is already known.
+//
+//==========================================================================
 
-	// If we get here, then the name does not exist.
-	if (noCreate)
+int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreate)
+{
+	if (text == NULL)
 	{
 		return 0;
 	}
-
-	return AddName (text, hash, bucket);
+	return FindName (text, textLen, MakeKey (text, textLen), noCreate);
 }
 
 //==========================================================================
 //
-// The same as above, but the text length is also passed, for creating
-// a name from a substring or for speed if the length is already known.
+// The same as above, with a hash that was computed by FName::MakeHash.
 //
 //==========================================================================
 
-int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreate)
+int FName::NameManager::FindName (const char *text, size_t textLen, unsigned int hash, bool noCreate)
 {
 	if (!Inited)
 	{
@@ -148,12 +149,10 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 		return 0;
 	}
 
-	unsigned int hash = MakeKey (text, textLen);
-	unsigned int bucket = hash % HASH_SIZE;
-	int scanner = Buckets[bucket];
-
 	// See if the name already exists.
-	while (scanner >= 0)
+	unsigned int slot = hash & SlotMask;
+	int scanner;
+	while ((scanner = Slots[slot]) >= 0)
 	{
 		if (NameArray[scanner].Hash == hash &&
 			strnicmp (NameArray[scanner].Text, text, textLen) == 0 &&
@@ -161,7 +160,7 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 		{
 			return scanner;
 		}
-		scanner = NameArray[scanner].NextHash;
+		slot = (slot + 1) & SlotMask;
 	}
 
 	// If we get here, then the name does not exist.
@@ -170,7 +169,7 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 		return 0;
 	}
 
-	return AddName (text, hash, bucket);
+	return AddName (text, textLen, hash, slot);
 }
 
 //==========================================================================
@@ -184,7 +183,9 @@ int FName::NameManager::FindName (const char *text, size_t textLen, bool noCreat
 void FName::NameManager::InitBuckets ()
 {
 	Inited = true;
-	memset (Buckets, -1, sizeof(Buckets));
+	SlotMask = MIN_SLOTS - 1;
+	Slots = (int *)M_Malloc (MIN_SLOTS * sizeof(int));
+	memset (Slots, -1, MIN_SLOTS * sizeof(int));
 
 	// Register built-in names. 'None' must be name 0.
 	for (size_t i = 0; i < countof(PredefinedNames); ++i)
@@ -194,19 +195,48 @@ void FName::NameManager::InitBuckets ()
 	}
 }
 
+//==========================================================================
+//
+// FName :: NameManager :: GrowSlots
+//
+// Doubles the size of the hash table and reinserts all names.
+//
+//==========================================================================
+
+void FName::NameManager::GrowSlots ()
+{
+	unsigned int numSlots = (SlotMask + 1) * 2;
+
+	M_Free (Slots);
+	SlotMask = numSlots - 1;
+	Slots = (int *)M_Malloc (numSlots * sizeof(int));
+	memset (Slots, -1, numSlots * sizeof(int));
+
+	for (int i = 0; i < NumNames; ++i)
+	{
+		unsigned int slot = NameArray[i].Hash & SlotMask;
+		while (Slots[slot] >= 0)
+		{
+			slot = (slot + 1) & SlotMask;
+		}
+		Slots[slot] = i;
+	}
+}
+
 //==========================================================================
 //
 // FName :: NameManager :: AddName
 //
-// Adds a new name to the name table.
+// Adds a new name to the name table. slot is the empty hash table slot
+// where the lookup for this name ended.
 //
 //==========================================================================
 
-int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned int bucket)
+int FName::NameManager::AddName (const char *text, size_t textLen, unsigned int hash, unsigned int slot)
 {
 	char *textstore;
 	NameBlock *block = Blocks;
-	size_t len = strlen (text) + 1;
+	size_t len = textLen + 1;
 
 	// Get a block large enough for the name. Only the first block in the
 	// list is ever considered for name storage.
@@ -217,7 +247,8 @@ int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned i
 
 	// Copy the string into the block.
 	textstore = (char *)block + block->NextAlloc;
-	strcpy (textstore, text);
+	memcpy (textstore, text, textLen);
+	textstore[textLen] = '\0';
 	block->NextAlloc += len;
 
 	// Add an entry for the name to the NameArray
@@ -225,17 +256,20 @@ int FName::NameManager::AddName (const char *text, unsigned int hash, unsigned i
 	{
 		// If no names have been defined yet, make the first allocation
 		// large enough to hold all the predefined names.
-		MaxNames += MaxNames == 0 ? countof(PredefinedNames) + NAME_GROW_AMOUNT : NAME_GROW_AMOUNT;
+		MaxNames += MaxNames == 0 ? countof(PredefinedNames) + NAME_GROW_AMOUNT : (MaxNames / 2 > NAME_GROW_AMOUNT ? MaxNames / 2 : NAME_GROW_AMOUNT);
 
 		NameArray = (NameEntry *)M_Realloc (NameArray, MaxNames * sizeof(NameEntry));
 	}
 
 	NameArray[NumNames].Text = textstore;
 	NameArray[NumNames].Hash = hash;
-	NameArray[NumNames].NextHash = Buckets[bucket];
-	Buckets[bucket] = NumNames;
+	Slots[slot] = NumNames++;
 
-	return NumNames++;
+	if (unsigned(NumNames) * 2 > SlotMask + 1)
+	{
+		GrowSlots ();
+	}
+	return NumNames - 1;
 }
 
 //==========================================================================
@@ -289,6 +323,12 @@ FName::NameManager::~NameManager()
 		M_Free (NameArray);
 		NameArray = NULL;
 	}
+	if (Slots != NULL)
+	{
+		M_Free (Slots);
+		Slots = NULL;
+	}
 	NumNames = MaxNames = 0;
-	memset (Buckets, -1, sizeof(Buckets));
+	SlotMask = 0;
+	Inited = false;
 }
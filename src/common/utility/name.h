@@ -60,6 +60,7 @@ public:
 	FName (const char *text, size_t textlen, bool noCreate) { Index = NameData.FindName (text, textlen, noCreate); }
 	FName(const FString& text) { Index = NameData.FindName(text.GetChars(), text.Len(), false); }
 	FName(const FString& text, bool noCreate) { Index = NameData.FindName(text.GetChars(), text.Len(), noCreate); }
+	FName (const char *text, size_t textlen, unsigned int hash, bool noCreate) { Index = NameData.FindName (text, textlen, hash, noCreate); }
 	FName (const FName &other) = default;
 	FName (ENamedName index) { Index = index; }
  //   ~FName () {}	// Names can be added but never removed.
@@ -75,6 +76,11 @@ public:
 	int SetName (const char *text, bool noCreate=false) { return Index = NameData.FindName (text, noCreate); }
 
 	bool IsValidName() const { return (unsigned)Index < (unsigned)NameData.NumNames; }
+	static int GetNumNames() { return NameData.NumNames; }
+
+	// For callers that look up the same text repeatedly: compute the hash once
+	// with this and pass it to the hashed constructor.
+	static unsigned int MakeHash (const char *text, size_t textlen);
 
 	// Note that the comparison operators compare the names' indices, not
 	// their text, so they cannot be used to do a lexicographical sort.
@@ -99,7 +105,6 @@ protected:
 	{
 		char *Text;
 		unsigned int Hash;
-		int NextHash;
 	};
 
 	struct NameManager
@@ -109,19 +114,24 @@ protected:
 		// means this struct must only exist in the program's BSS section.
 		~NameManager();
 
-		enum { HASH_SIZE = 1024 };
+		// Open addressing with linear probing. The table is doubled
+		// whenever it becomes more than half full.
+		enum { MIN_SLOTS = 4096 };
 		struct NameBlock;
 
 		NameBlock *Blocks;
 		NameEntry *NameArray;
 		int NumNames, MaxNames;
-		int Buckets[HASH_SIZE];
+		int *Slots;
+		unsigned int SlotMask;
 
 		int FindName (const char *text, bool noCreate);
 		int FindName (const char *text, size_t textlen, bool noCreate);
-		int AddName (const char *text, unsigned int hash, unsigned int bucket);
+		int FindName (const char *text, size_t textlen, unsigned int hash, bool noCreate);
+		int AddName (const char *text, size_t textlen, unsigned int hash, unsigned int slot);
 		NameBlock *AddBlock (size_t len);
 		void InitBuckets ();
+		void GrowSlots ();
 		static bool Inited;
 	};
 
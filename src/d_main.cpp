@@ -881,10 +881,13 @@ static void DrawOverlays()
 		FStat::PrintStat (twod);
 }
 
+void CheckSWBench();
+
 static void End2DAndUpdate()
 {
 	twod->End();
 	CheckBench();
+	CheckSWBench();
 	screen->Update();
 	twod->OnFrameDone();
 }
@@ -3109,6 +3112,28 @@ static int FileSystemPrintf(FSMessageLevel level, const char* fmt, ...)
 	}
 	return (int)text.Len();
 }
+//==========================================================================
+//
+// Budget for the decompressed lump cache in megabytes. 0 disables it.
+//
+//==========================================================================
+
+CUSTOM_CVAR(Int, fs_lumpcachesize, 64, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > 4096) self = 4096;
+	SetLumpCacheBudget(size_t(self) << 20);
+}
+
+ADD_STAT(lumpcache)
+{
+	auto stats = GetLumpCacheStats();
+	uint64_t lookups = stats.Hits + stats.Misses;
+	return FStringf("%zu entries, %.1f/%.1f MB  hits=%llu misses=%llu (%.1f%%)  evictions=%llu", stats.Entries,
+		stats.Size / 1048576., stats.Budget / 1048576., (unsigned long long)stats.Hits, (unsigned long long)stats.Misses,
+		lookups ? stats.Hits * 100. / lookups : 0., (unsigned long long)stats.Evictions);
+}
+
 //==========================================================================
 //
 // D_InitGame
@@ -3233,7 +3258,9 @@ static int D_InitGame(const FIWADInfo* iwad_info, std::vector<std::string>& allw
 
 	int max_progress = TexMan.GuesstimateNumTextures();
 	int per_shader_progress = 0;//screen->GetShaderCount()? (max_progress / 10 / screen->GetShaderCount()) : 0;
-	bool nostartscreen = batchrun || restart || Args->CheckParm("-join") || Args->CheckParm("-host") || Args->CheckParm("-norun");
+	// The software renderer benchmark only renders into memory, so it runs without any video output.
+	bool headless = !!Args->CheckParm("-swbench");
+	bool nostartscreen = batchrun || restart || headless || Args->CheckParm("-join") || Args->CheckParm("-host") || Args->CheckParm("-norun");
 
 	if (GameStartupInfo.Type == FStartupInfo::DefaultStartup)
 	{
@@ -3260,7 +3287,7 @@ static int D_InitGame(const FIWADInfo* iwad_info, std::vector<std::string>& allw
 		exec = NULL;
 	}
 
-	if (!restart)
+	if (!restart && !headless)
 		V_Init2();
 
 	// [RH] Initialize localizable strings. 
@@ -3557,6 +3584,24 @@ static int D_InitGame(const FIWADInfo* iwad_info, std::vector<std::string>& allw
 			G_LoadGame(file.GetChars());
 		}
 
+		extern void SWBench_CheckArgs();
+		SWBench_CheckArgs();
+
+		v = Args->CheckValue("-swbench");
+		if (v != NULL)
+		{
+			extern void SWBench_Run(const char *viewfile, const char *mapname);
+			SWBench_Run(v, startmap.GetChars());
+			return 1337; // special exit
+		}
+
+		v = Args->CheckValue("-simbench");
+		if (v != NULL)
+		{
+			G_SimBenchmark(v);
+			return 1337; // special exit
+		}
+
 		v = Args->CheckValue("-playdemo");
 		if (v != NULL)
 		{
@@ -3862,6 +3907,9 @@ void D_Cleanup()
 		G_CheckDemoStatus();
 	}
 
+	// Don't lose a savegame that is still being written.
+	G_FinishPendingSave(true);
+
 	// Music and sound should be stopped first
 	S_StopMusic(true);
 	S_ClearSoundData();
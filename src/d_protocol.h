@@ -49,6 +49,7 @@
 #define BODY_ID		BIGE_ID('B','O','D','Y')
 #define NETD_ID		BIGE_ID('N','E','T','D')
 #define WEAP_ID		BIGE_ID('W','E','A','P')
+#define SYNC_ID		BIGE_ID('S','Y','N','C')
 
 
 struct zdemoheader_s {
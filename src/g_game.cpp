@@ -27,6 +27,8 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <memory>
+#include <thread>
+#include <atomic>
 
 #include "i_time.h"
 
@@ -100,6 +102,7 @@ bool WriteZip(const char* filename, const FileSys::FCompressedBuffer* content, s
 bool	G_CheckDemoStatus (void);
 void	G_ReadDemoTiccmd (ticcmd_t *cmd, int player);
 void	G_WriteDemoTiccmd (ticcmd_t *cmd, int player, int buf);
+static void G_DemoTicStart ();
 void	G_PlayerReborn (int player);
 
 void	G_DoNewGame (void);
@@ -116,11 +119,13 @@ void STAT_Serialize(FSerializer &file);
 
 CVARD_NAMED(Int, gameskill, skill, 2, CVAR_SERVERINFO|CVAR_LATCH, "sets the skill for the next newly started game")
 CVAR(Bool, save_formatted, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use formatted JSON for saves (more readable but a larger files and a bit slower.
+CVAR(Bool, save_binary, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use the compact binary format for saves unless save_formatted is set.
 CVAR (Int, deathmatch, 0, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR (Bool, chasedemo, false, 0);
 CVAR (Bool, storesavepic, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (Bool, longsavemessages, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (Bool, cl_waitforsave, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR (Bool, save_async, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// compress and write savegames on a background thread
 CVAR (Bool, enablescriptscreenshot, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR (Bool, cl_restartondeath, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 EXTERN_CVAR (Float, con_midtime);
@@ -180,6 +185,7 @@ uint8_t*			demobodyspot;
 size_t			maxdemosize;
 uint8_t*			zdemformend;			// end of FORM ZDEM chunk
 uint8_t*			zdembodyend;			// end of ZDEM BODY chunk
+bool			stoprecording;
 bool 			singledemo; 			// quit after playing a demo from cmdline 
  
 bool 			precache = true;		// if true, load all graphics at start 
@@ -1117,6 +1123,17 @@ static uint32_t StaticSumSeeds()
 		pr_damagemobj.Seed();
 }
 
+static uint32_t PlayerConsistency(int i, uint32_t rngsum)
+{
+	if (players[i].mo)
+	{
+		uint32_t sum = rngsum + int((players[i].mo->X() + players[i].mo->Y() + players[i].mo->Z())*257) + players[i].mo->Angles.Yaw.BAMs() + players[i].mo->Angles.Pitch.BAMs();
+		sum ^= players[i].health;
+		return sum;
+	}
+	return rngsum;
+}
+
 //
 // G_Ticker
 // Make ticcmd_ts for the players.
@@ -1126,6 +1143,8 @@ void G_Ticker ()
 	int i;
 	gamestate_t	oldgamestate;
 
+	G_FinishPendingSave(false);
+
 	// do player reborns if needed
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -1240,6 +1259,8 @@ void G_Ticker ()
 	// check, not just the player's x position like BOOM.
 	uint32_t rngsum = StaticSumSeeds ();
 
+	G_DemoTicStart ();
+
 	//Added by MC: For some of that bot stuff. The main bot function.
 	primaryLevel->BotInfo.Main (primaryLevel);
 
@@ -1285,16 +1306,7 @@ void G_Ticker ()
 				{
 					players[i].inconsistant = gametic - BACKUPTICS*ticdup;
 				}
-				if (players[i].mo)
-				{
-					uint32_t sum = rngsum + int((players[i].mo->X() + players[i].mo->Y() + players[i].mo->Z())*257) + players[i].mo->Angles.Yaw.BAMs() + players[i].mo->Angles.Pitch.BAMs();
-					sum ^= players[i].health;
-					consistancy[i][buf] = sum;
-				}
-				else
-				{
-					consistancy[i][buf] = rngsum;
-				}
+				consistancy[i][buf] = PlayerConsistency(i, rngsum);
 			}
 		}
 	}
@@ -1999,6 +2011,7 @@ void FinishLoadingCVars();
 
 void G_DoLoadGame ()
 {
+	G_FinishPendingSave(true);
 	SetupLoadingCVars();
 	bool hidecon;
 
@@ -2334,6 +2347,102 @@ static void PutSavePic (FileWriter *file, int width, int height)
 	}
 }
 
+//==========================================================================
+//
+// Asynchronous savegame writing
+//
+// Once the game state has been serialized nothing in the savegame depends
+// on the playsim anymore, so compressing the buffers, writing the zip and
+// verifying it can be done on a worker thread while the game continues.
+// The job owns all its buffers. Completion is reported on the main thread.
+//
+//==========================================================================
+
+struct FPendingSave
+{
+	TArray<FCompressedBuffer> content;
+	TArray<FString> filenames;
+	FString filename;
+	FString description;
+	bool okForQuicksave;
+	bool forceQuicksave;
+	bool succeeded = false;
+	std::atomic<bool> done{ false };
+	std::thread thread;
+};
+
+static FPendingSave *PendingSave;
+
+static bool G_WriteSaveFile(const char *filename, TArray<FCompressedBuffer> &content)
+{
+	if (WriteZip(filename, content.Data(), content.Size()))
+	{
+		// Check whether the file is ok by trying to open it.
+		FResourceFile *test = FResourceFile::OpenResourceFile(filename, true);
+		if (test != nullptr)
+		{
+			delete test;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void G_SaveReport(bool succeeded, const FString &filename, const char *description, bool okForQuicksave, bool forceQuicksave)
+{
+	if (succeeded)
+	{
+		savegameManager.NotifyNewSave(filename, description, okForQuicksave, forceQuicksave);
+		BackupSaveName = filename;
+
+		if (longsavemessages) Printf("%s (%s)\n", GStrings.GetString("GGSAVED"), filename.GetChars());
+		else Printf("%s\n", GStrings.GetString("GGSAVED"));
+	}
+	else
+	{
+		Printf(PRINT_HIGH, "%s\n", GStrings.GetString("TXT_SAVEFAILED"));
+	}
+}
+
+static void G_SaveThread(FPendingSave *job)
+{
+	try
+	{
+		// The savepic is already a compressed PNG so it is stored as is.
+		for (unsigned i = 1; i < job->content.Size(); i++)
+		{
+			CompressBuffer(job->content[i]);
+		}
+		job->succeeded = G_WriteSaveFile(job->filename.GetChars(), job->content);
+	}
+	catch (...)
+	{
+		job->succeeded = false;
+	}
+	job->done.store(true, std::memory_order_release);
+}
+
+//==========================================================================
+//
+// Reports the result of a pending background save and releases it.
+// If 'wait' is false this returns immediately if the save is still running.
+//
+//==========================================================================
+
+void G_FinishPendingSave(bool wait)
+{
+	if (PendingSave == nullptr) return;
+	if (!wait && !PendingSave->done.load(std::memory_order_acquire)) return;
+
+	auto job = PendingSave;
+	PendingSave = nullptr;
+	job->thread.join();
+
+	G_SaveReport(job->succeeded, job->filename, job->description.GetChars(), job->okForQuicksave, job->forceQuicksave);
+	for (auto &buff : job->content) buff.Clean();
+	delete job;
+}
+
 void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, const char *description)
 {
 	TArray<FCompressedBuffer> savegame_content;
@@ -2341,6 +2450,10 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 
 	char buf[100];
 
+	// Only one save may be in flight at any time.
+	G_FinishPendingSave(true);
+	const bool async = save_async;
+
 	// Do not even try, if we're not in a level. (Can happen after
 	// a demo finishes playback.)
 	if (primaryLevel->lines.Size() == 0 || primaryLevel->sectors.Size() == 0 || gamestate != GS_LEVEL)
@@ -2359,7 +2472,7 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	insave = true;
 	try
 	{
-		level.SnapshotLevel();
+		level.SnapshotLevel(!async);
 	}
 	catch(CRecoverableError &err)
 	{
@@ -2386,7 +2499,7 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	FSerializer savegameglobals;	// and this for non-level related info that must be saved.
 
 	savegameinfo.OpenWriter(true);
-	savegameglobals.OpenWriter(save_formatted);
+	savegameglobals.OpenWriter(save_formatted, save_binary && !save_formatted);
 
 	SaveVersion = SAVEVER;
 	PutSavePic(&savepic, SAVEPICWIDTH, SAVEPICHEIGHT);
@@ -2436,41 +2549,53 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 
 	savegame_content.Push(bufpng);
 	savegame_filenames.Push("savepic.png");
-	savegame_content.Push(savegameinfo.GetCompressedOutput());
+	savegame_content.Push(savegameinfo.GetCompressedOutput(!async));
 	savegame_filenames.Push("info.json");
-	savegame_content.Push(savegameglobals.GetCompressedOutput());
+	savegame_content.Push(savegameglobals.GetCompressedOutput(!async));
 	savegame_filenames.Push("globals.json");
 	G_WriteSnapshots (savegame_filenames, savegame_content);
 	
 	for (unsigned i = 0; i < savegame_content.Size(); i++)
 		savegame_content[i].filename = savegame_filenames[i].GetChars();
 
-	bool succeeded = false;
-
-	if (WriteZip(filename.GetChars(), savegame_content.Data(), savegame_content.Size()))
+	if (async)
 	{
-		// Check whether the file is ok by trying to open it.
-		FResourceFile *test = FResourceFile::OpenResourceFile(filename.GetChars(), true);
-		if (test != nullptr)
+		auto job = new FPendingSave;
+		job->filenames = std::move(savegame_filenames);
+		job->content = std::move(savegame_content);
+		job->filename = filename;
+		job->description = description;
+		job->okForQuicksave = okForQuicksave;
+		job->forceQuicksave = forceQuicksave;
+
+		// The job must own all its buffers. The savepic and the hub snapshots belong to
+		// someone else and need to be copied, the current level's snapshot is only needed
+		// for the savegame so it can be handed over as is.
+		for (unsigned i = 0; i < job->content.Size(); i++)
 		{
-			delete test;
-			succeeded = true;
+			auto &buff = job->content[i];
+			if (i == 0 || (i > 2 && buff.mBuffer != level.info->Snapshot.mBuffer))
+			{
+				auto copy = new char[buff.mCompressedSize];
+				memcpy(copy, buff.mBuffer, buff.mCompressedSize);
+				buff.mBuffer = copy;
+			}
+			buff.filename = job->filenames[i].GetChars();
 		}
-	}
+		level.info->Snapshot.mBuffer = nullptr;
+		level.info->Snapshot.Clean();
 
-	if (succeeded)
-	{
-		savegameManager.NotifyNewSave(filename, description, okForQuicksave, forceQuicksave);
-		BackupSaveName = filename;
+		job->thread = std::thread(G_SaveThread, job);
+		PendingSave = job;
 
-		if (longsavemessages) Printf("%s (%s)\n", GStrings.GetString("GGSAVED"), filename.GetChars());
-		else Printf("%s\n", GStrings.GetString("GGSAVED"));
-	}
-	else
-	{
-		Printf(PRINT_HIGH, "%s\n", GStrings.GetString("TXT_SAVEFAILED"));
+		insave = false;
+		if (cl_waitforsave)
+			I_FreezeTime(false);
+		return;
 	}
 
+	bool succeeded = G_WriteSaveFile(filename.GetChars(), savegame_content);
+	G_SaveReport(succeeded, filename, description, okForQuicksave, forceQuicksave);
 
 	// delete the JSON buffers we created just above. Everything else will
 	// either still be needed or taken care of automatically.
@@ -2493,6 +2618,107 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 // DEMO RECORDING
 //
 
+//==========================================================================
+//
+// Demo sync state
+//
+// When recording ends, the same RNG and player state the network
+// consistency check uses is written to a SYNC chunk after the BODY.
+// Older versions never read past the BODY so they ignore it.
+// Playback compares it against its own state when the demo runs out.
+//
+// Both sides take the state at a tic boundary: Recording only stops at
+// the start of a tic or between tics, and playback checks at the start
+// of the tic that has no more commands, before the bots or any net
+// specials get to run.
+//
+//==========================================================================
+
+static TArray<uint8_t> DemoSyncRecorded, DemoSyncFinal;
+static int DemoSyncResult = DEMOSYNC_Unverified;
+
+static void G_GetSyncState(TArray<uint8_t> &state)
+{
+	uint8_t buffer[4 + MAXPLAYERS * 5];
+	uint8_t *p = buffer;
+	uint32_t rngsum = StaticSumSeeds();
+
+	WriteInt32(rngsum, &p);
+	for (int i = 0; i < MAXPLAYERS; i++)
+	{
+		if (playeringame[i])
+		{
+			WriteInt8(i, &p);
+			WriteInt32(PlayerConsistency(i, rngsum), &p);
+		}
+	}
+	state.Resize(unsigned(p - buffer));
+	memcpy(state.Data(), buffer, state.Size());
+}
+
+static void G_WriteDemoSyncChunk(uint8_t **stream)
+{
+	TArray<uint8_t> state;
+
+	G_GetSyncState(state);
+	StartChunk(SYNC_ID, stream);
+	memcpy(*stream, state.Data(), state.Size());
+	*stream += state.Size();
+	FinishChunk(stream);
+}
+
+static void G_CheckDemoSync()
+{
+	TArray<uint8_t> &state = DemoSyncFinal;
+
+	G_GetSyncState(state);
+	if (DemoSyncRecorded.Size() == 0)
+	{
+		DemoSyncResult = DEMOSYNC_Unverified;
+	}
+	else if (state.Size() == DemoSyncRecorded.Size() && !memcmp(state.Data(), DemoSyncRecorded.Data(), state.Size()))
+	{
+		DemoSyncResult = DEMOSYNC_Match;
+	}
+	else
+	{
+		DemoSyncResult = DEMOSYNC_Mismatch;
+		Printf(TEXTCOLOR_RED "Demo playback went out of sync\n");
+	}
+}
+
+//==========================================================================
+//
+// Called at the start of each tic's command processing.
+//
+//==========================================================================
+
+static void G_DemoTicStart()
+{
+	if (demorecording && stoprecording)
+	{ // use "stop" console command to end demo recording
+		G_CheckDemoStatus ();
+		if (!netgame)
+		{
+			gameaction = ga_fullconsole;
+		}
+	}
+	else if (demoplayback && (demo_p >= zdembodyend || *demo_p == DEM_STOP))
+	{
+		G_CheckDemoSync ();
+	}
+}
+
+int G_DemoSyncResult()
+{
+	return DemoSyncResult;
+}
+
+const TArray<uint8_t> &G_DemoSyncState()
+{
+	return DemoSyncFinal;
+}
+
 void G_ReadDemoTiccmd (ticcmd_t *cmd, int player)
 {
 	int id = DEM_BAD;
@@ -2540,7 +2766,6 @@ void G_ReadDemoTiccmd (ticcmd_t *cmd, int player)
 	}
 } 
 
-bool stoprecording;
 
 CCMD (stop)
 {
@@ -2554,16 +2779,6 @@ void G_WriteDemoTiccmd (ticcmd_t *cmd, int player, int buf)
 	uint8_t *specdata;
 	int speclen;
 
-	if (stoprecording)
-	{ // use "stop" console command to end demo recording
-		G_CheckDemoStatus ();
-		if (!netgame)
-		{
-			gameaction = ga_fullconsole;
-		}
-		return;
-	}
-
 	// [RH] Write any special "ticcmds" for this player to the demo
 	if ((specdata = NetSpecs[player][buf].GetData (&speclen)) && gametic % ticdup == 0)
 	{
@@ -2826,6 +3041,22 @@ bool G_ProcessIFFDemo (FString &mapname)
 		case BODY_ID:
 			bodyHit = true;
 			zdembodyend = demo_p + len;
+			DemoSyncRecorded.Clear();
+			DemoSyncFinal.Clear();
+			DemoSyncResult = DEMOSYNC_Unverified;
+			if (nextchunk + 8 <= zdemformend)
+			{
+				uint8_t *sync = nextchunk;
+				int synclen;
+
+				id = ReadInt32 (&sync);
+				synclen = ReadInt32 (&sync);
+				if (id == SYNC_ID && synclen > 0 && sync + synclen <= zdemformend)
+				{
+					DemoSyncRecorded.Resize(synclen);
+					memcpy(DemoSyncRecorded.Data(), sync, synclen);
+				}
+			}
 			break;
 
 		case COMP_ID:
@@ -3069,6 +3300,8 @@ bool G_CheckDemoStatus (void)
 			}
 		}
 		FinishChunk (&demo_p);
+		// This fits within the safety margin G_WriteDemoTiccmd leaves.
+		G_WriteDemoSyncChunk (&demo_p);
 		formlen = demobuffer + 4;
 		WriteInt32 (int(demo_p - demobuffer - 8), &formlen);
 
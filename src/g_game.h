@@ -68,6 +68,9 @@ void G_SaveGame (const char *filename, const char *description);
 // Called by messagebox
 void G_DoQuickSave ();
 
+// Reports the result of a savegame that is being written in the background.
+void G_FinishPendingSave (bool wait);
+
 // Only called by startup code.
 void G_RecordDemo (const char* name);
 
@@ -77,6 +80,21 @@ void G_PlayDemo (char* name);
 void G_TimeDemo (const char* name);
 bool G_CheckDemoStatus (void);
 
+// Result of comparing the end of a played back demo against the recorded state.
+enum
+{
+	DEMOSYNC_Unverified,	// the demo has no recorded state
+	DEMOSYNC_Match,
+	DEMOSYNC_Mismatch,
+};
+int G_DemoSyncResult();
+// The state the end of the last played back demo was checked with: the RNG sum,
+// then each player's number and consistency value, all in demo byte order.
+const TArray<uint8_t> &G_DemoSyncState();
+
+// Runs the demo's tics as fast as possible without rendering and writes timing data.
+void G_SimBenchmark(const char *demoname);
+
 void G_Ticker (void);
 bool G_Responder (event_t*	ev);
 
@@ -2220,8 +2220,7 @@ size_t DSectorMarker::PropagateMark()
 	if (moretodo)
 	{
 		Black2Gray();
-		GCNext = GC::Gray;
-		GC::Gray = this;
+		GC::PushGray(this);
 	}
 	return marked;
 }
@@ -172,7 +172,7 @@ private:
 	void PlayerSpawnPickClass (int playernum);
 
 public:
-	void SnapshotLevel();
+	void SnapshotLevel(bool compress = true);
 	void UnSnapshotLevel(bool hubLoad);
 
 	void FinalizePortals();
@@ -668,11 +668,11 @@ public:
 	DSeqNode *SequenceListHead;
 
 	// [RH] particle globals
+	// Live particles are kept in a ring buffer ordered by age, starting with the oldest.
 	uint32_t			OldestParticle; // [MC] Oldest particle for replacing with SPF_REPLACE
-	uint32_t			ActiveParticles;
-	uint32_t			InactiveParticles;
+	uint32_t			NumParticles;
 	TArray<particle_t>	Particles;
-	TArray<uint16_t>	ParticlesInSubsec;
+	TArray<uint32_t>	ParticlesInSubsec;
 	FThinkerCollection Thinkers;
 
 	TArray<DVector2>	Scrolls;		// NULL if no DScrollers in this level
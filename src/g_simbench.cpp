@@ -0,0 +1,240 @@
+/*
+** g_simbench.cpp
+** Playsim benchmark driven by demos
+**
+**---------------------------------------------------------------------------
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Runs a demo's tics back to back without rendering or waiting for the
+** clock, so the only thing being measured is the playsim. Each tic's
+** timings go to a CSV file, the totals and the final sync state to a
+** JSON file.
+**
+** Demos recorded by this version store the RNG and player state at the
+** point recording stopped, so playback can tell whether it reproduced
+** the recording exactly.
+**
+*/
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "m_argv.h"
+#include "stats.h"
+#include "version.h"
+#include "doomstat.h"
+#include "d_event.h"
+#include "d_protocol.h"
+#include "g_game.h"
+#include "g_levellocals.h"
+#include "dthinker.h"
+#include "s_doomsound.h"
+
+extern cycle_t ThinkCycles, ActionCycles, ACSTime, SightCycles, EventCycles;
+
+//==========================================================================
+//
+// Paths and map names may contain backslashes or quotes.
+//
+//==========================================================================
+
+static FString JsonString(const char *str)
+{
+	FString out;
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\') out << '\\' << *str;
+		else if ((unsigned char)*str < 32) out.AppendFormat("\\u%04x", (unsigned char)*str);
+		else out << *str;
+	}
+	return out;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void WriteSyncState(FILE *f, const char *key, const TArray<uint8_t> &state)
+{
+	if (state.Size() < 4)
+	{
+		fprintf(f, "\"%s\":null", key);
+		return;
+	}
+
+	uint8_t *p = const_cast<uint8_t *>(state.Data());
+	uint8_t *end = p + state.Size();
+
+	fprintf(f, "\"%s\":{\"rngsum\":%u,\"players\":[", key, (uint32_t)ReadInt32(&p));
+	for (bool first = true; p + 5 <= end; first = false)
+	{
+		int player = ReadInt8(&p);
+		uint32_t consistency = ReadInt32(&p);
+		fprintf(f, "%s{\"player\":%d,\"consistency\":%u}", first ? "" : ",", player, consistency);
+	}
+	fprintf(f, "]}");
+}
+
+//==========================================================================
+//
+// -simbench <demo>			benchmarks the demo's playsim, then quits
+// -simbenchout <name>		output base name, .csv and .json get appended
+// -simbenchclasses			also collects thinker times per class. This
+//							ticks all thinkers serially and adds overhead
+//							to every single thinker.
+//
+// The first tic loads the level and is not timed. Neither are tics during
+// which the game changes levels or shows an intermission.
+//
+//==========================================================================
+
+void G_SimBenchmark(const char *demoname)
+{
+	FString basename = Args->CheckValue("-simbenchout");
+	if (basename.IsEmpty()) basename = "simbench";
+	bool classes = !!Args->CheckParm("-simbenchclasses");
+
+	FString csvname = basename + ".csv";
+	FString jsonname = basename + ".json";
+	FILE *csv = fopen(csvname.GetChars(), "wt");
+	if (csv == nullptr)
+	{
+		Printf("Unable to open %s for writing\n", csvname.GetChars());
+		return;
+	}
+	fprintf(csv, "tic,total,think,action,acs,sight,gc,events\n");
+
+	singledemo = true;
+	G_DeferedPlayDemo(demoname);
+	G_Ticker();
+	gametic++;
+	if (!demoplayback)
+	{
+		Printf("Unable to play back %s\n", demoname);
+		fclose(csv);
+		return;
+	}
+	FString mapname = primaryLevel->MapName;
+
+	if (classes) P_StartThinkerProfiling();
+
+	cycle_t tictime, gctime;
+	double total = 0, think = 0, action = 0, acs = 0, sight = 0, gc = 0, events = 0, worst = 0;
+	int tics = 0, skipped = 0;
+
+	while (demoplayback)
+	{
+		bool timed = gamestate == GS_LEVEL && gameaction == ga_nothing;
+
+		ThinkCycles.Reset();
+		ActionCycles.Reset();
+		ACSTime.Reset();
+		SightCycles.Reset();
+		EventCycles.Reset();
+
+		tictime.Reset();
+		tictime.Clock();
+		G_Ticker();
+		tictime.Unclock();
+		gametic++;
+
+		gctime.Reset();
+		gctime.Clock();
+		GC::CheckGC();
+		gctime.Unclock();
+
+		// Sound channels only get freed by updating them.
+		if (players[consoleplayer].camera != nullptr)
+		{
+			S_UpdateSounds(players[consoleplayer].camera);
+		}
+
+		if (!timed || gamestate != GS_LEVEL)
+		{
+			skipped++;
+			continue;
+		}
+
+		double ms = tictime.TimeMS() + gctime.TimeMS();
+		fprintf(csv, "%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", gametic - 1, ms, ThinkCycles.TimeMS(), ActionCycles.TimeMS(),
+			ACSTime.TimeMS(), SightCycles.TimeMS(), gctime.TimeMS(), EventCycles.TimeMS());
+
+		tics++;
+		total += ms;
+		think += ThinkCycles.TimeMS();
+		action += ActionCycles.TimeMS();
+		acs += ACSTime.TimeMS();
+		sight += SightCycles.TimeMS();
+		gc += gctime.TimeMS();
+		events += EventCycles.TimeMS();
+		worst = max(worst, ms);
+	}
+	fclose(csv);
+
+	TArray<FThinkerProfile> profile;
+	if (classes) P_StopThinkerProfiling(profile);
+
+	FILE *f = fopen(jsonname.GetChars(), "wt");
+	if (f == nullptr)
+	{
+		Printf("Unable to open %s for writing\n", jsonname.GetChars());
+		return;
+	}
+
+	static const char *const syncnames[] = { "unverified", "match", "mismatch" };
+	const int sync = G_DemoSyncResult();
+	const double div = max(tics, 1);
+
+	fprintf(f, "{\"benchmark\":\"simbench\",\"version\":\"%s\",\"demo\":\"%s\",\"map\":\"%s\",\"tics\":%d,\"skipped\":%d,",
+		JsonString(GetVersionString()).GetChars(), JsonString(demoname).GetChars(), JsonString(mapname.GetChars()).GetChars(), tics, skipped);
+	fprintf(f, "\"total\":%.4f,\"avg\":%.4f,\"max\":%.4f,", total, total / div, worst);
+	fprintf(f, "\"avg_think\":%.4f,\"avg_action\":%.4f,\"avg_acs\":%.4f,\"avg_sight\":%.4f,\"avg_gc\":%.4f,\"avg_events\":%.4f,",
+		think / div, action / div, acs / div, sight / div, gc / div, events / div);
+	fprintf(f, "\"sync\":\"%s\",", syncnames[sync]);
+	WriteSyncState(f, "final", G_DemoSyncState());
+
+	if (classes)
+	{
+		std::sort(profile.begin(), profile.end(), [](const FThinkerProfile &left, const FThinkerProfile &right)
+		{
+			return right.TimeMS < left.TimeMS;
+		});
+
+		fprintf(f, ",\"classes\":[");
+		for (unsigned i = 0; i < profile.Size(); i++)
+		{
+			fprintf(f, "%s{\"class\":\"%s\",\"calls\":%d,\"total\":%.4f}", i > 0 ? "," : "",
+				profile[i].ClassName.GetChars(), profile[i].NumCalls, profile[i].TimeMS);
+		}
+		fprintf(f, "]");
+	}
+	fprintf(f, "}\n");
+	fclose(f);
+
+	Printf("%d tics, %.3f ms avg, %.3f ms max, sync %s\n", tics, total / div, worst, syncnames[sync]);
+	Printf("Benchmark results written to %s and %s\n", csvname.GetChars(), jsonname.GetChars());
+}
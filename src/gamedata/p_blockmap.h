@@ -2,18 +2,18 @@
 #define __P_BLOCKMAP_H
 
 #include "doomtype.h"
+#include "tarray.h"
 
 class AActor;
 
 // [RH] Like msecnode_t, but for the blockmap
+// The node only records which blocks an actor is linked into, the blocks themselves keep their actors in an FBlockThings array.
 struct FBlockNode
 {
 	AActor *Me;						// actor this node references
-	int BlockIndex;					// index into blocklinks for the block this node is in
+	int BlockIndex;					// index into blockthings for the block this node is in
 	int Group;						// portal group this link belongs to (can be different than the actor's own group
-	FBlockNode **PrevActor;			// previous actor in this block
-	FBlockNode *NextActor;			// next actor in this block
-	FBlockNode **PrevBlock;			// previous block this actor is in
+	int ThingIndex;					// position of the actor's entry in the block's FBlockThings array
 	FBlockNode *NextBlock;			// next block this actor is in
 
 	static FBlockNode *Create (AActor *who, int x, int y, int group = -1);
@@ -22,6 +22,23 @@ struct FBlockNode
 	static FBlockNode *FreeBlocks;
 };
 
+struct FBlockThing
+{
+	AActor *Me;						// null if the actor has been unlinked
+	FBlockNode *Node;
+	unsigned Seq;					// link order within the block. Kept when the entry gets cleared.
+	bool SingleBlock;				// actor is only linked into this one block so iterators do not need to check for duplicates.
+};
+
+// Things in one block, oldest first. Iterators walk this back to front so that the most recently linked actor comes first.
+// Unlinking only clears an entry so that nothing has to be moved and the order stays intact. The holes get squeezed out
+// once they make up half of the block.
+struct FBlockThings : public TArray<FBlockThing>
+{
+	unsigned Holes = 0;
+	unsigned NextSeq = 0;
+};
+
 // BLOCKMAP
 // Created from axis aligned bounding box
 // of the map, a rectangular array of
@@ -39,7 +56,9 @@ struct FBlockmap
 	int					bmapheight; 	// in mapblocks
 	double				bmaporgx;
 	double				bmaporgy;		// origin of block map
-	FBlockNode**		blocklinks; 	// for thing chains
+	FBlockThings*		blockthings; 	// for thing chains
+	unsigned			compactcount;	// incremented whenever a block's holes get removed, so that iterators can find their position again
+	bool				keepholes;		// don't move any entries, because prediction is going to put the player's back
 
 	// mapblocks are used to check movement
 	// against lines and things
@@ -72,6 +91,54 @@ struct FBlockmap
 
 	bool VerifyBlockMap(int count, unsigned numlines);
 
+	void LinkThing(FBlockNode *node)
+	{
+		auto &things = blockthings[node->BlockIndex];
+		if (things.Holes >= 8 && things.Holes * 2 >= things.Size() && !keepholes)
+		{
+			CompactThings(things);
+		}
+		node->ThingIndex = things.Push({ node->Me, node, things.NextSeq++, false });
+	}
+
+	// Puts an actor back into the place it was unlinked from.
+	void RelinkThing(FBlockNode *node, bool single)
+	{
+		auto &things = blockthings[node->BlockIndex];
+		auto &thing = things[node->ThingIndex];
+		thing.Me = node->Me;
+		thing.Node = node;
+		thing.SingleBlock = single;
+		things.Holes--;
+	}
+
+	void UnlinkThing(FBlockNode *node)
+	{
+		auto &things = blockthings[node->BlockIndex];
+		auto &thing = things[node->ThingIndex];
+		thing.Me = nullptr;
+		thing.Node = nullptr;
+		thing.SingleBlock = false;
+		things.Holes++;
+	}
+
+	void CompactThings(FBlockThings &things)
+	{
+		unsigned j = 0;
+		for (unsigned i = 0; i < things.Size(); i++)
+		{
+			if (things[i].Me != nullptr)
+			{
+				things[j] = things[i];
+				things[j].Node->ThingIndex = j;
+				j++;
+			}
+		}
+		things.Clamp(j);
+		things.Holes = 0;
+		compactcount++;
+	}
+
 	void Clear()
 	{
 		if (blockmaplump != nullptr)
@@ -79,10 +146,10 @@ struct FBlockmap
 			delete[] blockmaplump;
 			blockmaplump = nullptr;
 		}
-		if (blocklinks != nullptr)
+		if (blockthings != nullptr)
 		{
-			delete[] blocklinks;
-			blocklinks = nullptr;
+			delete[] blockthings;
+			blockthings = nullptr;
 		}
 	}
 
@@ -993,7 +993,7 @@ bool MapLoader::CheckNodes(MapData * map, bool rebuilt, int buildtime)
 typedef TArray<uint8_t> MemFile;
 
 
-static FString CreateCacheName(MapData *map, bool create)
+static FString CreateCacheName(MapData *map, bool create, const char *ext = ".gzc")
 {
 	FString path = M_GetCachePath(create);
 	FString lumpname = fileSystem.GetFileFullPath(map->lumpnum).c_str();
@@ -1003,7 +1003,7 @@ static FString CreateCacheName(MapData *map, bool create)
 
 	lumpname.ReplaceChars('/', '%');
 	lumpname.ReplaceChars(':', '$');
-	path << '/' << lumpname.Right((ptrdiff_t)lumpname.Len() - separator - 1) << ".gzc";
+	path << '/' << lumpname.Right((ptrdiff_t)lumpname.Len() - separator - 1) << ext;
 	return path;
 }
 
@@ -1192,6 +1192,114 @@ bool MapLoader::CheckCachedNodes(MapData *map)
 	return true;
 }
 
+//==========================================================================
+//
+// Blockmap caching
+//
+// A generated blockmap only depends on the vertex positions and the lines
+// connecting them, so these are what the cached data is validated against.
+// This also makes the cache safe to use after the node builder added
+// vertices of its own.
+//
+//==========================================================================
+
+void MapLoader::GetBlockmapChecksum(uint8_t checksum[16])
+{
+	MD5Context md5;
+
+	for (auto &vert : Level->vertexes)
+	{
+		int32_t pos[2] = { LittleLong(int32_t(vert.fX())), LittleLong(int32_t(vert.fY())) };
+		md5.Update((uint8_t*)pos, sizeof(pos));
+	}
+	for (auto &line : Level->lines)
+	{
+		uint32_t ndx[2] = { LittleLong(uint32_t(Index(line.v1))), LittleLong(uint32_t(Index(line.v2))) };
+		md5.Update((uint8_t*)ndx, sizeof(ndx));
+	}
+	md5.Final(checksum);
+}
+
+void MapLoader::CreateCachedBlockmap(MapData *map, const uint8_t checksum[16], unsigned count)
+{
+	TArray<uint32_t> data(count, true);
+	for (unsigned i = 0; i < count; i++)
+	{
+		data[i] = LittleLong(uint32_t(Level->blockmap.blockmaplump[i]));
+	}
+
+	uLongf outlen = compressBound(count * 4);
+	int offset = 4 + 16 + 4;
+	TArray<Bytef> compressed(outlen + offset, true);
+	if (compress(compressed.Data() + offset, &outlen, (const Bytef*)data.Data(), count * 4) != Z_OK) return;
+
+	memcpy(compressed.Data(), "BMAP", 4);
+	memcpy(&compressed[4], checksum, 16);
+	uint32_t len = LittleLong(count);
+	memcpy(&compressed[20], &len, 4);
+
+	FString path = CreateCacheName(map, true, ".gzb");
+	FileWriter *fw = FileWriter::Open(path.GetChars());
+
+	if (fw != nullptr)
+	{
+		const size_t length = outlen + offset;
+		if (fw->Write(compressed.Data(), length) != length)
+		{
+			Printf("Error saving blockmap to file %s\n", path.GetChars());
+		}
+		delete fw;
+	}
+	else
+	{
+		Printf("Cannot open blockmap file %s for writing\n", path.GetChars());
+	}
+}
+
+bool MapLoader::CheckCachedBlockmap(MapData *map, const uint8_t checksum[16])
+{
+	char magic[4] = {0,0,0,0};
+	uint8_t md5[16];
+	uint32_t count;
+
+	FString path = CreateCacheName(map, false, ".gzb");
+	FileReader fr;
+
+	if (!fr.OpenFile(path.GetChars())) return false;
+
+	if (fr.Read(magic, 4) != 4) return false;
+	if (memcmp(magic, "BMAP", 4))  return false;
+
+	if (fr.Read(md5, 16) != 16) return false;
+	if (memcmp(md5, checksum, 16)) return false;
+
+	if (fr.Read(&count, 4) != 4) return false;
+	count = LittleLong(count);
+	if (count < 4 || count >= 0x10000000) return false;
+
+	auto compressed = fr.Read(fr.GetLength() - fr.Tell());
+	TArray<uint32_t> data(count, true);
+	uLongf outlen = count * 4;
+	if (uncompress((Bytef*)data.Data(), &outlen, compressed.bytes(), (uLong)compressed.size()) != Z_OK || outlen != count * 4) return false;
+
+	int *blockmaplump = new int[count];
+	for (unsigned i = 0; i < count; i++)
+	{
+		blockmaplump[i] = int(LittleLong(data[i]));
+	}
+
+	// This is cheap compared to generating the blockmap and protects against damaged files.
+	std::swap(Level->blockmap.blockmaplump, blockmaplump);
+	if (!Level->blockmap.VerifyBlockMap(count, Level->lines.Size()))
+	{
+		std::swap(Level->blockmap.blockmaplump, blockmaplump);
+		delete[] blockmaplump;
+		return false;
+	}
+	delete[] blockmaplump;
+	return true;
+}
+
 UNSAFE_CCMD(clearnodecache)
 {
 	FileSys::FileList list;
@@ -93,6 +93,7 @@ enum
 
 CVAR (Bool, genblockmap, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, gennodes, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
+EXTERN_CVAR (Bool, gl_cachenodes)
 
 inline bool P_LoadBuildMap(uint8_t *mapdata, size_t len, FMapThing **things, int *numthings)
 {
@@ -2317,7 +2318,7 @@ static void CreatePackedBlockmap (TArray<int> &BlockMap, TArray<int> *blocks, in
 }
 
 
-void MapLoader::CreateBlockMap ()
+unsigned MapLoader::CreateBlockMap ()
 {
 	enum
 	{
@@ -2334,7 +2335,7 @@ void MapLoader::CreateBlockMap ()
 	int line;
 
 	if (Level->vertexes.Size() == 0)
-		return;
+		return 0;
 
 	// Find map extents for the blockmap
 	dminx = dmaxx = Level->vertexes[0].fX();
@@ -2489,6 +2490,37 @@ void MapLoader::CreateBlockMap ()
 	{
 		Level->blockmap.blockmaplump[ii] = BlockMap[ii];
 	}
+	return BlockMap.Size();
+}
+
+//===========================================================================
+//
+// Generates the blockmap or loads a previously generated one from the cache.
+// Blockmaps are a lot cheaper to build than nodes so only large maps,
+// where the cost becomes noticeable, get cached.
+//
+//===========================================================================
+
+void MapLoader::GenerateBlockMap (MapData *map)
+{
+	uint8_t checksum[16];
+
+	GetBlockmapChecksum(checksum);
+	if (CheckCachedBlockmap(map, checksum))
+	{
+		DPrintf (DMSG_SPAMMY, "Using cached BLOCKMAP\n");
+		return;
+	}
+
+	DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
+	uint64_t startTime = I_msTime();
+	unsigned count = CreateBlockMap ();
+	uint64_t buildtime = I_msTime() - startTime;
+
+	if (count > 0 && Level->maptype != MAPTYPE_BUILD && gl_cachenodes && buildtime >= 20)
+	{
+		CreateCachedBlockmap(map, checksum, count);
+	}
 }
 
 
@@ -2596,8 +2628,7 @@ void MapLoader::LoadBlockMap (MapData * map)
 		Args->CheckParm("-blockmap")
 		)
 	{
-		DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-		CreateBlockMap ();
+		GenerateBlockMap (map);
 	}
 	else
 	{
@@ -2626,8 +2657,7 @@ void MapLoader::LoadBlockMap (MapData * map)
 
 		if (!Level->blockmap.VerifyBlockMap(count, Level->lines.Size()))
 		{
-			DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-			CreateBlockMap();
+			GenerateBlockMap (map);
 		}
 
 	}
@@ -2639,8 +2669,9 @@ void MapLoader::LoadBlockMap (MapData * map)
 
 	// clear out mobj chains
 	count = Level->blockmap.bmapwidth*Level->blockmap.bmapheight;
-	Level->blockmap.blocklinks = new FBlockNode *[count];
-	memset (Level->blockmap.blocklinks, 0, count*sizeof(*Level->blockmap.blocklinks));
+	Level->blockmap.blockthings = new FBlockThings[count];
+	Level->blockmap.compactcount = 0;
+	Level->blockmap.keepholes = false;
 	Level->blockmap.blockmap = Level->blockmap.blockmaplump+4;
 }
 
@@ -3242,7 +3273,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 
 	InitRenderInfo();				// create hardware independent renderer resources for the level. This must be done BEFORE the PolyObj Spawn!!!
 	Level->ClearDynamic3DFloorData();	// CreateVBO must be run on the plain 3D floor data.
-	CreateVBO(screen->mVertexData, Level->sectors);
+	if (screen->mVertexData) CreateVBO(screen->mVertexData, Level->sectors);	// there is none when running without video output.
 
 	screen->InitLightmap(Level->LMTextureSize, Level->LMTextureCount, Level->LMTextureData);
 
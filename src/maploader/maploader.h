@@ -166,6 +166,8 @@ private:
 	bool LoadNodes(FileReader &lump);
 	bool DoLoadGLNodes(FileReader * lumps);
 	void CreateCachedNodes(MapData *map);
+	void GetBlockmapChecksum(uint8_t checksum[16]);
+	void CreateCachedBlockmap(MapData *map, const uint8_t checksum[16], unsigned count);
 
 	// Render info
 	void PrepareSectorData();
@@ -232,7 +234,8 @@ private:
 	void AllocateSideDefs(MapData *map, int count);
 	void ProcessSideTextures(bool checktranmap, side_t *sd, sector_t *sec, intmapsidedef_t *msd, int special, int tag, short *alpha, FMissingTextureTracker &missingtex);
 	void SetMapThingUserData(AActor *actor, unsigned udi);
-	void CreateBlockMap();
+	unsigned CreateBlockMap();
+	void GenerateBlockMap(MapData *map);
 	void PO_Init(void);
 
 	// During map init the items' own Index functions should not be used.
@@ -283,6 +286,7 @@ public:
 	template<class nodetype, class subsectortype> bool LoadNodes(MapData * map);
 	bool LoadGLNodes(MapData * map);
 	bool CheckCachedNodes(MapData *map);
+	bool CheckCachedBlockmap(MapData *map, const uint8_t checksum[16]);
 	bool CheckNodes(MapData * map, bool rebuilt, int buildtime);
 	bool CheckForGLNodes();
 
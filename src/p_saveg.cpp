@@ -65,6 +65,7 @@
 #include "d_net.h"
 
 EXTERN_CVAR(Bool, save_formatted)
+EXTERN_CVAR(Bool, save_binary)
 
 //==========================================================================
 //
@@ -1090,10 +1091,11 @@ void FLevelLocals::Serialize(FSerializer &arc, bool hubload)
 //==========================================================================
 //
 // Archives the current level
+// An uncompressed snapshot is only meant for being written to a savegame.
 //
 //==========================================================================
 
-void FLevelLocals::SnapshotLevel()
+void FLevelLocals::SnapshotLevel(bool compress)
 {
 	info->Snapshot.Clean();
 
@@ -1101,11 +1103,11 @@ void FLevelLocals::SnapshotLevel()
 	{
 		FDoomSerializer arc(this);
 
-		if (arc.OpenWriter(save_formatted))
+		if (arc.OpenWriter(save_formatted, save_binary && !save_formatted))
 		{
 			SaveVersion = SAVEVER;
 			Serialize(arc, false);
-			info->Snapshot = arc.GetCompressedOutput();
+			info->Snapshot = arc.GetCompressedOutput(compress);
 		}
 	}
 }
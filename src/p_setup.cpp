@@ -94,6 +94,7 @@ extern unsigned int R_OldBlend;
 //
 //===========================================================================
 void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitlist);
+void hw_ClearPrefetch();
 
 static void AddToList(uint8_t *hitlist, FTextureID texid, int bitmask)
 {
@@ -565,6 +566,9 @@ void P_SetupLevel(FLevelLocals *Level, int position, bool newGame)
 	// [RH] Remove all particles
 	P_ClearParticles(Level);
 
+	if (V_IsHardwareRenderer())
+		hw_ClearPrefetch();
+
 	// preload graphics and sounds
 	if (precache)
 	{
@@ -43,6 +43,8 @@
 extern gamestate_t wipegamestate;
 extern uint8_t globalfreeze, globalchangefreeze;
 
+cycle_t EventCycles;
+
 //==========================================================================
 //
 // P_CheckTickerPaused
@@ -144,6 +146,7 @@ void P_Ticker (void)
 
 	P_ResetSightCounters (false);
 	R_ClearInterpolationPath();
+	EventCycles.Reset();
 
 	// Since things will be moving, it's okay to interpolate them in the renderer.
 	r_NoInterpolate = false;
@@ -168,7 +171,9 @@ void P_Ticker (void)
 				P_PlayerThink(Level->Players[i]);
 
 		// [ZZ] call the WorldTick hook
+		EventCycles.Clock();
 		Level->localEventManager->WorldTick();
+		EventCycles.Unclock();
 		Level->Tick();			// [RH] let the level tick
 		Level->Thinkers.RunThinkers(Level);
 
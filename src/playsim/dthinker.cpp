@@ -45,9 +45,10 @@
 #include "v_video.h"
 #include "g_cvars.h"
 #include "d_main.h"
+#include "ctpl.h"
 
-static int ThinkCount;
-static cycle_t ThinkCycles;
+static int ThinkCount, ParallelThinkCount;
+cycle_t ThinkCycles;
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
 extern int BotWTG;
@@ -67,8 +68,20 @@ struct ProfileInfo
 
 static TMap<FName, ProfileInfo> Profiles;
 static unsigned int profilethinkers, profilelimit;
+static bool profileaccumulate;
 DThinker *NextToThink;
 
+CUSTOM_CVAR(Int, cl_thinkerthreads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > 16) self = 16;
+}
+
+// Runs of side-effect-local thinkers shorter than this are not worth distributing.
+enum { MIN_PARALLEL_THINKERS = 256 };
+
+static ctpl::thread_pool thinkerPool;	// no threads until thinkers first run in parallel
+
 //==========================================================================
 //
 //
@@ -101,6 +114,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 	int i, count;
 
 	ThinkCount = 0;
+	ParallelThinkCount = 0;
 	ThinkCycles.Reset();
 	BotSupportCycles.Reset();
 	ActionCycles.Reset();
@@ -139,7 +153,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		}
 	};
 
-	if (!profilethinkers)
+	if (!profilethinkers && !profileaccumulate)
 	{
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
@@ -170,7 +184,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 	}
 	else
 	{
-		Profiles.Clear();
+		if (!profileaccumulate) Profiles.Clear();
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
@@ -202,8 +216,10 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 			}
 			prof.timer.Unclock();
 		}
+	}
 
-
+	if (profilethinkers)
+	{
 		struct SortedProfileInfo
 		{
 			const char* className;
@@ -265,6 +281,33 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 	ThinkCycles.Unclock();
 }
 
+//==========================================================================
+//
+// Collects per-class thinker times over any number of tics instead of
+// a single one. Profiling ticks all thinkers serially.
+//
+//==========================================================================
+
+void P_StartThinkerProfiling()
+{
+	Profiles.Clear();
+	profileaccumulate = true;
+}
+
+void P_StopThinkerProfiling(TArray<FThinkerProfile> &results)
+{
+	profileaccumulate = false;
+	results.Clear();
+
+	auto it = TMap<FName, ProfileInfo>::Iterator(Profiles);
+	TMap<FName, ProfileInfo>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		results.Push({ pair->Key, pair->Value.numcalls, pair->Value.timer.TimeMS() });
+	}
+	Profiles.Clear();
+}
+
 //==========================================================================
 //
 // Destroy every thinker
@@ -577,6 +620,18 @@ void FThinkerList::SaveList(FSerializer &arc)
 	}
 }
 
+//==========================================================================
+//
+// Script classes can override Tick() and may not be ticked off the main thread.
+//
+//==========================================================================
+
+static const void *GetTickDomain(DThinker *node)
+{
+	if (node->GetClass()->bRuntimeClass) return nullptr;
+	return node->TickDomain();
+}
+
 //==========================================================================
 //
 //
@@ -593,8 +648,14 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 		return 0;
 	}
 
+	bool parallel = dest == nullptr && cl_thinkerthreads > 1;
 	while (node != Sentinel)
 	{
+		if (parallel && !(node->ObjectFlags & OF_JustSpawned) && GetTickDomain(node) != nullptr)
+		{
+			node = TickLocalThinkers(node, count);
+			continue;
+		}
 		++count;
 		NextToThink = node->NextThinker;
 		if (node->ObjectFlags & OF_JustSpawned)
@@ -623,6 +684,90 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 	return count;
 }
 
+//==========================================================================
+//
+// Ticks a run of consecutive thinkers that declared a tick domain.
+// Thinkers sharing a domain are ticked on the same thread in list order,
+// so the result is identical to ticking the entire run serially.
+// Returns the first thinker after the run.
+//
+//==========================================================================
+
+DThinker *FThinkerList::TickLocalThinkers(DThinker *node, int &count)
+{
+	static TArray<DThinker *> batch;
+	static TArray<const void *> domains;
+	static TArray<int> groupnext;	// next thinker in the same domain, -1 for the last one.
+	static TArray<int> groups;		// first thinker of each domain
+	static TMap<const void *, int> lastingroup;
+
+	batch.Clear();
+	domains.Clear();
+	while (node != Sentinel && !(node->ObjectFlags & OF_JustSpawned))
+	{
+		auto domain = GetTickDomain(node);
+		if (domain == nullptr) break;
+		if (!(node->ObjectFlags & OF_EuthanizeMe))
+		{
+			batch.Push(node);
+			domains.Push(domain);
+		}
+		++count;
+		node = node->NextThinker;
+	}
+	ThinkCount += batch.Size();
+
+	if (batch.Size() < MIN_PARALLEL_THINKERS)
+	{
+		for (auto thinker : batch)
+		{
+			thinker->Tick();
+		}
+		return node;
+	}
+
+	groups.Clear();
+	groupnext.Resize(batch.Size());
+	lastingroup.Clear();
+	for (unsigned i = 0; i < batch.Size(); i++)
+	{
+		groupnext[i] = -1;
+		int *last = lastingroup.CheckKey(domains[i]);
+		if (last == nullptr) groups.Push(i);
+		else groupnext[*last] = i;
+		lastingroup[domains[i]] = i;
+	}
+
+	int numthreads = cl_thinkerthreads;
+	if (thinkerPool.size() < numthreads - 1) thinkerPool.resize(numthreads - 1);
+
+	std::atomic<unsigned> nextgroup{ 0 };
+	auto work = [&](int)
+	{
+		for (unsigned g = nextgroup++; g < groups.Size(); g = nextgroup++)
+		{
+			for (int i = groups[g]; i >= 0; i = groupnext[i])
+			{
+				batch[i]->Tick();
+			}
+		}
+	};
+
+	// The main thread takes part in the work as well.
+	std::future<void> futures[16];
+	for (int i = 1; i < numthreads; i++)
+	{
+		futures[i] = thinkerPool.push(work);
+	}
+	work(0);
+	for (int i = 1; i < numthreads; i++)
+	{
+		futures[i].wait();
+	}
+	ParallelThinkCount += batch.Size();
+	return node;
+}
+
 //==========================================================================
 //
 //
@@ -1046,6 +1191,6 @@ DThinker *FThinkerIterator::Next (bool exact)
 ADD_STAT (think)
 {
 	FString out;
-	out.Format ("Think time = %04.2f ms - %d thinkers, Action = %04.2f ms", ThinkCycles.TimeMS(), ThinkCount, ActionCycles.TimeMS());
+	out.Format ("Think time = %04.2f ms - %d thinkers (%d parallel), Action = %04.2f ms", ThinkCycles.TimeMS(), ThinkCount, ParallelThinkCount, ActionCycles.TimeMS());
 	return out;
 }
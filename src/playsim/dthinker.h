@@ -61,6 +61,7 @@ struct FThinkerList
 	void DestroyThinkers();
 	bool DoDestroyThinkers();
 	int TickThinkers(FThinkerList *dest);	// Returns: # of thinkers ticked
+	DThinker *TickLocalThinkers(DThinker *node, int &count);
 	int ProfileThinkers(FThinkerList *dest);
 	void SaveList(FSerializer &arc);
 
@@ -101,6 +102,11 @@ public:
 	virtual ~DThinker ();
 	virtual void Tick ();
 	void CallTick();
+
+	// Thinkers whose Tick() modifies nothing but their own fields and the object returned here
+	// may be ticked concurrently with other such thinkers that return a different object.
+	// Tick() must not spawn or destroy anything and must not use any random number generator.
+	virtual const void *TickDomain() const { return nullptr; }
 	virtual void PostBeginPlay ();	// Called just before the first tick
 	virtual void CallPostBeginPlay(); // different in actor.
 	virtual void PostSerialize();
@@ -168,5 +174,14 @@ public:
 	}
 };
 
+struct FThinkerProfile
+{
+	FName ClassName;
+	int NumCalls;
+	double TimeMS;
+};
+
+void P_StartThinkerProfiling();
+void P_StopThinkerProfiling(TArray<FThinkerProfile> &results);
 
 #endif //__DTHINKER_H__
@@ -58,6 +58,7 @@ public:
 	void Construct(sector_t *sector, int upper, int lower, int utics, int ltics);
 	void		Serialize(FSerializer &arc);
 	void		Tick();
+	const void *TickDomain() const override { return m_Sector; }
 protected:
 	int 		m_Count;
 	int 		m_MinLight;
@@ -73,6 +74,7 @@ public:
 	void Construct(sector_t *sector);
 	void		Serialize(FSerializer &arc);
 	void		Tick();
+	const void *TickDomain() const override { return m_Sector; }
 protected:
 	int 		m_MinLight;
 	int 		m_MaxLight;
@@ -87,6 +89,7 @@ public:
 	void Construct(sector_t *sector, int start, int end, int tics, bool oneshot);
 	void		Serialize(FSerializer &arc);
 	void		Tick();
+	const void *TickDomain() const override { return m_OneShot ? nullptr : m_Sector; }	// one shot glows destroy themselves.
 protected:
 	int			m_Start;
 	int			m_End;
@@ -107,6 +110,7 @@ public:
 
 	void		Serialize(FSerializer &arc);
 	void		Tick();
+	const void *TickDomain() const override { return m_Sector; }
 protected:
 	uint8_t		m_BaseLevel;
 	uint8_t		m_Phase;
@@ -274,6 +274,29 @@ void DScroller::Tick ()
 	}
 }
 
+//-----------------------------------------------------------------------------
+//
+// Texture scrollers only modify their own side or sector.
+// Carrying scrollers affect actors and must tick serially.
+//
+//-----------------------------------------------------------------------------
+
+const void *DScroller::TickDomain() const
+{
+	switch (m_Type)
+	{
+	case EScroll::sc_side:
+		return m_Side;
+
+	case EScroll::sc_floor:
+	case EScroll::sc_ceiling:
+		return m_Sector;
+
+	default:
+		return nullptr;
+	}
+}
+
 //-----------------------------------------------------------------------------
 //
 // Add_Scroller()
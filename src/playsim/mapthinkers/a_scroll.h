@@ -28,6 +28,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	const void *TickDomain() const override;
 
 	bool AffectsWall (side_t * wall) const { return m_Side == wall; }
 	side_t *GetWall () const { return m_Side; }
@@ -319,6 +319,9 @@ void P_Recalculate3DFloors(sector_t * sector)
 	TArray<F3DFloor*> & ffloors=sector->e->XFloor.ffloors;
 	TArray<lightlist_t> & lightlist = sector->e->XFloor.lightlist;
 
+	// Clipping changes which 3D floors exist.
+	P_InvalidateSightCache();
+
 	// Sort the floors top to bottom for quicker access here and later
 	// Translucent and swimmable floors are split if they overlap with solid ones.
 	if (ffloors.Size()>1)
@@ -59,6 +59,8 @@ bool P_Scroll3dMidtex(sector_t *sector, int crush, double move, bool ceiling, bo
 {
 	extsector_t::midtex::plane &scrollplane = ceiling? sector->e->Midtex.Ceiling : sector->e->Midtex.Floor;
 
+	if (scrollplane.AttachedLines.Size() > 0) P_InvalidateSightCache();
+
 	// First step: Change all lines' texture offsets
 	for(unsigned i = 0; i < scrollplane.AttachedLines.Size(); i++)
 	{
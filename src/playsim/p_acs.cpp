@@ -78,6 +78,8 @@
 #include "s_music.h"
 #include "v_video.h"
 #include "texturemanager.h"
+#include "m_crc32.h"
+#include "vmbuilder.h"
 
 	// P-codes for ACS scripts
 	enum
@@ -546,6 +548,9 @@ FRandom pr_acs ("ACS");
 // potentially get used with recursive functions.
 #define STACK_SIZE 4096
 
+// Scripts that run this many instructions in one tic are terminated.
+#define RUNAWAY_LIMIT 2000000
+
 // HUD message flags
 #define HUDMSG_LOG					(0x80000000)
 #define HUDMSG_COLORSTRING			(0x40000000)
@@ -716,6 +721,8 @@ protected:
 
 	TArray<FString> ACS_StringBuilderStack;
 
+	bool RunCompiledCode(int *&pc, int32_t *stack, int &sp, unsigned int &runaway, int specialargmask);
+
 	inline void STRINGBUILDER_START(FString &Builder)
 	{
 		if (Builder.IsNotEmpty() || ACS_StringBuilderStack.Size())
@@ -773,6 +780,9 @@ protected:
 	void SetActorTeleFog(AActor *activator, int tid, FString telefogsrc, FString telefogdest);
 	int SwapActorTeleFog(AActor *activator, int tid);
 
+public:
+	bool ExecuteCompiledSpecial(int special, int arg1, int arg2, int arg3, int arg4, int arg5);
+
 
 private:
 	DLevelScript() = default;
@@ -2203,6 +2213,7 @@ FBehavior::FBehavior()
 	Data = NULL;
 	Format = ACS_Unknown;
 	LumpNum = -1;
+	DataCRC = 0;
 	memset (MapVarStore, 0, sizeof(MapVarStore));
 	ModuleName[0] = 0;
 	FunctionProfileData = NULL;
@@ -2677,6 +2688,7 @@ bool FBehavior::Init(FLevelLocals *Level, int lumpnum, FileReader * fr, int len,
 		}
 	}
 
+	DataCRC = CalcCRC32 (Data, DataSize);
 	DPrintf (DMSG_NOTIFY, "Loaded %d scripts, %d functions\n", NumScripts, NumFunctions);
 	return true;
 }
@@ -6260,6 +6272,8 @@ doplaysound:			if (funcIndex == ACSF_PlayActorSound)
 					if (repeat > 0) Level->lines[line].flags |= ML_REPEAT_SPECIAL;
 					else if (repeat == 0) Level->lines[line].flags &= ~ML_REPEAT_SPECIAL;
 				}
+				// Activation decides whether monsters can see past block everything lines.
+				P_InvalidateSightCache();
 			}
 			break;
 
@@ -6871,6 +6885,1093 @@ PClass *DLevelScript::GetClassForIndex(int index) const
 	return PClass::FindActor(Level->Behaviors.LookupString(index));
 }
 
+//==========================================================================
+//
+// ACS translation
+//
+// Script bodies are translated to VM bytecode, which the JIT turns into
+// native code when vm_jit is on. A translated region starts at the p-code
+// offset the interpreter is about to execute and covers everything that
+// can be reached from there through instructions the translator knows.
+// The ACS stack lives in VM registers and is written back at every exit,
+// so the interpreter can always pick up at the exit offset. Delays and
+// waits leave through such an exit too, which means a script's state
+// between tics is still just its p-code offset, as savegames expect.
+//
+// Anything else, such as function calls, strings and most engine
+// functions, ends the region at that instruction. The interpreter runs
+// it and then looks for a region at the next offset. Division by zero and
+// the runaway limit are also left to the interpreter, which reports them.
+//
+//==========================================================================
+
+CVAR(Bool, acs_compile, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+enum
+{
+	ACSC_MAXDEPTH = 32,		// deepest ACS stack a region keeps in registers
+	ACSC_MAXOPS = 4096,		// most instructions translated per region
+	ACSC_MINOPS = 8,		// regions smaller than this are not worth a VM call
+};
+
+// Passed to translated code. Everything but the first three fields is
+// read and written by the code itself.
+struct FACSCompiledFrame
+{
+	int32_t *Locals;
+	int32_t **MapVars;
+	DLevelScript *Script;
+	int32_t Runaway;
+	int32_t ExitOfs;
+	int32_t State;
+	int32_t StateData;
+	int32_t SP;
+	int32_t DelayBias;
+	int32_t SpecialArgMask;
+	int32_t Stack[ACSC_MAXDEPTH];
+};
+
+// Translated regions are shared by all modules with the same code, so that
+// revisiting a map does not translate its scripts again.
+struct FACSCompiledRegion
+{
+	enum { Untried, Rejected, Compiled };
+
+	VMFunction *Func = nullptr;		// cleared by PClass::StaticShutdown
+	int Status = Untried;
+	int DataSize = 0;
+	int Depth = 0;
+	int NumLocals = 0;
+};
+
+static TMap<uint64_t, FACSCompiledRegion *> ACSCompiledRegions;
+static VMFunction *ACSCompiledSpecial;
+
+//==========================================================================
+//
+// DLevelScript :: ExecuteCompiledSpecial
+//
+// Runs a line special for translated code. Returns false if the special
+// stopped this script, in which case the translated code must return.
+//
+//==========================================================================
+
+bool DLevelScript::ExecuteCompiledSpecial(int special, int arg1, int arg2, int arg3, int arg4, int arg5)
+{
+	P_ExecuteSpecial(Level, special, activationline, activator, backSide, arg1, arg2, arg3, arg4, arg5);
+	return state == SCRIPT_Running;
+}
+
+static int ExecuteCompiledSpecial(VM_ARGS)
+{
+	auto frame = (FACSCompiledFrame *)param[0].a;
+	ACTION_RETURN_BOOL(frame->Script->ExecuteCompiledSpecial(param[1].i, param[2].i, param[3].i, param[4].i, param[5].i, param[6].i));
+}
+
+//==========================================================================
+//
+// FACSTranslator
+//
+//==========================================================================
+
+class FACSTranslator
+{
+public:
+	FACSTranslator(const uint8_t *data, uint32_t size, ACSFormat format, int numlocals)
+		: Data(data), Size(size), Format(format), NumLocals(numlocals)
+	{
+	}
+
+	bool Analyze(uint32_t seed, int depth);
+	VMScriptFunction *Emit(const char *name);
+
+private:
+	enum EVarClass { VAR_Script, VAR_Map, VAR_World, VAR_Global };
+	enum EVarOp { VOP_Assign, VOP_Push, VOP_Inc, VOP_Dec, VOP_Math };
+	enum EKind { KIND_Plain, KIND_Goto, KIND_Branch, KIND_Case, KIND_Wait };
+
+	struct Op
+	{
+		uint32_t Ofs;
+		uint32_t Next;			// offset of the following instruction
+		uint32_t ArgOfs;		// offset of the first operand
+		int PCode;
+		int Arg[6];
+		int Depth;				// stack depth before this instruction
+		int Pops, Pushes;
+		int Kind;
+		bool Translated;
+		bool Leader;
+	};
+
+	struct Exit
+	{
+		uint32_t Ofs;
+		int Depth;
+		int Adjust;				// instructions counted for the block but not run
+		int State;
+		size_t Address;
+	};
+
+	bool ReadByte(uint32_t &ofs, int &val) const;
+	bool ReadLong(uint32_t &ofs, int &val) const;
+	bool ReadOperand(uint32_t &ofs, int &val) const;
+	bool Decode(Op &op) const;
+	bool FindVarOp(int pcode, int &cls, int &vop, int &vmop) const;
+
+	int Slot(int i) const { return SlotBase + i; }
+	void EmitOp(const Op &op, int blockops, int index);
+	void EmitBool(int opcode, int check, int b, int c, int dest);
+	void EmitVarAddress(int cls, int index, int &areg, int &konst);
+	void EmitSpecial(const Op &op, int blockops, int index, int numargs, bool stackargs, bool masked);
+	void JumpToLabel(uint32_t ofs);
+	void JumpToExit(uint32_t ofs, int depth, int adjust, int state);
+	void EmitExit(const Exit &exit);
+
+	const uint8_t *Data;
+	uint32_t Size;
+	ACSFormat Format;
+	int NumLocals;
+	uint32_t Seed = 0;
+	int SeedDepth = 0;
+	int MaxDepth = 0;
+
+	TArray<Op> Ops;
+	TMap<uint32_t, unsigned> OpIndex;
+	TMap<uint32_t, size_t> Labels;
+	TArray<std::pair<size_t, uint32_t>> LabelJumps;
+	TArray<Exit> Exits;
+	TArray<std::pair<size_t, unsigned>> ExitJumps;
+
+	VMFunctionBuilder *Build = nullptr;
+	int FrameReg, LocalsReg, MapVarsReg, WorldReg, GlobalReg, TempAReg;
+	int SlotBase, RunawayReg, TempReg, BiasReg, MaskReg, ArgReg;
+	int Zero;
+};
+
+// Script, map, world and global variants of each variable instruction.
+static const struct { int PCode[4]; int Op; int VMOp; } ACSCVarOps[] =
+{
+	{ { PCD_ASSIGNSCRIPTVAR, PCD_ASSIGNMAPVAR, PCD_ASSIGNWORLDVAR, PCD_ASSIGNGLOBALVAR }, 0, 0 },
+	{ { PCD_PUSHSCRIPTVAR, PCD_PUSHMAPVAR, PCD_PUSHWORLDVAR, PCD_PUSHGLOBALVAR }, 1, 0 },
+	{ { PCD_INCSCRIPTVAR, PCD_INCMAPVAR, PCD_INCWORLDVAR, PCD_INCGLOBALVAR }, 2, 0 },
+	{ { PCD_DECSCRIPTVAR, PCD_DECMAPVAR, PCD_DECWORLDVAR, PCD_DECGLOBALVAR }, 3, 0 },
+	{ { PCD_ADDSCRIPTVAR, PCD_ADDMAPVAR, PCD_ADDWORLDVAR, PCD_ADDGLOBALVAR }, 4, OP_ADD_RR },
+	{ { PCD_SUBSCRIPTVAR, PCD_SUBMAPVAR, PCD_SUBWORLDVAR, PCD_SUBGLOBALVAR }, 4, OP_SUB_RR },
+	{ { PCD_MULSCRIPTVAR, PCD_MULMAPVAR, PCD_MULWORLDVAR, PCD_MULGLOBALVAR }, 4, OP_MUL_RR },
+	{ { PCD_DIVSCRIPTVAR, PCD_DIVMAPVAR, PCD_DIVWORLDVAR, PCD_DIVGLOBALVAR }, 4, OP_DIV_RR },
+	{ { PCD_MODSCRIPTVAR, PCD_MODMAPVAR, PCD_MODWORLDVAR, PCD_MODGLOBALVAR }, 4, OP_MOD_RR },
+	{ { PCD_ANDSCRIPTVAR, PCD_ANDMAPVAR, PCD_ANDWORLDVAR, PCD_ANDGLOBALVAR }, 4, OP_AND_RR },
+	{ { PCD_ORSCRIPTVAR, PCD_ORMAPVAR, PCD_ORWORLDVAR, PCD_ORGLOBALVAR }, 4, OP_OR_RR },
+	{ { PCD_EORSCRIPTVAR, PCD_EORMAPVAR, PCD_EORWORLDVAR, PCD_EORGLOBALVAR }, 4, OP_XOR_RR },
+	{ { PCD_LSSCRIPTVAR, PCD_LSMAPVAR, PCD_LSWORLDVAR, PCD_LSGLOBALVAR }, 4, OP_SLL_RR },
+	{ { PCD_RSSCRIPTVAR, PCD_RSMAPVAR, PCD_RSWORLDVAR, PCD_RSGLOBALVAR }, 4, OP_SRA_RR },
+};
+
+bool FACSTranslator::FindVarOp(int pcode, int &cls, int &vop, int &vmop) const
+{
+	for (auto &entry : ACSCVarOps)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			if (entry.PCode[i] == pcode)
+			{
+				cls = i;
+				vop = entry.Op;
+				vmop = entry.VMOp;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool FACSTranslator::ReadByte(uint32_t &ofs, int &val) const
+{
+	if (ofs >= Size) return false;
+	val = Data[ofs++];
+	return true;
+}
+
+bool FACSTranslator::ReadLong(uint32_t &ofs, int &val) const
+{
+	if (ofs >= Size || Size - ofs < 4) return false;
+	val = int32_t(Data[ofs] | (Data[ofs+1] << 8) | (Data[ofs+2] << 16) | (uint32_t(Data[ofs+3]) << 24));
+	ofs += 4;
+	return true;
+}
+
+// Same as NEXTBYTE in the interpreter.
+bool FACSTranslator::ReadOperand(uint32_t &ofs, int &val) const
+{
+	return Format == ACS_LittleEnhanced ? ReadByte(ofs, val) : ReadLong(ofs, val);
+}
+
+//==========================================================================
+//
+// FACSTranslator :: Decode
+//
+// Reads the instruction at op.Ofs the way RunScript does. Returns false
+// for anything that is not translated.
+//
+//==========================================================================
+
+bool FACSTranslator::Decode(Op &op) const
+{
+	uint32_t ofs = op.Ofs;
+	int pcd, cls, vop, vmop;
+
+	if (Format == ACS_LittleEnhanced)
+	{
+		if (!ReadByte(ofs, pcd)) return false;
+		if (pcd >= 256-16)
+		{
+			int ext;
+			if (!ReadByte(ofs, ext)) return false;
+			pcd = (256-16) + ((pcd - (256-16)) << 8) + ext;
+		}
+	}
+	else if (!ReadLong(ofs, pcd)) return false;
+
+	op.PCode = pcd;
+	op.ArgOfs = ofs;
+	op.Pops = op.Pushes = 0;
+	op.Kind = KIND_Plain;
+
+	switch (pcd)
+	{
+	case PCD_NOP:
+		break;
+
+	case PCD_PUSHNUMBER:
+		if (!ReadLong(ofs, op.Arg[0])) return false;
+		op.Pushes = 1;
+		break;
+
+	case PCD_PUSHBYTE:
+		ofs += 1;
+		op.Pushes = 1;
+		break;
+
+	case PCD_PUSH2BYTES:
+	case PCD_PUSH3BYTES:
+	case PCD_PUSH4BYTES:
+	case PCD_PUSH5BYTES:
+		op.Pushes = pcd - PCD_PUSH2BYTES + 2;
+		ofs += op.Pushes;
+		break;
+
+	case PCD_PUSHBYTES:
+		if (!ReadByte(ofs, op.Pushes)) return false;
+		op.ArgOfs = ofs;
+		ofs += op.Pushes;
+		break;
+
+	case PCD_DUP:
+		op.Pops = 1;
+		op.Pushes = 2;
+		break;
+
+	case PCD_SWAP:
+		op.Pops = op.Pushes = 2;
+		break;
+
+	case PCD_DROP:
+		op.Pops = 1;
+		break;
+
+	case PCD_ADD:
+	case PCD_SUBTRACT:
+	case PCD_MULTIPLY:
+	case PCD_DIVIDE:
+	case PCD_MODULUS:
+	case PCD_EQ:
+	case PCD_NE:
+	case PCD_LT:
+	case PCD_GT:
+	case PCD_LE:
+	case PCD_GE:
+	case PCD_ANDLOGICAL:
+	case PCD_ORLOGICAL:
+	case PCD_ANDBITWISE:
+	case PCD_ORBITWISE:
+	case PCD_EORBITWISE:
+	case PCD_LSHIFT:
+	case PCD_RSHIFT:
+		op.Pops = 2;
+		op.Pushes = 1;
+		break;
+
+	case PCD_NEGATELOGICAL:
+	case PCD_NEGATEBINARY:
+	case PCD_UNARYMINUS:
+		op.Pops = op.Pushes = 1;
+		break;
+
+	case PCD_GOTO:
+		if (!ReadLong(ofs, op.Arg[0])) return false;
+		op.Kind = KIND_Goto;
+		break;
+
+	case PCD_IFGOTO:
+	case PCD_IFNOTGOTO:
+		if (!ReadLong(ofs, op.Arg[0])) return false;
+		op.Pops = 1;
+		op.Kind = KIND_Branch;
+		break;
+
+	case PCD_CASEGOTO:
+		if (!ReadLong(ofs, op.Arg[1]) || !ReadLong(ofs, op.Arg[0])) return false;
+		op.Kind = KIND_Case;
+		break;
+
+	case PCD_DELAY:
+		op.Pops = 1;
+		break;
+
+	case PCD_DELAYDIRECT:
+		if (!ReadLong(ofs, op.Arg[0])) return false;
+		break;
+
+	case PCD_DELAYDIRECTB:
+		if (!ReadByte(ofs, op.Arg[0])) return false;
+		break;
+
+	case PCD_TAGWAIT:
+	case PCD_POLYWAIT:
+		op.Pops = 1;
+		op.Kind = KIND_Wait;
+		break;
+
+	case PCD_TAGWAITDIRECT:
+	case PCD_POLYWAITDIRECT:
+		if (!ReadLong(ofs, op.Arg[0])) return false;
+		op.Kind = KIND_Wait;
+		break;
+
+	case PCD_SUSPEND:
+		op.Kind = KIND_Wait;
+		break;
+
+	case PCD_LSPEC1:
+	case PCD_LSPEC2:
+	case PCD_LSPEC3:
+	case PCD_LSPEC4:
+	case PCD_LSPEC5:
+		if (!ReadOperand(ofs, op.Arg[0])) return false;
+		op.Pops = pcd - PCD_LSPEC1 + 1;
+		break;
+
+	case PCD_LSPEC1DIRECT:
+	case PCD_LSPEC2DIRECT:
+	case PCD_LSPEC3DIRECT:
+	case PCD_LSPEC4DIRECT:
+	case PCD_LSPEC5DIRECT:
+		if (!ReadOperand(ofs, op.Arg[0])) return false;
+		for (int i = 0; i <= pcd - PCD_LSPEC1DIRECT; i++)
+		{
+			if (!ReadLong(ofs, op.Arg[i + 1])) return false;
+		}
+		break;
+
+	case PCD_LSPEC1DIRECTB:
+	case PCD_LSPEC2DIRECTB:
+	case PCD_LSPEC3DIRECTB:
+	case PCD_LSPEC4DIRECTB:
+	case PCD_LSPEC5DIRECTB:
+		for (int i = 0; i <= pcd - PCD_LSPEC1DIRECTB + 1; i++)
+		{
+			if (!ReadByte(ofs, op.Arg[i])) return false;
+		}
+		break;
+
+	default:
+		if (!FindVarOp(pcd, cls, vop, vmop)) return false;
+		if (!ReadOperand(ofs, op.Arg[0])) return false;
+
+		// Out of range variables are errors the interpreter reports.
+		if ((cls == VAR_Script && (unsigned)op.Arg[0] >= (unsigned)NumLocals) ||
+			(cls == VAR_Map && (unsigned)op.Arg[0] >= NUM_MAPVARS) ||
+			(cls == VAR_World && (unsigned)op.Arg[0] >= NUM_WORLDVARS) ||
+			(cls == VAR_Global && (unsigned)op.Arg[0] >= NUM_GLOBALVARS))
+		{
+			return false;
+		}
+		op.Pops = vop == VOP_Assign || vop == VOP_Math;
+		op.Pushes = vop == VOP_Push;
+		break;
+	}
+	if (ofs > Size) return false;
+	op.Next = ofs;
+
+	if (op.Kind != KIND_Plain && op.Kind != KIND_Wait && (uint32_t)op.Arg[0] >= Size)
+	{
+		return false;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// FACSTranslator :: Analyze
+//
+// Finds every instruction reachable from the seed and the stack depth at
+// each. Returns false if the region is not worth translating.
+//
+//==========================================================================
+
+bool FACSTranslator::Analyze(uint32_t seed, int depth)
+{
+	TArray<std::pair<uint32_t, int>> work;
+	int translated = 0;
+	bool loops = false;
+
+	Seed = seed;
+	SeedDepth = MaxDepth = depth;
+	work.Push({ seed, depth });
+
+	while (work.Size() > 0)
+	{
+		auto item = work.Last();
+		work.Pop();
+
+		if (auto index = OpIndex.CheckKey(item.first))
+		{
+			// Well-formed p-code has the same stack depth on every path.
+			if (Ops[*index].Depth != item.second) return false;
+			continue;
+		}
+
+		Op op = {};
+		op.Ofs = item.first;
+		op.Depth = item.second;
+		op.Translated = translated < ACSC_MAXOPS && Decode(op) &&
+			op.Depth >= op.Pops + (op.Kind == KIND_Case) &&
+			op.Depth - op.Pops + op.Pushes <= ACSC_MAXDEPTH;
+
+		// Stack values held in registers would not be seen by the ACS string
+		// collector, which a special can trigger.
+		if (op.Translated && op.Depth != op.Pops &&
+			((op.PCode >= PCD_LSPEC1 && op.PCode <= PCD_LSPEC5DIRECT) || (op.PCode >= PCD_LSPEC1DIRECTB && op.PCode <= PCD_LSPEC5DIRECTB)))
+		{
+			op.Translated = false;
+		}
+		OpIndex[op.Ofs] = Ops.Push(op);
+		if (!op.Translated) continue;
+
+		int after = op.Depth - op.Pops + op.Pushes;
+		translated++;
+		MaxDepth = max(MaxDepth, after);
+
+		switch (op.Kind)
+		{
+		case KIND_Plain:
+			work.Push({ op.Next, after });
+			break;
+
+		case KIND_Goto:
+			work.Push({ (uint32_t)op.Arg[0], after });
+			loops |= (uint32_t)op.Arg[0] <= op.Ofs;
+			break;
+
+		case KIND_Branch:
+			work.Push({ op.Next, after });
+			work.Push({ (uint32_t)op.Arg[0], after });
+			loops |= (uint32_t)op.Arg[0] <= op.Ofs;
+			break;
+
+		case KIND_Case:
+			work.Push({ op.Next, after });
+			work.Push({ (uint32_t)op.Arg[0], after - 1 });
+			loops |= (uint32_t)op.Arg[0] <= op.Ofs;
+			break;
+
+		default:
+			break;
+		}
+	}
+	return Ops[0].Translated && (loops || translated >= ACSC_MINOPS);
+}
+
+//==========================================================================
+//
+// FACSTranslator :: Emit
+//
+//==========================================================================
+
+VMScriptFunction *FACSTranslator::Emit(const char *name)
+{
+	static const uint8_t regts[] = { REGT_POINTER };
+	VMFunctionBuilder buildit(0);
+	Build = &buildit;
+
+	FrameReg = buildit.Registers[REGT_POINTER].Get(1);
+	LocalsReg = buildit.Registers[REGT_POINTER].Get(1);
+	MapVarsReg = buildit.Registers[REGT_POINTER].Get(1);
+	WorldReg = buildit.Registers[REGT_POINTER].Get(1);
+	GlobalReg = buildit.Registers[REGT_POINTER].Get(1);
+	TempAReg = buildit.Registers[REGT_POINTER].Get(1);
+	SlotBase = MaxDepth > 0 ? buildit.Registers[REGT_INT].Get(MaxDepth) : 0;
+	RunawayReg = buildit.Registers[REGT_INT].Get(1);
+	TempReg = buildit.Registers[REGT_INT].Get(1);
+	BiasReg = buildit.Registers[REGT_INT].Get(1);
+	MaskReg = buildit.Registers[REGT_INT].Get(1);
+	ArgReg = buildit.Registers[REGT_INT].Get(5);
+	Zero = buildit.GetConstantInt(0);
+
+	buildit.Emit(OP_LP, LocalsReg, FrameReg, buildit.GetConstantInt(myoffsetof(FACSCompiledFrame, Locals)));
+	buildit.Emit(OP_LP, MapVarsReg, FrameReg, buildit.GetConstantInt(myoffsetof(FACSCompiledFrame, MapVars)));
+	buildit.Emit(OP_LKP, WorldReg, buildit.GetConstantAddress(ACS_WorldVars.Pointer()));
+	buildit.Emit(OP_LKP, GlobalReg, buildit.GetConstantAddress(ACS_GlobalVars.Pointer()));
+	buildit.Emit(OP_LW, RunawayReg, FrameReg, buildit.GetConstantInt(myoffsetof(FACSCompiledFrame, Runaway)));
+	buildit.Emit(OP_LW, BiasReg, FrameReg, buildit.GetConstantInt(myoffsetof(FACSCompiledFrame, DelayBias)));
+	buildit.Emit(OP_LW, MaskReg, FrameReg, buildit.GetConstantInt(myoffsetof(FACSCompiledFrame, SpecialArgMask)));
+	for (int i = 0; i < SeedDepth; i++)
+	{
+		buildit.Emit(OP_LW, Slot(i), FrameReg, buildit.GetConstantInt(myoffsetof(FACSCompiledFrame, Stack) + i * sizeof(int32_t)));
+	}
+	JumpToLabel(Seed);
+
+	// Lay the instructions out in p-code order and split them into blocks.
+	TArray<unsigned> order(Ops.Size(), true);
+	for (unsigned i = 0; i < Ops.Size(); i++) order[i] = i;
+	std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return Ops[a].Ofs < Ops[b].Ofs; });
+
+	Ops[0].Leader = true;
+	for (unsigned i = 0; i < order.Size(); i++)
+	{
+		Op &op = Ops[order[i]];
+		if (op.Translated && op.Kind != KIND_Plain && op.Kind != KIND_Wait)
+		{
+			Ops[OpIndex[op.Arg[0]]].Leader = true;
+		}
+		const Op *prev = i > 0 ? &Ops[order[i - 1]] : nullptr;
+		if (!op.Translated || prev == nullptr || !prev->Translated || prev->Kind != KIND_Plain || prev->Next != op.Ofs)
+		{
+			op.Leader = true;
+		}
+	}
+
+	int64_t fallthrough = -1;
+	for (unsigned i = 0; i < order.Size(); )
+	{
+		const Op &leader = Ops[order[i]];
+		if (fallthrough >= 0 && fallthrough != leader.Ofs)
+		{
+			JumpToLabel((uint32_t)fallthrough);
+		}
+		Labels[leader.Ofs] = buildit.GetAddress();
+
+		if (!leader.Translated)
+		{
+			Exit exit = { leader.Ofs, leader.Depth, 0, DLevelScript::SCRIPT_Running, 0 };
+			EmitExit(exit);
+			fallthrough = -1;
+			i++;
+			continue;
+		}
+
+		unsigned end = i + 1;
+		while (end < order.Size() && !Ops[order[end]].Leader) end++;
+		int count = int(end - i);
+
+		// The interpreter terminates scripts that exceed the runaway limit
+		// in the middle of a block, so let it run such a block.
+		buildit.EmitLoadInt(TempReg, RUNAWAY_LIMIT - count);
+		buildit.Emit(OP_LT_RR, CMP_CHECK, TempReg, RunawayReg);
+		JumpToExit(leader.Ofs, leader.Depth, 0, DLevelScript::SCRIPT_Running);
+		buildit.Emit(OP_ADD_RK, RunawayReg, RunawayReg, buildit.GetConstantInt(count));
+
+		for (int k = 0; k < count; k++)
+		{
+			const Op &op = Ops[order[i + k]];
+			EmitOp(op, count, k);
+			fallthrough = op.Kind == KIND_Plain || op.Kind == KIND_Branch || op.Kind == KIND_Case ? (int64_t)op.Next : -1;
+		}
+		i = end;
+	}
+	if (fallthrough >= 0)
+	{
+		JumpToLabel((uint32_t)fallthrough);
+	}
+
+	for (auto &exit : Exits)
+	{
+		exit.Address = buildit.GetAddress();
+		EmitExit(exit);
+	}
+	for (auto &jump : LabelJumps)
+	{
+		buildit.Backpatch(jump.first, Labels[jump.second]);
+	}
+	for (auto &jump : ExitJumps)
+	{
+		buildit.Backpatch(jump.first, Exits[jump.second].Address);
+	}
+
+	TArray<PType *> rets, args;
+	args.Push(NewPointer(TypeVoid));
+
+	auto sfunc = new VMScriptFunction;
+	sfunc->Proto = NewPrototype(rets, args);
+	sfunc->RegTypes = regts;
+	buildit.MakeFunction(sfunc);
+	sfunc->NumArgs = 1;
+	sfunc->PrintableName = ClassDataAllocator.Strdup(name);
+	Build = nullptr;
+	return sfunc;
+}
+
+//==========================================================================
+//
+// FACSTranslator :: EmitOp
+//
+// blockops is the number of instructions in the current block, which the
+// runaway counter already includes, and index the position of op in it.
+//
+//==========================================================================
+
+void FACSTranslator::EmitOp(const Op &op, int blockops, int index)
+{
+	auto &b = *Build;
+	const int d = op.Depth;
+	const int top = d > 0 ? Slot(d - 1) : -1;		// STACK(1)
+	const int next = d > 1 ? Slot(d - 2) : -1;		// STACK(2)
+	const int skip = blockops - index;				// for leaving before op
+	const int done = blockops - index - 1;			// for leaving after op
+	int cls, vop, vmop;
+
+	switch (op.PCode)
+	{
+	case PCD_NOP:
+	case PCD_DROP:
+		break;
+
+	case PCD_PUSHNUMBER:
+		b.EmitLoadInt(Slot(d), op.Arg[0]);
+		break;
+
+	case PCD_PUSHBYTE:
+	case PCD_PUSH2BYTES:
+	case PCD_PUSH3BYTES:
+	case PCD_PUSH4BYTES:
+	case PCD_PUSH5BYTES:
+	case PCD_PUSHBYTES:
+		for (int i = 0; i < op.Pushes; i++)
+		{
+			b.EmitLoadInt(Slot(d + i), Data[op.ArgOfs + i]);
+		}
+		break;
+
+	case PCD_DUP:
+		b.Emit(OP_MOVE, Slot(d), top, 0);
+		break;
+
+	case PCD_SWAP:
+		b.Emit(OP_MOVE, TempReg, next, 0);
+		b.Emit(OP_MOVE, next, top, 0);
+		b.Emit(OP_MOVE, top, TempReg, 0);
+		break;
+
+	case PCD_DIVIDE:
+	case PCD_MODULUS:
+		b.Emit(OP_EQ_K, CMP_CHECK, top, Zero);
+		JumpToExit(op.Ofs, d, skip, DLevelScript::SCRIPT_Running);
+		b.Emit(op.PCode == PCD_DIVIDE ? OP_DIV_RR : OP_MOD_RR, next, next, top);
+		break;
+
+	case PCD_ADD:			b.Emit(OP_ADD_RR, next, next, top); break;
+	case PCD_SUBTRACT:		b.Emit(OP_SUB_RR, next, next, top); break;
+	case PCD_MULTIPLY:		b.Emit(OP_MUL_RR, next, next, top); break;
+	case PCD_ANDBITWISE:	b.Emit(OP_AND_RR, next, next, top); break;
+	case PCD_ORBITWISE:		b.Emit(OP_OR_RR, next, next, top); break;
+	case PCD_EORBITWISE:	b.Emit(OP_XOR_RR, next, next, top); break;
+	case PCD_LSHIFT:		b.Emit(OP_SLL_RR, next, next, top); break;
+	case PCD_RSHIFT:		b.Emit(OP_SRA_RR, next, next, top); break;
+	case PCD_NEGATEBINARY:	b.Emit(OP_NOT, top, top, 0); break;
+	case PCD_UNARYMINUS:	b.Emit(OP_NEG, top, top, 0); break;
+
+	case PCD_EQ:			EmitBool(OP_EQ_R, CMP_CHECK, next, top, next); break;
+	case PCD_NE:			EmitBool(OP_EQ_R, 0, next, top, next); break;
+	case PCD_LT:			EmitBool(OP_LT_RR, CMP_CHECK, next, top, next); break;
+	case PCD_GT:			EmitBool(OP_LT_RR, CMP_CHECK, top, next, next); break;
+	case PCD_LE:			EmitBool(OP_LE_RR, CMP_CHECK, next, top, next); break;
+	case PCD_GE:			EmitBool(OP_LE_RR, CMP_CHECK, top, next, next); break;
+	case PCD_NEGATELOGICAL:	EmitBool(OP_EQ_K, CMP_CHECK, top, Zero, top); break;
+
+	case PCD_ANDLOGICAL:
+	case PCD_ORLOGICAL:
+	{
+		// The result is known once either operand is zero (&&) or non-zero (||).
+		int check = op.PCode == PCD_ANDLOGICAL ? CMP_CHECK : 0;
+		b.Emit(OP_EQ_K, check, next, Zero);
+		size_t known1 = b.Emit(OP_JMP, 0);
+		b.Emit(OP_EQ_K, check, top, Zero);
+		size_t known2 = b.Emit(OP_JMP, 0);
+		b.EmitLoadInt(next, op.PCode == PCD_ANDLOGICAL);
+		size_t end = b.Emit(OP_JMP, 0);
+		b.BackpatchToHere(known1);
+		b.BackpatchToHere(known2);
+		b.EmitLoadInt(next, op.PCode == PCD_ORLOGICAL);
+		b.BackpatchToHere(end);
+		break;
+	}
+
+	case PCD_GOTO:
+		JumpToLabel(op.Arg[0]);
+		break;
+
+	case PCD_IFGOTO:
+		b.Emit(OP_EQ_K, 0, top, Zero);
+		JumpToLabel(op.Arg[0]);
+		break;
+
+	case PCD_IFNOTGOTO:
+		b.Emit(OP_EQ_K, CMP_CHECK, top, Zero);
+		JumpToLabel(op.Arg[0]);
+		break;
+
+	case PCD_CASEGOTO:
+		b.Emit(OP_EQ_K, CMP_CHECK, top, b.GetConstantInt(op.Arg[1]));
+		JumpToLabel(op.Arg[0]);
+		break;
+
+	case PCD_DELAY:
+	case PCD_DELAYDIRECT:
+	case PCD_DELAYDIRECTB:
+		// statedata is stored even if the script does not wait.
+		if (op.PCode == PCD_DELAY) b.Emit(OP_ADD_RR, TempReg, top, BiasReg);
+		else
+		{
+			b.EmitLoadInt(TempReg, op.Arg[0]);
+			b.Emit(OP_ADD_RR, TempReg, TempReg, BiasReg);
+		}
+		b.Emit(OP_SW, FrameReg, TempReg, b.GetConstantInt(myoffsetof(FACSCompiledFrame, StateData)));
+		b.Emit(OP_LT_KR, CMP_CHECK, Zero, TempReg);
+		JumpToExit(op.Next, d - op.Pops, done, DLevelScript::SCRIPT_Delayed);
+		break;
+
+	case PCD_TAGWAIT:
+	case PCD_POLYWAIT:
+		b.Emit(OP_SW, FrameReg, top, b.GetConstantInt(myoffsetof(FACSCompiledFrame, StateData)));
+		JumpToExit(op.Next, d - 1, done, op.PCode == PCD_TAGWAIT ? DLevelScript::SCRIPT_TagWait : DLevelScript::SCRIPT_PolyWait);
+		break;
+
+	case PCD_TAGWAITDIRECT:
+	case PCD_POLYWAITDIRECT:
+		b.EmitLoadInt(TempReg, op.Arg[0]);
+		b.Emit(OP_SW, FrameReg, TempReg, b.GetConstantInt(myoffsetof(FACSCompiledFrame, StateData)));
+		JumpToExit(op.Next, d, done, op.PCode == PCD_TAGWAITDIRECT ? DLevelScript::SCRIPT_TagWait : DLevelScript::SCRIPT_PolyWait);
+		break;
+
+	case PCD_SUSPEND:
+		JumpToExit(op.Next, d, done, DLevelScript::SCRIPT_Suspended);
+		break;
+
+	case PCD_LSPEC1:
+	case PCD_LSPEC2:
+	case PCD_LSPEC3:
+	case PCD_LSPEC4:
+	case PCD_LSPEC5:
+		EmitSpecial(op, blockops, index, op.PCode - PCD_LSPEC1 + 1, true, true);
+		break;
+
+	case PCD_LSPEC1DIRECT:
+	case PCD_LSPEC2DIRECT:
+	case PCD_LSPEC3DIRECT:
+	case PCD_LSPEC4DIRECT:
+	case PCD_LSPEC5DIRECT:
+		EmitSpecial(op, blockops, index, op.PCode - PCD_LSPEC1DIRECT + 1, false, true);
+		break;
+
+	case PCD_LSPEC1DIRECTB:
+	case PCD_LSPEC2DIRECTB:
+	case PCD_LSPEC3DIRECTB:
+	case PCD_LSPEC4DIRECTB:
+	case PCD_LSPEC5DIRECTB:
+		EmitSpecial(op, blockops, index, op.PCode - PCD_LSPEC1DIRECTB + 1, false, false);
+		break;
+
+	default:
+	{
+		int areg, konst;
+		FindVarOp(op.PCode, cls, vop, vmop);
+		if (vmop == OP_DIV_RR || vmop == OP_MOD_RR)
+		{
+			b.Emit(OP_EQ_K, CMP_CHECK, top, Zero);
+			JumpToExit(op.Ofs, d, skip, DLevelScript::SCRIPT_Running);
+		}
+		EmitVarAddress(cls, op.Arg[0], areg, konst);
+		switch (vop)
+		{
+		case VOP_Assign:
+			b.Emit(OP_SW, areg, top, konst);
+			break;
+
+		case VOP_Push:
+			b.Emit(OP_LW, Slot(d), areg, konst);
+			break;
+
+		case VOP_Inc:
+		case VOP_Dec:
+			b.Emit(OP_LW, TempReg, areg, konst);
+			b.Emit(vop == VOP_Inc ? OP_ADD_RK : OP_SUB_RK, TempReg, TempReg, b.GetConstantInt(1));
+			b.Emit(OP_SW, areg, TempReg, konst);
+			break;
+
+		default:
+			b.Emit(OP_LW, TempReg, areg, konst);
+			b.Emit(vmop, TempReg, TempReg, top);
+			b.Emit(OP_SW, areg, TempReg, konst);
+			break;
+		}
+		break;
+	}
+	}
+}
+
+// Stores (b <op> c) == check into dest as 0 or 1.
+void FACSTranslator::EmitBool(int opcode, int check, int b, int c, int dest)
+{
+	Build->Emit(opcode, check, b, c);
+	size_t istrue = Build->Emit(OP_JMP, 0);
+	Build->EmitLoadInt(dest, 0);
+	size_t end = Build->Emit(OP_JMP, 0);
+	Build->BackpatchToHere(istrue);
+	Build->EmitLoadInt(dest, 1);
+	Build->BackpatchToHere(end);
+}
+
+void FACSTranslator::EmitVarAddress(int cls, int index, int &areg, int &konst)
+{
+	switch (cls)
+	{
+	case VAR_Script:
+		areg = LocalsReg;
+		konst = Build->GetConstantInt(index * sizeof(int32_t));
+		break;
+
+	case VAR_Map:
+		Build->Emit(OP_LP, TempAReg, MapVarsReg, Build->GetConstantInt(index * sizeof(int32_t *)));
+		areg = TempAReg;
+		konst = Zero;
+		break;
+
+	case VAR_World:
+		areg = WorldReg;
+		konst = Build->GetConstantInt(index * sizeof(int32_t));
+		break;
+
+	default:
+		areg = GlobalReg;
+		konst = Build->GetConstantInt(index * sizeof(int32_t));
+		break;
+	}
+}
+
+void FACSTranslator::EmitSpecial(const Op &op, int blockops, int index, int numargs, bool stackargs, bool masked)
+{
+	auto &b = *Build;
+
+	if (ACSCompiledSpecial == nullptr)
+	{
+		ACSCompiledSpecial = new VMNativeFunction(ExecuteCompiledSpecial, "ExecuteCompiledSpecial");
+		ACSCompiledSpecial->PrintableName = "ExecuteCompiledSpecial";
+		PClass::FunctionPtrList.Push(&ACSCompiledSpecial);
+	}
+
+	const int *arg = &op.Arg[1];
+	int special = op.Arg[0];
+
+	for (int i = 0; i < numargs; i++)
+	{
+		int reg = ArgReg + i;
+		if (stackargs)
+		{
+			b.Emit(OP_AND_RR, reg, Slot(op.Depth - numargs + i), MaskReg);
+		}
+		else if (masked)
+		{
+			b.EmitLoadInt(reg, arg[i]);
+			b.Emit(OP_AND_RR, reg, reg, MaskReg);
+		}
+		else
+		{
+			b.EmitLoadInt(reg, arg[i]);
+		}
+	}
+	b.Emit(OP_PARAM, REGT_POINTER, FrameReg);
+	b.Emit(OP_PARAM, REGT_INT | REGT_KONST, b.GetConstantInt(special));
+	for (int i = 0; i < 5; i++)
+	{
+		if (i < numargs) b.Emit(OP_PARAM, REGT_INT, ArgReg + i);
+		else b.Emit(OP_PARAM, REGT_INT | REGT_KONST, Zero);
+	}
+	b.Emit(OP_CALL_K, b.GetConstantAddress(ACSCompiledSpecial), 7, 1);
+	b.Emit(OP_RESULT, 0, REGT_INT, TempReg);
+	b.Emit(OP_EQ_K, CMP_CHECK, TempReg, Zero);
+	JumpToExit(op.Next, op.Depth - op.Pops, blockops - index - 1, DLevelScript::SCRIPT_Running);
+}
+
+void FACSTranslator::JumpToLabel(uint32_t ofs)
+{
+	LabelJumps.Push({ Build->Emit(OP_JMP, 0), ofs });
+}
+
+void FACSTranslator::JumpToExit(uint32_t ofs, int depth, int adjust, int state)
+{
+	unsigned i;
+	for (i = 0; i < Exits.Size(); i++)
+	{
+		auto &exit = Exits[i];
+		if (exit.Ofs == ofs && exit.Depth == depth && exit.Adjust == adjust && exit.State == state) break;
+	}
+	if (i == Exits.Size())
+	{
+		Exits.Push({ ofs, depth, adjust, state, 0 });
+	}
+	ExitJumps.Push({ Build->Emit(OP_JMP, 0), i });
+}
+
+// Hands the stack and everything else the interpreter needs back to it.
+void FACSTranslator::EmitExit(const Exit &exit)
+{
+	auto &b = *Build;
+	for (int i = 0; i < exit.Depth; i++)
+	{
+		b.Emit(OP_SW, FrameReg, Slot(i), b.GetConstantInt(myoffsetof(FACSCompiledFrame, Stack) + i * sizeof(int32_t)));
+	}
+	if (exit.Adjust != 0)
+	{
+		b.Emit(OP_SUB_RK, RunawayReg, RunawayReg, b.GetConstantInt(exit.Adjust));
+	}
+	b.Emit(OP_SW, FrameReg, RunawayReg, b.GetConstantInt(myoffsetof(FACSCompiledFrame, Runaway)));
+	b.EmitLoadInt(TempReg, exit.Depth);
+	b.Emit(OP_SW, FrameReg, TempReg, b.GetConstantInt(myoffsetof(FACSCompiledFrame, SP)));
+	b.EmitLoadInt(TempReg, exit.Ofs);
+	b.Emit(OP_SW, FrameReg, TempReg, b.GetConstantInt(myoffsetof(FACSCompiledFrame, ExitOfs)));
+	if (exit.State != DLevelScript::SCRIPT_Running)
+	{
+		b.EmitLoadInt(TempReg, exit.State);
+		b.Emit(OP_SW, FrameReg, TempReg, b.GetConstantInt(myoffsetof(FACSCompiledFrame, State)));
+	}
+	b.Emit(OP_RET, RET_FINAL, REGT_NIL, 0);
+}
+
+//==========================================================================
+//
+// FBehavior :: GetCompiledCode
+//
+// Returns translated code that starts at the given offset with the given
+// stack depth, translating it first if needed.
+//
+//==========================================================================
+
+VMFunction *FBehavior::GetCompiledCode(uint32_t ofs, int depth, int numlocals)
+{
+	if (ofs >= (uint32_t)DataSize || depth > ACSC_MAXDEPTH || !PClass::bVMOperational)
+	{
+		return nullptr;
+	}
+	if (UntranslatedOfs.Size() == 0)
+	{
+		UntranslatedOfs.Resize(DataSize);
+		memset(UntranslatedOfs.Data(), 0, DataSize);
+	}
+	if (UntranslatedOfs[ofs])
+	{
+		return nullptr;
+	}
+
+	uint64_t key = ((uint64_t)DataCRC << 32) | ofs;
+	FACSCompiledRegion *region;
+	if (auto pregion = ACSCompiledRegions.CheckKey(key))
+	{
+		region = *pregion;
+	}
+	else
+	{
+		region = new FACSCompiledRegion;
+		region->DataSize = DataSize;
+		region->Depth = depth;
+		region->NumLocals = numlocals;
+		ACSCompiledRegions.Insert(key, region);
+	}
+
+	if (region->DataSize != DataSize || region->Depth != depth || region->NumLocals != numlocals)
+	{
+		UntranslatedOfs[ofs] = true;
+		return nullptr;
+	}
+	// A compiled region without a function was deleted along with all other VM functions.
+	if (region->Status == FACSCompiledRegion::Untried || (region->Status == FACSCompiledRegion::Compiled && region->Func == nullptr))
+	{
+		FACSTranslator translator(Data, DataSize, Format, numlocals);
+		if (translator.Analyze(ofs, depth))
+		{
+			region->Func = translator.Emit(FStringf("ACS.%s.%u", ModuleName, ofs).GetChars());
+			region->Status = FACSCompiledRegion::Compiled;
+			PClass::FunctionPtrList.Push(&region->Func);
+		}
+		else
+		{
+			region->Status = FACSCompiledRegion::Rejected;
+		}
+	}
+	if (region->Status == FACSCompiledRegion::Rejected)
+	{
+		UntranslatedOfs[ofs] = true;
+		return nullptr;
+	}
+	return region->Func;
+}
+
+//==========================================================================
+//
+// DLevelScript :: RunCompiledCode
+//
+// Runs translated code from pc if there is any. Returns false if the
+// interpreter has to run the next instruction.
+//
+//==========================================================================
+
+bool DLevelScript::RunCompiledCode(int *&pc, int32_t *stack, int &sp, unsigned int &runaway, int specialargmask)
+{
+	VMFunction *func = activeBehavior->GetCompiledCode(activeBehavior->PC2Ofs(pc), sp, Localvars.Size());
+	if (func == nullptr)
+	{
+		return false;
+	}
+
+	FACSCompiledFrame frame;
+	frame.Locals = Localvars.Size() > 0 ? &Localvars[0] : nullptr;
+	frame.MapVars = activeBehavior->MapVars.Pointer();
+	frame.Script = this;
+	frame.Runaway = runaway;
+	frame.ExitOfs = 0;
+	frame.State = SCRIPT_Running;
+	frame.StateData = statedata;
+	frame.SP = 0;
+	frame.DelayBias = activeBehavior->GetFormat() == ACS_Old && gameinfo.gametype == GAME_Hexen;
+	frame.SpecialArgMask = specialargmask;
+	memcpy(frame.Stack, stack, sp * sizeof(int32_t));
+	sp = 0;
+
+	VMValue param = &frame;
+	VMCall(func, &param, 1, nullptr, 0);
+
+	memcpy(stack, frame.Stack, frame.SP * sizeof(int32_t));
+	sp = frame.SP;
+	pc = activeBehavior->Ofs2PC(frame.ExitOfs);
+	runaway = frame.Runaway;
+	statedata = frame.StateData;
+	if (frame.State != SCRIPT_Running)
+	{
+		state = EScriptState(frame.State);
+	}
+	return true;
+}
+
 int DLevelScript::RunScript()
 {
 	DACSThinker *controller = Level->ACSThinker;
@@ -6961,10 +8062,22 @@ int DLevelScript::RunScript()
 	const char *lookup;
 	int optstart = -1;
 	int temp;
+	const bool compiled = acs_compile && InModuleScriptNumber >= 0;
+	bool skipcompiled = false;
 
 	while (state == SCRIPT_Running)
 	{
-		if (++runaway > 2000000)
+		// Translated code stops at anything it cannot handle. That instruction
+		// must then be run here before trying translated code again.
+		if (compiled && !skipcompiled && activeFunction == NULL &&
+			RunCompiledCode(pc, Stack.Pointer(), sp, runaway, specialargmask))
+		{
+			skipcompiled = true;
+			continue;
+		}
+		skipcompiled = false;
+
+		if (++runaway > RUNAWAY_LIMIT)
 		{
 			Printf ("Runaway %s terminated\n", ScriptPresentation(script).GetChars());
 			state = SCRIPT_PleaseRemove;
@@ -9052,6 +10165,7 @@ scriptwait:
 						break;
 					}
 				}
+				P_InvalidateSightCache();
 
 				sp -= 2;
 			}
@@ -46,6 +46,7 @@
 class FFont;
 struct line_t;
 class FSerializer;
+class VMFunction;
 
 
 enum
@@ -379,6 +380,7 @@ public:
 	ACSProfileInfo *GetFunctionProfileData(int index) { return index >= 0 && index < NumFunctions ? &FunctionProfileData[index] : NULL; }
 	ACSProfileInfo *GetFunctionProfileData(ScriptFunction *func) { return GetFunctionProfileData((int)(func - (ScriptFunction *)Functions)); }
 	const char *LookupString (uint32_t index, bool forprint = false) const;
+	VMFunction *GetCompiledCode (uint32_t ofs, int depth, int numlocals);
 
 	BoundsCheckingArray<int32_t *, NUM_MAPVARS> MapVars;
 
@@ -410,6 +412,8 @@ private:
 	TArray<FBehavior *> Imports;
 	char ModuleName[9];
 	TArray<int> JumpPoints;
+	uint32_t DataCRC;					// identifies the module's code to the translated code cache
+	TArray<uint8_t> UntranslatedOfs;	// offsets known to have no translated code
 
 	void LoadScriptsDirectory ();
 
@@ -108,62 +108,27 @@ static const struct ColorList {
 
 inline particle_t *NewParticle (FLevelLocals *Level, bool replace = false)
 {
-	particle_t *result = nullptr;
-	// [MC] Thanks to RaveYard and randi for helping me with this addition.
-	// Array's filled up
-	if (Level->InactiveParticles == NO_PARTICLE)
-	{
-		if (replace)
-		{
-			result = &Level->Particles[Level->OldestParticle];
+	particle_t *result;
+	const uint32_t capacity = Level->Particles.Size();
 
-			// There should be NO_PARTICLE for the oldest's tnext
-			if (result->tprev != NO_PARTICLE)
-			{
-				// tnext: youngest to oldest
-				// tprev: oldest to youngest
-				
-				// 2nd oldest -> oldest
-				particle_t *nbottom = &Level->Particles[result->tprev];
-				nbottom->tnext = NO_PARTICLE;
-
-				// now oldest becomes youngest
-				Level->OldestParticle = result->tprev;
-				result->tnext = Level->ActiveParticles;
-				result->tprev = NO_PARTICLE;
-				Level->ActiveParticles = uint32_t(result - Level->Particles.Data());
-
-				// youngest -> 2nd youngest
-				particle_t* ntop = &Level->Particles[result->tnext];
-				ntop->tprev = Level->ActiveParticles;
-			}
-			// [MC] Future proof this by resetting everything when replacing a particle.
-			auto tnext = result->tnext;
-			auto tprev = result->tprev;
-			*result = {};
-			result->tnext = tnext;
-			result->tprev = tprev;
-		}
-		return result;
-	}
-	
-	// Array isn't full.
-	uint32_t current = Level->ActiveParticles;
-	result = &Level->Particles[Level->InactiveParticles];
-	Level->InactiveParticles = result->tnext;
-	result->tnext = current;
-	result->tprev = NO_PARTICLE;
-	Level->ActiveParticles = uint32_t(result - Level->Particles.Data());
-
-	if (current != NO_PARTICLE) // More than one active particles
+	if (Level->NumParticles >= capacity)
 	{
-		particle_t* next = &Level->Particles[current];
-		next->tprev = Level->ActiveParticles;
+		// Array's filled up
+		if (!replace || capacity == 0) return nullptr;
+
+		// The oldest particle becomes the youngest by moving the start of the ring past it.
+		result = &Level->Particles[Level->OldestParticle];
+		if (++Level->OldestParticle == capacity) Level->OldestParticle = 0;
 	}
-	else // Just one active particle
+	else
 	{
-		Level->OldestParticle = Level->ActiveParticles;
+		uint32_t index = Level->OldestParticle + Level->NumParticles;
+		if (index >= capacity) index -= capacity;
+		result = &Level->Particles[index];
+		Level->NumParticles++;
 	}
+	// Slots are not cleared when particles expire so this must be done here.
+	*result = {};
 	return result;
 }
 
@@ -184,7 +149,7 @@ void P_InitParticles (FLevelLocals *Level)
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	int NumParticles = clamp<int>(num, 100, 65535);
+	int NumParticles = clamp<int>(num, 100, MAX_PARTICLES);
 
 	Level->Particles.Resize(NumParticles);
 	P_ClearParticles (Level);
@@ -192,18 +157,8 @@ void P_InitParticles (FLevelLocals *Level)
 
 void P_ClearParticles (FLevelLocals *Level)
 {
-	int i = 0;
-	Level->OldestParticle = NO_PARTICLE;
-	Level->ActiveParticles = NO_PARTICLE;
-	Level->InactiveParticles = 0;
-	for (auto &p : Level->Particles)
-	{
-		p = {};
-		p.tprev = i - 1;
-		p.tnext = ++i;
-	}
-	Level->Particles.Last().tnext = NO_PARTICLE;
-	Level->Particles.Data()->tprev = NO_PARTICLE;
+	Level->OldestParticle = 0;
+	Level->NumParticles = 0;
 }
 
 // Group particles by subsectors. Because particles are always
@@ -234,18 +189,24 @@ void P_FindParticleSubsectors (FLevelLocals *Level)
 		Level->ParticlesInSubsec.Reserve (Level->subsectors.Size() - Level->ParticlesInSubsec.Size());
 	}
 
-	fillshort (&Level->ParticlesInSubsec[0], Level->subsectors.Size(), NO_PARTICLE);
+	std::fill_n(Level->ParticlesInSubsec.Data(), Level->subsectors.Size(), NO_PARTICLE);
 
 	if (!r_particles)
 	{
 		return;
 	}
-	for (uint16_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
+	// Go from youngest to oldest so that the oldest ends up first in each subsector's list.
+	const uint32_t capacity = Level->Particles.Size();
+	for (uint32_t k = Level->NumParticles; k-- > 0; )
 	{
+		uint32_t i = Level->OldestParticle + k;
+		if (i >= capacity) i -= capacity;
+
+		auto &particle = Level->Particles[i];
 		 // Try to reuse the subsector from the last portal check, if still valid.
-		if (Level->Particles[i].subsector == nullptr) Level->Particles[i].subsector = Level->PointInRenderSubsector(Level->Particles[i].Pos);
-		int ssnum = Level->Particles[i].subsector->Index();
-		Level->Particles[i].snext = Level->ParticlesInSubsec[ssnum];
+		if (particle.subsector == nullptr) particle.subsector = Level->PointInRenderSubsector(particle.Pos);
+		int ssnum = particle.subsector->Index();
+		particle.snext = Level->ParticlesInSubsec[ssnum];
 		Level->ParticlesInSubsec[ssnum] = i;
 	}
 }
@@ -287,79 +248,150 @@ void P_InitEffects ()
 	blood2 = ParticleColor(RPART(kind)/3, GPART(kind)/3, BPART(kind)/3);
 }
 
+//==========================================================================
+//
+// P_ThinkParticles
+//
+// The live particles occupy a contiguous range of the ring buffer, so this
+// is done in separate passes over (at most) two linear segments of the array:
+// First the per-particle arithmetic without any dependencies on the level,
+// then the expired particles get removed, keeping the age order intact,
+// and finally the survivors get sorted into subsectors and portals.
+//
+//==========================================================================
+
+static inline bool ParticleIsFrozen(const particle_t &particle, bool frozen)
+{
+	return frozen && !(particle.flags & SPF_NOTIMEFREEZE);
+}
+
+template<class Func>
+static void ForEachParticleSegment(FLevelLocals *Level, Func func)
+{
+	const uint32_t capacity = Level->Particles.Size();
+	const uint32_t start = Level->OldestParticle;
+	const uint32_t count = Level->NumParticles;
+	particle_t *base = Level->Particles.Data();
+
+	if (start + count <= capacity)
+	{
+		func(base + start, base + start + count);
+	}
+	else
+	{
+		func(base + start, base + capacity);
+		func(base, base + start + count - capacity);
+	}
+}
+
 void P_ThinkParticles (FLevelLocals *Level)
 {
-	int i = Level->ActiveParticles;
-	particle_t *particle = nullptr, *prev = nullptr;
-	while (i != NO_PARTICLE)
+	if (Level->NumParticles == 0)
+	{
+		Level->OldestParticle = 0;
+		return;
+	}
+
+	const bool frozen = Level->isFrozen();
+	// Without line portals the movement needs no level data and can be done along with the rest.
+	const bool linearmove = !Level->PortalBlockmap.containsLines;
+
+	ForEachParticleSegment(Level, [=](particle_t *particle, particle_t *end)
 	{
-		particle = &Level->Particles[i];
-		i = particle->tnext;
-		if (Level->isFrozen() && !(particle->flags &SPF_NOTIMEFREEZE))
+		for (; particle < end; particle++)
 		{
-			if(particle->flags & SPF_LOCAL_ANIM)
+			if (ParticleIsFrozen(*particle, frozen))
 			{
-				particle->animData.SwitchTic++;
+				if (particle->flags & SPF_LOCAL_ANIM)
+				{
+					particle->animData.SwitchTic++;
+				}
+				continue;
 			}
+			particle->alpha -= particle->fadestep;
+			particle->size += particle->sizestep;
+			particle->ttl--;
 
-			prev = particle;
-			continue;
-		}
-		
-		particle->alpha -= particle->fadestep;
-		particle->size += particle->sizestep;
-		if (particle->alpha <= 0 || --particle->ttl <= 0 || (particle->size <= 0))
-		{ // The particle has expired, so free it
-			*particle = {};
-			if (prev)
-				prev->tnext = i;
-			else
-				Level->ActiveParticles = i;
-
-			if (i != NO_PARTICLE)
+			if (linearmove)
 			{
-				particle_t *next = &Level->Particles[i];
-				next->tprev = particle->tprev;
+				particle->Pos.X += particle->Vel.X;
+				particle->Pos.Y += particle->Vel.Y;
+				particle->Pos.Z += particle->Vel.Z;
+				particle->Vel += particle->Acc;
+
+				if (particle->flags & SPF_ROLL)
+				{
+					particle->Roll += particle->RollVel;
+					particle->RollVel += particle->RollAcc;
+				}
 			}
-			particle->tnext = Level->InactiveParticles;
-			Level->InactiveParticles = (int)(particle - Level->Particles.Data());
-			continue;
 		}
+	});
 
-		// Handle crossing a line portal
-		DVector2 newxy = Level->GetPortalOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
-		particle->Pos.X = newxy.X;
-		particle->Pos.Y = newxy.Y;
-		particle->Pos.Z += particle->Vel.Z;
-		particle->Vel += particle->Acc;
+	// Remove the expired particles.
+	const uint32_t capacity = Level->Particles.Size();
+	const uint32_t start = Level->OldestParticle;
+	const uint32_t count = Level->NumParticles;
+	particle_t *base = Level->Particles.Data();
+	uint32_t live = 0;
 
-		if(particle->flags & SPF_ROLL)
+	for (uint32_t k = 0, read = start; k < count; k++)
+	{
+		particle_t &particle = base[read];
+		if (ParticleIsFrozen(particle, frozen) || (particle.alpha > 0 && particle.ttl > 0 && particle.size > 0))
 		{
-			particle->Roll += particle->RollVel;
-			particle->RollVel += particle->RollAcc;
+			uint32_t write = start + live;
+			if (write >= capacity) write -= capacity;
+			if (write != read) base[write] = particle;
+			live++;
 		}
-		
-		particle->subsector = Level->PointInRenderSubsector(particle->Pos);
-		sector_t *s = particle->subsector->sector;
-		// Handle crossing a sector portal.
-		if (!s->PortalBlocksMovement(sector_t::ceiling))
+		if (++read == capacity) read = 0;
+	}
+	Level->NumParticles = live;
+
+	ForEachParticleSegment(Level, [=](particle_t *particle, particle_t *end)
+	{
+		for (; particle < end; particle++)
 		{
-			if (particle->Pos.Z > s->GetPortalPlaneZ(sector_t::ceiling))
+			if (ParticleIsFrozen(*particle, frozen)) continue;
+
+			if (!linearmove)
 			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::ceiling);
-				particle->subsector = NULL;
+				// Handle crossing a line portal
+				DVector2 newxy = Level->GetPortalOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
+				particle->Pos.X = newxy.X;
+				particle->Pos.Y = newxy.Y;
+				particle->Pos.Z += particle->Vel.Z;
+				particle->Vel += particle->Acc;
+
+				if (particle->flags & SPF_ROLL)
+				{
+					particle->Roll += particle->RollVel;
+					particle->RollVel += particle->RollAcc;
+				}
 			}
-		}
-		else if (!s->PortalBlocksMovement(sector_t::floor))
-		{
-			if (particle->Pos.Z < s->GetPortalPlaneZ(sector_t::floor))
+
+			particle->subsector = Level->PointInRenderSubsector(particle->Pos);
+			sector_t *s = particle->subsector->sector;
+			// Handle crossing a sector portal.
+			if (!s->PortalBlocksMovement(sector_t::ceiling))
 			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::floor);
-				particle->subsector = NULL;
+				if (particle->Pos.Z > s->GetPortalPlaneZ(sector_t::ceiling))
+				{
+					particle->Pos += s->GetPortalDisplacement(sector_t::ceiling);
+					particle->subsector = NULL;
+				}
+			}
+			else if (!s->PortalBlocksMovement(sector_t::floor))
+			{
+				if (particle->Pos.Z < s->GetPortalPlaneZ(sector_t::floor))
+				{
+					particle->Pos += s->GetPortalDisplacement(sector_t::floor);
+					particle->subsector = NULL;
+				}
 			}
 		}
-		prev = particle;
-	}
+	});
 }
 
 void P_SpawnParticle(FLevelLocals *Level, const DVector3 &pos, const DVector3 &vel, const DVector3 &accel, PalEntry color, double startalpha, int lifetime, double size,
@@ -82,15 +82,16 @@ struct particle_t
     FTextureID texture; // +4 = 84
     ERenderStyle style; //+4 = 88
     float Roll, RollVel, RollAcc; //+12 = 100
-    uint16_t    tnext, snext, tprev; //+6 = 106
-	uint16_t flags; //+2 = 108
-	// uint32_t padding; //+4 = 112
+    uint32_t    snext; //+4 = 104
+	uint16_t flags; //+2 = 106
+	// uint16_t padding; //+6 = 112
 	FStandaloneAnimation animData; //+16 = 128
 };
 
 static_assert(sizeof(particle_t) == 128);
 
-const uint16_t NO_PARTICLE = 0xffff;
+const uint32_t NO_PARTICLE = 0xffffffff;
+const int MAX_PARTICLES = 1000000;
 
 void P_InitParticles(FLevelLocals *);
 void P_ClearParticles (FLevelLocals *Level);
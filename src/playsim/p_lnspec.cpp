@@ -2783,6 +2783,7 @@ FUNC(LS_Line_SetBlocking)
         Level->lines[line].flags = (Level->lines[line].flags & ~clearflags[0]) | setflags[0];
         Level->lines[line].flags2 = (Level->lines[line].flags2 & ~clearflags[1]) | setflags[1];
     }
+    P_InvalidateSightCache();
     return true;
 }
 
@@ -3304,6 +3305,7 @@ FUNC(LS_GlassBreak)
 	bool quest1, quest2;
 
 	ln->flags &= ~(ML_BLOCKING|ML_BLOCKEVERYTHING);
+	P_InvalidateSightCache();
 	switched = P_ChangeSwitchTexture (ln->sidedef[0], false, 0, &quest1);
 	ln->special = 0;
 	if (ln->sidedef[1] != NULL)
@@ -280,6 +280,7 @@ enum ESightFlags
 	SF_IGNOREWATERBOUNDARY=8
 };
 
+void	P_InvalidateSightCache ();
 void	P_ResetSightCounters (bool full);
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
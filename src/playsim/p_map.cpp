@@ -6907,6 +6907,9 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 	cpos.sector = sector;
 	cpos.instant = instant;
 
+	// Sight results depend on plane heights.
+	P_InvalidateSightCache();
+
 	// Also process all sectors that have 3D floors transferred from the
 	// changed sector.
 	if (sector->e->XFloor.attached.Size() && floorOrCeil != 2)
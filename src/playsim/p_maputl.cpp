@@ -61,6 +61,7 @@
 
 
 #include <stdlib.h>
+#include <algorithm>
 
 
 #include "m_bbox.h"
@@ -335,11 +336,7 @@ void AActor::UnlinkFromWorld (FLinkContext *ctx)
 
 		while (block != NULL)
 		{
-			if (block->NextActor != NULL)
-			{
-				block->NextActor->PrevActor = block->PrevActor;
-			}
-			*(block->PrevActor) = block->NextActor;
+			Level->blockmap.UnlinkThing(block);
 			FBlockNode *next = block->NextBlock;
 			block->Release ();
 			block = next;
@@ -535,26 +532,23 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 				{
 					for (int x = x1; x <= x2; ++x)
 					{
-						FBlockNode **link = &Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
 						FBlockNode *node = FBlockNode::Create(this, x, y, this->Sector->PortalGroup);
 
 						// Link in to block
-						if ((node->NextActor = *link) != NULL)
-						{
-							(*link)->PrevActor = &node->NextActor;
-						}
-						node->PrevActor = link;
-						*link = node;
+						Level->blockmap.LinkThing(node);
 
 						// Link in to actor
-						node->PrevBlock = alink;
-						node->NextBlock = NULL;
 						(*alink) = node;
 						alink = &node->NextBlock;
 					}
 				}
 			}
 		}
+		// Iterators can skip the duplicate check for actors in a single block.
+		if (BlockNode != nullptr && BlockNode->NextBlock == nullptr)
+		{
+			Level->blockmap.blockthings[BlockNode->BlockIndex][BlockNode->ThingIndex].SingleBlock = true;
+		}
 	}
 	// Portal links cannot be done unless the level is fully initialized.
 	if (!spawningmapthing) UpdateRenderSectorList();
@@ -896,6 +890,9 @@ FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l)
 	miny = maxy = 0;
 	ClearHash();
 	block = NULL;
+	blockpos = 0;
+	lastseq = 0;
+	compactcount = 0;
 }
 
 FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l, int _minx, int _miny, int _maxx, int _maxy)
@@ -945,13 +942,18 @@ void FBlockThingsIterator::StartBlock(int x, int y)
 	cury = y;
 	if (Level->blockmap.isValidBlock(x, y))
 	{
-		block = Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
+		block = &Level->blockmap.blockthings[y*Level->blockmap.bmapwidth + x];
+		blockpos = block->Size();
+		lastseq = block->NextSeq;
 	}
 	else
 	{
 		// invalid block
 		block = NULL;
+		blockpos = 0;
+		lastseq = 0;
 	}
+	compactcount = Level->blockmap.compactcount;
 }
 
 //===========================================================================
@@ -977,16 +979,26 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 {
 	for (;;)
 	{
-		while (block != NULL)
+		if (block != NULL && compactcount != Level->blockmap.compactcount)
+		{
+			// A block was compacted while iterating, which may have shifted the things not yet returned.
+			// Compaction keeps the link order, so the entries not visited yet are exactly those linked before
+			// the last visited one, no matter what happened to the things themselves since.
+			compactcount = Level->blockmap.compactcount;
+			auto first = std::lower_bound(block->begin(), block->end(), lastseq, [](const FBlockThing &thing, unsigned seq) { return thing.Seq < seq; });
+			blockpos = int(first - block->begin());
+		}
+		while (block != NULL && blockpos > 0)
 		{
-			AActor *me = block->Me;
-			FBlockNode *mynode = block;
+			FBlockThing &thing = (*block)[--blockpos];
+			lastseq = thing.Seq;
+			if (thing.Me == nullptr) continue;
+			AActor *me = thing.Me;
 			HashEntry *entry;
 			int i;
 
-			block = block->NextActor;
 			// Don't recheck things that were already checked
-			if (mynode->NextBlock == NULL && mynode->PrevBlock == &me->BlockNode)
+			if (thing.SingleBlock)
 			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
 				return me;
 			}
@@ -1815,11 +1827,12 @@ static AActor *RoughBlockCheck (AActor *mo, int index, void *param)
 {
 	BlockCheckInfo *info = (BlockCheckInfo *)param;
 
-	FBlockNode *link;
+	auto &things = mo->Level->blockmap.blockthings[index];
 
-	for (link = mo->Level->blockmap.blocklinks[index]; link != NULL; link = link->NextActor)
+	for (int i = (int)things.Size() - 1; i >= 0; i--)
 	{
-		if (link->Me != mo)
+		auto link = &things[i];
+		if (link->Me != nullptr && link->Me != mo)
 		{
 			if (info->onlyseekable && !mo->CanSeek(link->Me))
 			{
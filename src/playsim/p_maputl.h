@@ -10,6 +10,8 @@
 
 extern int validcount;
 struct FBlockNode;
+struct FBlockThing;
+struct FBlockThings;
 
 struct divline_t
 {
@@ -291,7 +293,10 @@ class FBlockThingsIterator
 
 	int curx, cury;
 
-	FBlockNode *block;
+	FBlockThings *block;
+	int blockpos;				// things below this position have not been returned yet
+	unsigned lastseq;			// link order of the last entry visited in the current block, to find the position again after a compaction
+	unsigned compactcount;
 
 	int Buckets[32];
 
@@ -468,9 +468,8 @@ FBlockNode *FBlockNode::Create(AActor *who, int x, int y, int group)
 	}
 	block->BlockIndex = x + y * who->Level->blockmap.bmapwidth;
 	block->Me = who;
-	block->NextActor = nullptr;
-	block->PrevActor = nullptr;
-	block->PrevBlock = nullptr;
+	block->Group = group;
+	block->ThingIndex = -1;
 	block->NextBlock = nullptr;
 	return block;
 }
@@ -51,9 +51,13 @@ This uses specialized forms of the maputils routines for optimized performance
 */
 
 // Performance meters
-static int sightcounts[6];
-static cycle_t SightCycles;
+cycle_t SightCycles;
 static cycle_t MaxSightCycles;
+static int sightcachehits, sightcachemisses;
+
+// Off by default: direct writes to line flags from ZScript are not tracked, so
+// a cached result can be stale and demos recorded with it on may need it on to play back.
+CVAR(Bool, sv_sightcache, false, CVAR_SERVERINFO)
 
 enum
 {
@@ -87,12 +91,119 @@ struct SightTask
 };
 
 
-static TArray<intercept_t> intercepts (128);
-static TArray<SightTask> portals(32);
+//==========================================================================
+//
+// Scratch state for running sight checks. Lines and polyobjects are
+// marked with a per-workspace stamp instead of the global validcount,
+// which the callers of P_CheckSight may be using themselves.
+//
+//==========================================================================
+
+struct SightWorkspace
+{
+	TArray<intercept_t> intercepts;
+	TArray<SightTask> portals;
+	TArray<int> linestamps;
+	TArray<int> polystamps;
+	int stamp = 0;
+	int counts[6] = {};
+
+	SightWorkspace() : intercepts(128), portals(32) {}
+
+	void Prepare(FLevelLocals *Level)
+	{
+		if (linestamps.Size() != Level->lines.Size() || polystamps.Size() != Level->Polyobjects.Size() || stamp > INT_MAX / 2)
+		{
+			linestamps.Resize(Level->lines.Size());
+			polystamps.Resize(Level->Polyobjects.Size());
+			if (linestamps.Size() > 0) memset(&linestamps[0], 0, linestamps.Size() * sizeof(int));
+			if (polystamps.Size() > 0) memset(&polystamps[0], 0, polystamps.Size() * sizeof(int));
+			stamp = 0;
+		}
+	}
+};
+
+static SightWorkspace MainSight;
+
+//==========================================================================
+//
+// Per-tic sight cache
+//
+// The result of the geometric part of a sight check only depends on the
+// two actors' positions and the level geometry, so it is remembered until
+// the next tic or until some sector plane, 3D floor, 3D midtex or
+// polyobject moves or a line's blocking flags or activation get changed
+// by a special or ACS. Direct writes to a line's flags from ZScript are
+// not tracked.
+//
+// Entries are keyed by spawn order, not by address, and never evicted
+// within a tic, so whether a check hits the cache is the same on every
+// machine.
+//
+//==========================================================================
+
+// Visibility only matters for the precheck, so entries are shared regardless of it.
+enum { SF_TRACEFLAGS = ~SF_IGNOREVISIBILITY };
+
+struct SightCacheEntry
+{
+	AActor *t1 = nullptr, *t2 = nullptr;
+	sector_t *s1 = nullptr, *s2 = nullptr;
+	DVector3 pos1, pos2;
+	double height1 = 0, height2 = 0;
+	int flags = 0;
+	int stamp = 0;	// new entries never match
+	bool result = false;
+};
+
+static TMap<uint64_t, SightCacheEntry> SightCache;
+static int SightCacheStamp = 1;
+static FLevelLocals *SightCacheLevel;
+static int SightCacheTime = -1;
+
+void P_InvalidateSightCache()
+{
+	SightCacheStamp++;
+}
+
+static SightCacheEntry &P_FindSightCacheEntry(AActor *t1, AActor *t2)
+{
+	if (t1->Level != SightCacheLevel || t1->Level->maptime != SightCacheTime)
+	{
+		SightCacheLevel = t1->Level;
+		SightCacheTime = t1->Level->maptime;
+		SightCacheStamp++;
+		SightCache.Clear();
+	}
+	return SightCache[(uint64_t(t1->SpawnOrder) << 32) | t2->SpawnOrder];
+}
+
+static bool P_MatchSightCache(const SightCacheEntry &entry, AActor *t1, AActor *t2, int flags)
+{
+	return entry.stamp == SightCacheStamp && entry.t1 == t1 && entry.t2 == t2 && entry.flags == (flags & SF_TRACEFLAGS) &&
+		entry.s1 == t1->Sector && entry.s2 == t2->Sector && entry.pos1 == t1->Pos() && entry.pos2 == t2->Pos() &&
+		entry.height1 == t1->Height && entry.height2 == t2->Height;
+}
+
+static void P_StoreSightCache(SightCacheEntry &entry, AActor *t1, AActor *t2, int flags, bool result)
+{
+	entry.t1 = t1;
+	entry.t2 = t2;
+	entry.s1 = t1->Sector;
+	entry.s2 = t2->Sector;
+	entry.pos1 = t1->Pos();
+	entry.pos2 = t2->Pos();
+	entry.height1 = t1->Height;
+	entry.height2 = t2->Height;
+	entry.flags = flags & SF_TRACEFLAGS;
+	entry.stamp = SightCacheStamp;
+	entry.result = result;
+}
 
 class SightCheck
 {
 	FLevelLocals *Level;
+	SightWorkspace *ws;
 	DVector3 sightstart;
 	DVector2 sightend;
 	double Startfrac;
@@ -117,9 +228,10 @@ class SightCheck
 	bool LineBlocksSight(line_t *ld);
 
 public:
-	SightCheck(FLevelLocals *l)
+	SightCheck(FLevelLocals *l, SightWorkspace *w)
 	{
 		Level = l;
+		ws = w;
 	}
 
 	bool P_SightPathTraverse ();
@@ -279,16 +391,16 @@ bool SightCheck::PTR_SightTraverse (intercept_t *in)
 
 		if (portaldir != sector_t::floor && (open.portalflags & SO_TOPBACK) && !(open.portalflags & SO_TOPFRONT))
 		{
-			portals.Push({ in->frac, topslope, bottomslope, sector_t::ceiling, backsec->GetOppositePortalGroup(sector_t::ceiling) });
+			ws->portals.Push({ in->frac, topslope, bottomslope, sector_t::ceiling, backsec->GetOppositePortalGroup(sector_t::ceiling) });
 		}
 		if (portaldir != sector_t::ceiling && (open.portalflags & SO_BOTTOMBACK) && !(open.portalflags & SO_BOTTOMFRONT))
 		{
-			portals.Push({ in->frac, topslope, bottomslope, sector_t::floor, backsec->GetOppositePortalGroup(sector_t::floor) });
+			ws->portals.Push({ in->frac, topslope, bottomslope, sector_t::floor, backsec->GetOppositePortalGroup(sector_t::floor) });
 		}
 	}
 	if (lport != nullptr && lport->mDestination != nullptr)
 	{
-		portals.Push({ in->frac, topslope, bottomslope, portaldir, lport->mDestination->frontsector->PortalGroup });
+		ws->portals.Push({ in->frac, topslope, bottomslope, portaldir, lport->mDestination->frontsector->PortalGroup });
 		return false;
 	}
 
@@ -434,11 +546,12 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 {
 	divline_t dl;
 
-	if (ld->validcount == validcount)
+	int &stamp = ws->linestamps[ld->Index()];
+	if (stamp == ws->stamp)
 	{
 		return true;
 	}
-	ld->validcount = validcount;
+	stamp = ws->stamp;
 	if (P_PointOnDivlineSide (ld->v1->fPos(), &Trace) ==
 		P_PointOnDivlineSide (ld->v2->fPos(), &Trace))
 	{
@@ -456,12 +569,12 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 		if (LineBlocksSight(ld)) return false;
 	}
 
-	sightcounts[3]++;
+	ws->counts[3]++;
 	// store the line for later intersection testing
 	intercept_t newintercept;
 	newintercept.isaline = true;
 	newintercept.d.line = ld;
-	intercepts.Push (newintercept);
+	ws->intercepts.Push (newintercept);
 
 	return true;
 }
@@ -495,9 +608,10 @@ int SightCheck::P_SightBlockLinesIterator (int x, int y)
 	{
 		if (polyLink->polyobj)
 		{ // only check non-empty links
-			if (polyLink->polyobj->validcount != validcount)
+			int &stamp = ws->polystamps[unsigned(polyLink->polyobj - &Level->Polyobjects[0])];
+			if (stamp != ws->stamp)
 			{
-				polyLink->polyobj->validcount = validcount;
+				stamp = ws->stamp;
 				for (i = 0; i < polyLink->polyobj->Linedefs.Size(); i++)
 				{
 					if (!P_SightCheckLine(polyLink->polyobj->Linedefs[i]))
@@ -539,6 +653,7 @@ bool SightCheck::P_SightTraverseIntercepts ()
 	intercept_t *scan, *in;
 	unsigned scanpos;
 	divline_t dl;
+	auto &intercepts = ws->intercepts;
 
 	count = intercepts.Size ();
 //
@@ -627,8 +742,8 @@ bool SightCheck::P_SightPathTraverse ()
 	int mapx, mapy, mapxstep, mapystep;
 	int count;
 
-	validcount++;
-	intercepts.Clear ();
+	ws->stamp++;
+	ws->intercepts.Clear ();
 	x1 = sightstart.X + Startfrac * Trace.dx;
 	y1 = sightstart.Y + Startfrac * Trace.dy;
 	x2 = sightend.X;
@@ -660,11 +775,11 @@ bool SightCheck::P_SightPathTraverse ()
 	// We also must check if the starting sector contains  portals, and start sight checks in those as well.
 	if (portaldir != sector_t::floor && checkceiling && !lastsector->PortalBlocksSight(sector_t::ceiling))
 	{
-		portals.Push({ 0, topslope, bottomslope, sector_t::ceiling, lastsector->GetOppositePortalGroup(sector_t::ceiling) });
+		ws->portals.Push({ 0, topslope, bottomslope, sector_t::ceiling, lastsector->GetOppositePortalGroup(sector_t::ceiling) });
 	}
 	if (portaldir != sector_t::ceiling && checkfloor && !lastsector->PortalBlocksSight(sector_t::floor))
 	{
-		portals.Push({ 0, topslope, bottomslope, sector_t::floor, lastsector->GetOppositePortalGroup(sector_t::floor) });
+		ws->portals.Push({ 0, topslope, bottomslope, sector_t::floor, lastsector->GetOppositePortalGroup(sector_t::floor) });
 	}
 
 	x1 -= Level->blockmap.bmaporgx;
@@ -760,7 +875,7 @@ bool SightCheck::P_SightPathTraverse ()
 		itres = P_SightBlockLinesIterator(mapx, mapy);
 		if (itres == 0)
 		{
-			sightcounts[1]++;
+			ws->counts[1]++;
 			return false;	// early out
 		}
 
@@ -771,7 +886,7 @@ bool SightCheck::P_SightPathTraverse ()
 		switch (((xs_FloorToInt(yintercept) == mapy) << 1) | (xs_FloorToInt(xintercept) == mapx))
 		{
 		case 0:		// neither xintercept nor yintercept match!
-sightcounts[5]++;
+ws->counts[5]++;
 			// Continuing won't make things any better, so we might as well stop right here
 			return false;
 
@@ -790,7 +905,7 @@ sightcounts[5]++;
 			break;
 
 		case 3:		// xintercept and yintercept both match
-			sightcounts[4]++;
+			ws->counts[4]++;
 			// The trace is exiting a block through its corner. Not only does the block
 			// being entered need to be checked (which will happen when this loop
 			// continues), but the other two blocks adjacent to the corner also need to
@@ -798,7 +913,7 @@ sightcounts[5]++;
 			if (!P_SightBlockLinesIterator (mapx + mapxstep, mapy) ||
 				!P_SightBlockLinesIterator (mapx, mapy + mapystep))
 			{
-sightcounts[1]++;
+ws->counts[1]++;
 				return false;
 			}
 			xintercept += xstep;
@@ -817,53 +932,42 @@ sightcounts[1]++;
 //
 // couldn't early out, so go through the sorted list
 //
-sightcounts[2]++;
+ws->counts[2]++;
 
 	bool traverseres = P_SightTraverseIntercepts ( );
 	if (itres == -1) return false;	// if the iterator had an early out there was no line of sight. The traverser was only called to collect more portals.
 	if (seeingthing->Sector->PortalGroup != portalgroup) return false;	// We are in a different group than the seeingthing, so this trace cannot determine visibility alone.
 	return traverseres;
 }
+//==========================================================================
+//
+// P_SightPrecheck
+//
+// Everything that does not need a trace, including the random chance of
+// seeing invisible targets, which is why it must not be cached.
+// Returns 0 or 1 if the outcome is already known or -1 if a trace is needed.
+//
+//==========================================================================
 
-/*
-=====================
-=
-= P_CheckSight
-=
-= Returns true if a straight line between t1 and t2 is unobstructed
-= look from eyes of t1 to any part of t2
-=
-= killough 4/20/98: cleaned up, made to use new LOS struct
-=
-=====================
-*/
-
-int P_CheckSight (AActor *t1, AActor *t2, int flags)
+static int P_SightPrecheck(AActor *t1, AActor *t2, int flags)
 {
-	SightCycles.Clock();
-
-	bool res;
-
 	if (t1 == nullptr || t2 == nullptr)
 	{
-		return false;
+		return 0;
 	}
 
 	if ((t2->flags8 & MF8_MVISBLOCKED) && !(flags & SF_IGNOREVISIBILITY))
 	{
-		return false;
+		return 0;
 	}
 
-	auto s1 = t1->Sector;
-	auto s2 = t2->Sector;
 	//
 	// check for trivial rejection
 	//
-	if (!t1->Level->CheckReject(s1, s2))
+	if (!t1->Level->CheckReject(t1->Sector, t2->Sector))
 	{
-sightcounts[0]++;
-		res = false;			// can't possibly be connected
-		goto done;
+MainSight.counts[0]++;
+		return 0;			// can't possibly be connected
 	}
 
 //
@@ -878,10 +982,25 @@ sightcounts[0]++;
 	{ // small chance of an attack being made anyway
 		if ((t1->Level->BotInfo.m_Thinking ? pr_botchecksight() : pr_checksight()) > 50)
 		{
-			res = false;
-			goto done;
+			return 0;
 		}
 	}
+	return -1;
+}
+
+//==========================================================================
+//
+// P_SightTrace
+//
+// The geometric part of the sight check. This only depends on the two
+// actors and the level geometry, which is what makes it cacheable.
+//
+//==========================================================================
+
+static bool P_SightTrace(AActor *t1, AActor *t2, int flags, SightWorkspace &ws)
+{
+	auto s1 = t1->Sector;
+	auto s2 = t2->Sector;
 
 	// killough 4/19/98: make fake floors and ceilings block monster view
 
@@ -899,46 +1018,85 @@ sightcounts[0]++;
 			  (t2->Z() >= s2->heightsec->ceilingplane.ZatPoint(t2) &&
 			   t1->Top() <= s2->heightsec->ceilingplane.ZatPoint(t1)))))
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
 
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
 
-	validcount++;
-	portals.Clear();
+	ws.Prepare(t1->Level);
+	ws.portals.Clear();
+
+	sector_t *sec;
+	double lookheight = t1->Z() + t1->Height*0.75;
+	t1->GetPortalTransition(lookheight, &sec);
+
+	double bottomslope = t2->Z() - lookheight;
+	double topslope = bottomslope + t2->Height;
+	SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
+
+	SightCheck s(t1->Level, &ws);
+	s.init(t1, t2, sec, &task, flags);
+	if (s.P_SightPathTraverse ())
 	{
-		sector_t *sec;
-		double lookheight = t1->Z() + t1->Height*0.75;
-		t1->GetPortalTransition(lookheight, &sec);
+		return true;
+	}
 
-		double bottomslope = t2->Z() - lookheight;
-		double topslope = bottomslope + t2->Height;
-		SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
+	double dist = t1->Distance2D(t2);
+	for (unsigned i = 0; i < ws.portals.Size(); i++)
+	{
+		ws.portals[i].Frac += 1 / dist;
+		s.init(t1, t2, NULL, &ws.portals[i], flags);
+		if (s.P_SightPathTraverse())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+=====================
+=
+= P_CheckSight
+=
+= Returns true if a straight line between t1 and t2 is unobstructed
+= look from eyes of t1 to any part of t2
+=
+= killough 4/20/98: cleaned up, made to use new LOS struct
+=
+=====================
+*/
 
+int P_CheckSight (AActor *t1, AActor *t2, int flags)
+{
+	SightCycles.Clock();
 
-		SightCheck s(t1->Level);
-		s.init(t1, t2, sec, &task, flags);
-		res = s.P_SightPathTraverse ();
-		if (!res)
+	int res = P_SightPrecheck(t1, t2, flags);
+	if (res < 0)
+	{
+		if (sv_sightcache)
 		{
-			double dist = t1->Distance2D(t2);
-			for (unsigned i = 0; i < portals.Size(); i++)
+			auto &entry = P_FindSightCacheEntry(t1, t2);
+			if (P_MatchSightCache(entry, t1, t2, flags))
 			{
-				portals[i].Frac += 1 / dist;
-				s.init(t1, t2, NULL, &portals[i], flags);
-				if (s.P_SightPathTraverse())
-				{
-					res = true;
-					break;
-				}
+				sightcachehits++;
+				res = entry.result;
+			}
+			else
+			{
+				sightcachemisses++;
+				res = P_SightTrace(t1, t2, flags, MainSight);
+				P_StoreSightCache(entry, t1, t2, flags, res);
 			}
 		}
+		else
+		{
+			res = P_SightTrace(t1, t2, flags, MainSight);
+		}
 	}
 
-done:
 	SightCycles.Unclock();
 	return res;
 }
@@ -946,9 +1104,11 @@ done:
 ADD_STAT (sight)
 {
 	FString out;
-	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d\n",
+	int lookups = sightcachehits + sightcachemisses;
+	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d, cache %d/%d (%.1f%%)\n",
 		SightCycles.TimeMS(), MaxSightCycles.TimeMS(),
-		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5]);
+		MainSight.counts[3], MainSight.counts[0], MainSight.counts[1], MainSight.counts[2], MainSight.counts[4], MainSight.counts[5],
+		sightcachehits, lookups, lookups > 0 ? sightcachehits * 100. / lookups : 0.);
 	return out;
 }
 
@@ -957,11 +1117,13 @@ void P_ResetSightCounters (bool full)
 	if (full)
 	{
 		MaxSightCycles.Reset();
+		P_InvalidateSightCache();
 	}
 	if (SightCycles.Time() > MaxSightCycles.Time())
 	{
 		MaxSightCycles = SightCycles;
 	}
 	SightCycles.Reset();
-	memset (sightcounts, 0, sizeof(sightcounts));
+	memset (MainSight.counts, 0, sizeof(MainSight.counts));
+	sightcachehits = sightcachemisses = 0;
 }
@@ -1481,17 +1481,11 @@ void P_PredictPlayer (player_t *player)
 
 	// Blockmap ordering also needs to stay the same, so unlink the block nodes
 	// without releasing them. (They will be used again in P_UnpredictPlayer).
-	FBlockNode *block = act->BlockNode;
-
-	while (block != NULL)
+	for (FBlockNode *block = act->BlockNode; block != NULL; block = block->NextBlock)
 	{
-		if (block->NextActor != NULL)
-		{
-			block->NextActor->PrevActor = block->PrevActor;
-		}
-		*(block->PrevActor) = block->NextActor;
-		block = block->NextBlock;
+		act->Level->blockmap.UnlinkThing(block);
 	}
+	act->Level->blockmap.keepholes = true;
 	act->BlockNode = NULL;
 
 	// This essentially acts like a mini P_Ticker where only the stuff relevant to the client is actually
@@ -1631,18 +1625,12 @@ void P_UnPredictPlayer ()
 			act->touching_lineportallist = RestoreNodeList(act, lineportal_list, &FLinePortal::lineportal_thinglist, PredictionPortalLines_sprev_Backup, PredictionPortalLinesBackup);
 		}
 
-		// Now fix the pointers in the blocknode chain
-		FBlockNode *block = act->BlockNode;
-
-		while (block != NULL)
+		// Now put the block nodes back where they were. No block was compacted in the meantime so their places are still free.
+		for (FBlockNode *block = act->BlockNode; block != NULL; block = block->NextBlock)
 		{
-			*(block->PrevActor) = block;
-			if (block->NextActor != NULL)
-			{
-				block->NextActor->PrevActor = &block->NextActor;
-			}
-			block = block->NextBlock;
+			act->Level->blockmap.RelinkThing(block, act->BlockNode->NextBlock == nullptr);
 		}
+		act->Level->blockmap.keepholes = false;
 
 		actInvSel = InvSel;
 		player->inventorytics = inventorytics;
@@ -996,6 +996,9 @@ void FPolyObj::UnLinkPolyobj ()
 	int i, j;
 	int index;
 
+	// The lines are about to move, so results cached until now may no longer be valid.
+	P_InvalidateSightCache();
+
 	// remove the polyobj from each blockmap section
 	for(j = bbox[BOXBOTTOM]; j <= bbox[BOXTOP]; j++)
 	{
@@ -1028,7 +1031,6 @@ void FPolyObj::UnLinkPolyobj ()
 bool FPolyObj::CheckMobjBlocking (side_t *sd)
 {
 	static TArray<AActor *> checker;
-	FBlockNode *block;
 	AActor *mobj;
 	int i, j, k;
 	int left, right, top, bottom;
@@ -1061,9 +1063,12 @@ bool FPolyObj::CheckMobjBlocking (side_t *sd)
 	{
 		for (i = left; i <= right; i++)
 		{
-			for (block = Level->blockmap.blocklinks[j+i]; block != nullptr; block = block->NextActor)
+			auto &things = Level->blockmap.blockthings[j+i];
+			// Iterate by index because damaging the actors may relink them.
+			for (int b = (int)things.Size() - 1; b >= 0; b = min(b, (int)things.Size()) - 1)
 			{
-				mobj = block->Me;
+				mobj = things[b].Me;
+				if (mobj == nullptr) continue;
 				for (k = (int)checker.Size()-1; k >= 0; --k)
 				{
 					if (checker[k] == mobj)
@@ -1161,6 +1166,8 @@ void FPolyObj::LinkPolyobj ()
 	int bmapwidth = Level->blockmap.bmapwidth;
 	int bmapheight = Level->blockmap.bmapheight;
 
+	P_InvalidateSightCache();
+
 	// calculate the polyobj bbox
 	Bounds.ClearBox();
 	for(unsigned i = 0; i < Sidedefs.Size(); i++)
@@ -55,6 +55,8 @@
 EXTERN_CVAR(Bool, cl_capfps)
 extern bool NoInterpolateView;
 
+void hw_PrefetchTextures(sector_t *viewsector);
+
 static SWSceneDrawer *swdrawer;
 
 void CleanSWDrawer()
@@ -401,6 +403,7 @@ sector_t* RenderView(player_t* player)
 		screen->ImageTransitionScene(true); // Only relevant for Vulkan.
 
 		retsec = RenderViewpoint(r_viewpoint, player->camera, NULL, r_viewpoint.FieldOfView.Degrees(), ratio, fovratio, true, true);
+		hw_PrefetchTextures(retsec);
 	}
 	All.Unclock();
 	return retsec;
@@ -40,8 +40,50 @@
 #include "modelrenderer.h"
 #include "hw_models.h"
 #include "d_main.h"
+#include "texdecode.h"
+#include "p_maputl.h"
+#include "r_sky.h"
+#include "i_time.h"
 
 EXTERN_CVAR(Bool, gl_precache)
+EXTERN_CVAR(Int, gl_texture_decodethreads)
+
+CVAR(Int, gl_texture_prefetchdepth, 2, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+// With no budget at all the prefetched textures would never get uploaded.
+CUSTOM_CVAR(Float, gl_texture_uploadbudget, 2.f, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0.25f) self = 0.25f;
+}
+
+struct FPrefetchMaterial
+{
+	FTextureID Texture;
+	int ScaleFlags;
+};
+
+static TArray<FPrefetchMaterial> PrefetchList;	// materials waiting for their layers to be decoded
+static TMap<int, bool> PrefetchSeen;			// textures that have been queued or precached in this level
+static sector_t *PrefetchSector;
+
+//==========================================================================
+//
+// Hands the material's layers to the decoder threads. Returns false if
+// there was nothing to decode.
+//
+//==========================================================================
+
+static bool QueueMaterial(FMaterial *mat)
+{
+	bool queued = false;
+	for (auto &layer : mat->GetLayerArray())
+	{
+		if (layer.layerTexture && layer.layerTexture->GetImage())
+		{
+			queued |= TexDecode_Queue(layer.layerTexture, 0, layer.scaleFlags | CTF_ProcessData);
+		}
+	}
+	return queued;
+}
 
 //==========================================================================
 //
@@ -298,8 +340,34 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 			}
 		}
 
-		// cache all used textures
+		// decode the untranslated textures on the worker threads, starting at the end of the list
 		for (int i = cnt - 1; i >= 0; i--)
+		{
+			auto gtex = TexMan.GameByIndex(i);
+			if (gtex != nullptr)
+			{
+				if (texhitlist[i] & (FTextureManager::HIT_Wall | FTextureManager::HIT_Flat | FTextureManager::HIT_Sky))
+				{
+					int scaleflags = 0;
+					if (shouldUpscale(gtex, UF_Texture)) scaleflags |= CTF_Upscale;
+
+					FMaterial* mat = FMaterial::ValidateTexture(gtex, scaleflags);
+					if (mat != nullptr) QueueMaterial(mat);
+					PrefetchSeen.Insert(i, true);
+				}
+				if (spritehitlist[i] != nullptr && (*spritehitlist[i]).CheckKey(0))
+				{
+					int scaleflags = CTF_Expand;
+					if (shouldUpscale(gtex, UF_Sprite)) scaleflags |= CTF_Upscale;
+
+					FMaterial* mat = FMaterial::ValidateTexture(gtex, scaleflags);
+					if (mat != nullptr) QueueMaterial(mat);
+				}
+			}
+		}
+
+		// cache all used textures, starting at the front so that the main thread and the decoder threads meet in the middle.
+		for (int i = 0; i < cnt; i++)
 		{
 			auto gtex = TexMan.GameByIndex(i);
 			if (gtex != nullptr)
@@ -312,7 +380,8 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 			}
 		}
 
-
+		// Textures that still had their hardware texture from the last level never picked up their buffer.
+		TexDecode_Clear();
 		FImageSource::EndPrecaching();
 
 		// cache all used models
@@ -333,3 +402,127 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 	delete[] modellist;
 }
 
+
+//==========================================================================
+//
+// Called by the level setup before anything gets precached.
+//
+//==========================================================================
+
+void hw_ClearPrefetch()
+{
+	TexDecode_Clear();
+	PrefetchList.Clear();
+	PrefetchSeen.Clear();
+	PrefetchSector = nullptr;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void PrefetchTexture(FTextureID texid)
+{
+	if (!texid.isValid() || texid == skyflatnum) return;
+
+	auto tex = TexMan.GetGameTexture(texid, true);
+	if (tex == nullptr || !tex->isValid()) return;
+
+	texid = tex->GetID();
+	if (PrefetchSeen.CheckKey(texid.GetIndex())) return;
+	PrefetchSeen.Insert(texid.GetIndex(), true);
+
+	int scaleflags = 0;
+	if (shouldUpscale(tex, UF_Texture)) scaleflags |= CTF_Upscale;
+
+	FMaterial* mat = FMaterial::ValidateTexture(tex, scaleflags);
+	if (mat != nullptr && QueueMaterial(mat)) PrefetchList.Push({ texid, scaleflags });
+}
+
+//==========================================================================
+//
+// Called once per frame with the main view's sector.
+//
+// Whenever the view enters a new sector, the textures of all sectors within
+// gl_texture_prefetchdepth steps through two-sided lines get decoded on the
+// worker threads, unless the level's precaching already uploaded them. The
+// finished ones get uploaded here for at most gl_texture_uploadbudget ms
+// per frame. Textures that are needed before they are ready are still
+// created on demand by the renderer, just like without prefetching.
+//
+//==========================================================================
+
+void hw_PrefetchTextures(sector_t *viewsector)
+{
+	if (viewsector == nullptr || gl_texture_decodethreads <= 0) return;
+
+	if (viewsector != PrefetchSector)
+	{
+		PrefetchSector = viewsector;
+
+		TArray<sector_t *> sectors;
+		validcount++;
+		viewsector->validcount = validcount;
+		sectors.Push(viewsector);
+
+		unsigned index = 0;
+		for (int depth = 0; depth <= gl_texture_prefetchdepth && index < sectors.Size(); depth++)
+		{
+			for (unsigned end = sectors.Size(); index < end; index++)
+			{
+				auto sec = sectors[index];
+				PrefetchTexture(sec->GetTexture(sector_t::floor));
+				PrefetchTexture(sec->GetTexture(sector_t::ceiling));
+
+				for (auto line : sec->Lines)
+				{
+					for (auto side : line->sidedef)
+					{
+						if (side == nullptr) continue;
+						PrefetchTexture(side->GetTexture(side_t::top));
+						PrefetchTexture(side->GetTexture(side_t::mid));
+						PrefetchTexture(side->GetTexture(side_t::bottom));
+					}
+
+					auto other = line->frontsector == sec ? line->backsector : line->frontsector;
+					if (other != nullptr && other->validcount != validcount)
+					{
+						other->validcount = validcount;
+						sectors.Push(other);
+					}
+				}
+			}
+		}
+	}
+
+	double start = I_msTimeF();
+	for (unsigned i = 0; i < PrefetchList.Size() && I_msTimeF() - start < gl_texture_uploadbudget; )
+	{
+		auto tex = TexMan.GetGameTexture(PrefetchList[i].Texture);
+		FMaterial* mat = tex == nullptr ? nullptr : FMaterial::ValidateTexture(tex, PrefetchList[i].ScaleFlags);
+		if (mat != nullptr)
+		{
+			bool pending = false;
+			for (auto &layer : mat->GetLayerArray())
+			{
+				if (layer.layerTexture && TexDecode_State(layer.layerTexture) == TDS_Pending) pending = true;
+			}
+			if (pending)
+			{
+				i++;
+				continue;
+			}
+
+			screen->PrecacheMaterial(mat, 0);
+
+			// If the renderer has already created the texture, the decoded buffer is still there.
+			for (auto &layer : mat->GetLayerArray())
+			{
+				if (layer.layerTexture) TexDecode_Cancel(layer.layerTexture);
+			}
+		}
+		PrefetchList.Delete(i);
+	}
+}
@@ -44,11 +44,22 @@
 #include "hw_vertexbuilder.h"
 #include "hw_walldispatcher.h"
 
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
 #ifdef ARCH_IA32
 #include <immintrin.h>
 #endif // ARCH_IA32
 
 CVAR(Bool, gl_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CUSTOM_CVAR(Int, gl_renderthreads, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	// 0 means to pick a value based on the number of available cores.
+	if (self < 0) self = 0;
+	else if (self > MAX_RENDER_WORKERS) self = MAX_RENDER_WORKERS;
+}
 
 EXTERN_CVAR(Float, r_actorspriteshadowdist)
 
@@ -65,12 +76,16 @@ struct RenderJob
 		SpriteJob,
 		ParticleJob,
 		PortalJob,
-		TerminateJob	// inserted when all work is done so that the worker can return.
 	};
 	
 	int type;
 	subsector_t *sub;
 	seg_t *seg;
+
+	// Filled in by the worker that processed this job if more than one worker is active.
+	int worker;
+	unsigned firstoutput;
+	unsigned numoutputs;
 };
 
 
@@ -79,6 +94,22 @@ class RenderJobQueue
 	RenderJob pool[300000];	// Way more than ever needed. The largest ever seen on a single viewpoint is around 40000.
 	std::atomic<int> readindex{};
 	std::atomic<int> writeindex{};
+	std::atomic<int> sleepers{};
+	std::atomic<bool> finished{};
+	std::mutex waitMutex;
+	std::condition_variable waitCond;
+
+	void WakeWorkers()
+	{
+		// A worker always registers itself as sleeping before checking the queue state one last time,
+		// so if no sleeper can be seen here, any worker about to go to sleep is guaranteed to see the new state.
+		if (sleepers > 0)
+		{
+			std::lock_guard<std::mutex> lock(waitMutex);
+			waitCond.notify_all();
+		}
+	}
+
 public:
 	void AddJob(int type, subsector_t *sub, seg_t *seg = nullptr)
 	{
@@ -86,131 +117,356 @@ public:
 
 		pool[writeindex] = { type, sub, seg };
 		writeindex++;	// update index only after the value has been written.
+		WakeWorkers();
+	}
+
+	// Returns the index of the next job or -1 if all jobs have been processed.
+	int GetJob()
+	{
+		int spins = 0;
+		while (true)
+		{
+			int index = readindex;
+			while (index < writeindex)
+			{
+				if (readindex.compare_exchange_weak(index, index + 1)) return index;
+			}
+			if (finished && readindex >= writeindex) return -1;
+
+			if (++spins < 64)
+			{
+#ifdef ARCH_IA32
+				// Yielding right away would be too costly here and possibly cause further delays down the line if the thread is halted.
+				// So instead add a few pause instructions and retry immediately.
+				_mm_pause();
+				_mm_pause();
+				_mm_pause();
+				_mm_pause();
+#endif // ARCH_IA32
+				continue;
+			}
+
+			// The BSP traversal is not producing anything right now so go to sleep until it does.
+			std::unique_lock<std::mutex> lock(waitMutex);
+			sleepers++;
+			waitCond.wait(lock, [this] { return readindex < writeindex || finished; });
+			sleepers--;
+			spins = 0;
+		}
+	}
+
+	RenderJob &operator[](int index)
+	{
+		return pool[index];
 	}
 
-	RenderJob *GetJob()
+	int Size() const
 	{
-		if (readindex < writeindex) return &pool[readindex++];
-		return nullptr;
+		return writeindex;
+	}
+
+	void Finish()
+	{
+		finished = true;
+		WakeWorkers();
 	}
 	
 	void ReleaseAll()
 	{
 		readindex = 0;
 		writeindex = 0;
+		finished = false;
 	}
 };
 
 static RenderJobQueue jobQueue;	// One static queue is sufficient here. This code will never be called recursively.
 
-void HWDrawInfo::WorkerThread()
+//==========================================================================
+//
+// With more than one worker the jobs get processed out of order, so
+// everything they produce gets collected per worker and merged back
+// into the draw info in job order once the traversal is complete.
+// This keeps the draw lists identical to what a single worker produces.
+//
+//==========================================================================
+
+struct RenderJobOutput
+{
+	enum
+	{
+		DrawItem,	// data is a draw item for drawlists[list]
+		Thing,		// data is an actor whose sprites follow. nullptr ends the current group.
+		Action,		// list is the index of a deferred action
+		Sprite		// counts a rendered sprite unless its thing gets skipped
+	};
+
+	int kind;
+	int list;
+	HWDrawItemType type;
+	void *data;
+};
+
+struct HWRenderWorker
+{
+	FMemArena Allocator{ 256 * 1024 };
+	TArray<RenderJobOutput> Output;
+	std::vector<std::function<void()>> Actions;	// TArray cannot be used here because it relocates its contents with realloc.
+	int RenderedLines = 0, RenderedFlats = 0, RenderedSprites = 0;
+};
+
+static HWRenderWorker renderWorkers[MAX_RENDER_WORKERS];
+static thread_local HWRenderWorker *currentRenderWorker;	// only set if the worker's output needs to be merged
+static thread_local HWRenderWorker *currentStatsWorker;
+
+void CountRenderedFlat()
+{
+	if (currentStatsWorker) currentStatsWorker->RenderedFlats++;
+	else rendered_flats++;
+}
+
+void CountRenderedSprite()
+{
+	// Things seen by several workers only count once, which is not known before the merge.
+	if (currentRenderWorker) currentRenderWorker->Output.Push({ RenderJobOutput::Sprite, 0, DrawType_SPRITE, nullptr });
+	else if (currentStatsWorker) currentStatsWorker->RenderedSprites++;
+	else rendered_sprites++;
+}
+
+static void MergeRenderStats(int numworkers)
+{
+	for (int i = 0; i < numworkers; i++)
+	{
+		auto &worker = renderWorkers[i];
+		rendered_lines += worker.RenderedLines;
+		rendered_flats += worker.RenderedFlats;
+		rendered_sprites += worker.RenderedSprites;
+		worker.RenderedLines = worker.RenderedFlats = worker.RenderedSprites = 0;
+	}
+}
+
+void ResetRenderWorkerAllocators()
+{
+	for (auto &worker : renderWorkers)
+	{
+		worker.Allocator.FreeAll();
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void *HWDrawInfo::NewDrawItem(int list, HWDrawItemType type, size_t size)
+{
+	auto worker = currentRenderWorker;
+	if (worker == nullptr)
+	{
+		void *item = RenderDataAllocator.Alloc(size);
+		drawlists[list].AddItem(type, item);
+		return item;
+	}
+	void *item = worker->Allocator.Alloc(size);
+	worker->Output.Push({ RenderJobOutput::DrawItem, list, type, item });
+	return item;
+}
+
+bool HWDrawInfo::DeferToMerge(std::function<void()> &&action)
+{
+	auto worker = currentRenderWorker;
+	if (worker == nullptr) return false;
+	worker->Output.Push({ RenderJobOutput::Action, (int)worker->Actions.size(), DrawType_WALL, nullptr });
+	worker->Actions.push_back(std::move(action));
+	return true;
+}
+
+bool HWDrawInfo::DeferThingCheck(AActor *thing)
+{
+	auto worker = currentRenderWorker;
+	if (worker == nullptr) return false;
+	worker->Output.Push({ RenderJobOutput::Thing, 0, DrawType_SPRITE, thing });
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void HWDrawInfo::ProcessRenderJob(RenderJob *job, HWWallDispatcher &disp, bool timed)
 {
 	sector_t *front, *back;
-	HWWallDispatcher disp(this);
 
-	WTTotal.Clock();
-	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
-	while (true)
+	// Note that the main thread MUST have prepared the fake sectors that get used below!
+	// This worker thread cannot prepare them itself without costly synchronization.
+	switch (job->type)
+	{
+	case RenderJob::WallJob:
 	{
-		auto job = jobQueue.GetJob();
-		if (job == nullptr)
+		HWWall wall;
+		if (timed) SetupWall.Clock();
+		wall.sub = job->sub;
+
+		front = hw_FakeFlat(job->sub->sector, in_area, false);
+		auto seg = job->seg;
+		auto backsector = seg->backsector;
+		if (!backsector && seg->linedef->isVisualPortal() && seg->sidedef == seg->linedef->sidedef[0]) // For one-sided portals use the portal's destination sector as backsector.
 		{
-#ifdef ARCH_IA32
-			// The queue is empty. But yielding would be too costly here and possibly cause further delays down the line if the thread is halted.
-			// So instead add a few pause instructions and retry immediately.
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-#endif // ARCH_IA32
+			auto portal = seg->linedef->getPortal();
+			backsector = portal->mDestination->frontsector;
+			back = hw_FakeFlat(backsector, in_area, true);
+			if (front->floorplane.isSlope() || front->ceilingplane.isSlope() || back->floorplane.isSlope() || back->ceilingplane.isSlope())
+			{
+				// Having a one-sided portal like this with slopes is too messy so let's ignore that case.
+				back = nullptr;
+			}
 		}
-		// Note that the main thread MUST have prepared the fake sectors that get used below!
-		// This worker thread cannot prepare them itself without costly synchronization.
-		else switch (job->type)
+		else if (backsector)
 		{
-		case RenderJob::TerminateJob:
-			WTTotal.Unclock();
-			return;
-
-		case RenderJob::WallJob:
-		{
-			HWWall wall;
-			SetupWall.Clock();
-			wall.sub = job->sub;
-
-			front = hw_FakeFlat(job->sub->sector, in_area, false);
-			auto seg = job->seg;
-			auto backsector = seg->backsector;
-			if (!backsector && seg->linedef->isVisualPortal() && seg->sidedef == seg->linedef->sidedef[0]) // For one-sided portals use the portal's destination sector as backsector.
+			if (front->sectornum == backsector->sectornum || (seg->sidedef->Flags & WALLF_POLYOBJ))
 			{
-				auto portal = seg->linedef->getPortal();
-				backsector = portal->mDestination->frontsector;
-				back = hw_FakeFlat(backsector, in_area, true);
-				if (front->floorplane.isSlope() || front->ceilingplane.isSlope() || back->floorplane.isSlope() || back->ceilingplane.isSlope())
-				{
-					// Having a one-sided portal like this with slopes is too messy so let's ignore that case.
-					back = nullptr;
-				}
+				back = front;
 			}
-			else if (backsector)
+			else
 			{
-				if (front->sectornum == backsector->sectornum || (seg->sidedef->Flags & WALLF_POLYOBJ))
-				{
-					back = front;
-				}
-				else
-				{
-					back = hw_FakeFlat(backsector, in_area, true);
-				}
+				back = hw_FakeFlat(backsector, in_area, true);
 			}
-			else back = nullptr;
-
-			wall.Process(&disp, job->seg, front, back);
-			rendered_lines++;
-			SetupWall.Unclock();
-			break;
 		}
+		else back = nullptr;
+
+		wall.Process(&disp, job->seg, front, back);
+		currentStatsWorker->RenderedLines++;
+		if (timed) SetupWall.Unclock();
+		break;
+	}
 
-		case RenderJob::FlatJob:
+	case RenderJob::FlatJob:
+	{
+		HWFlat flat;
+		if (timed) SetupFlat.Clock();
+		flat.section = job->sub->section;
+		front = hw_FakeFlat(job->sub->render_sector, in_area, false);
+		flat.ProcessSector(this, front);
+		if (timed) SetupFlat.Unclock();
+		break;
+	}
+
+	case RenderJob::SpriteJob:
+		if (timed) SetupSprite.Clock();
+		front = hw_FakeFlat(job->sub->sector, in_area, false);
+		RenderThings(job->sub, front);
+		if (timed) SetupSprite.Unclock();
+		break;
+
+	case RenderJob::ParticleJob:
+		if (timed) SetupSprite.Clock();
+		front = hw_FakeFlat(job->sub->sector, in_area, false);
+		RenderParticles(job->sub, front);
+		if (timed) SetupSprite.Unclock();
+		break;
+
+	case RenderJob::PortalJob:
+	{
+		auto portal = (FSectorPortalGroup *)job->seg;
+		auto sub = job->sub;
+		if (!DeferToMerge([=]() { AddSubsectorToPortal(portal, sub); }))
 		{
-			HWFlat flat;
-			SetupFlat.Clock();
-			flat.section = job->sub->section;
-			front = hw_FakeFlat(job->sub->render_sector, in_area, false);
-			flat.ProcessSector(this, front);
-			SetupFlat.Unclock();
-			break;
+			AddSubsectorToPortal(portal, sub);
 		}
+		break;
+	}
+	}
+}
 
-		case RenderJob::SpriteJob:
-			SetupSprite.Clock();
-			front = hw_FakeFlat(job->sub->sector, in_area, false);
-			RenderThings(job->sub, front);
-			SetupSprite.Unclock();
-			break;
+//==========================================================================
+//
+//
+//
+//==========================================================================
 
-		case RenderJob::ParticleJob:
-			SetupSprite.Clock();
-			front = hw_FakeFlat(job->sub->sector, in_area, false);
-			RenderParticles(job->sub, front);
-			SetupSprite.Unclock();
-			break;
+void HWDrawInfo::WorkerThread(int workerindex)
+{
+	HWWallDispatcher disp(this);
+	bool timed = workerindex == 0;	// the timers are not thread safe so only the first worker may update them.
+	auto worker = multithread > 1 ? &renderWorkers[workerindex] : nullptr;
 
-		case RenderJob::PortalJob:
-			AddSubsectorToPortal((FSectorPortalGroup *)job->seg, job->sub);
-			break;
-		}
+	if (timed) WTTotal.Clock();
+	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
+	currentRenderWorker = worker;
+	currentStatsWorker = &renderWorkers[workerindex];
+	while (true)
+	{
+		int index = jobQueue.GetJob();
+		if (index < 0) break;
 
+		auto &job = jobQueue[index];
+		if (worker != nullptr)
+		{
+			job.worker = workerindex;
+			job.firstoutput = worker->Output.Size();
+			ProcessRenderJob(&job, disp, timed);
+			job.numoutputs = worker->Output.Size() - job.firstoutput;
+		}
+		else
+		{
+			ProcessRenderJob(&job, disp, timed);
+		}
 	}
+	currentRenderWorker = nullptr;
+	currentStatsWorker = nullptr;
+	if (timed) WTTotal.Unclock();
 }
 
+//==========================================================================
+//
+// Runs on the main thread after all workers are done.
+//
+//==========================================================================
+
+void HWDrawInfo::MergeRenderJobs(int numjobs)
+{
+	for (int i = 0; i < numjobs; i++)
+	{
+		auto &job = jobQueue[i];
+		auto &worker = renderWorkers[job.worker];
+		bool skipthing = false;
 
+		for (unsigned j = job.firstoutput; j < job.firstoutput + job.numoutputs; j++)
+		{
+			auto &out = worker.Output[j];
+			switch (out.kind)
+			{
+			case RenderJobOutput::DrawItem:
+				if (!skipthing) drawlists[out.list].AddItem(out.type, out.data);
+				break;
+
+			case RenderJobOutput::Thing:
+			{
+				// Things touching multiple sectors may have been processed by several workers, only the first one in job order may be used.
+				auto thing = (AActor *)out.data;
+				skipthing = thing != nullptr && thing->validcount == validcount;
+				if (thing != nullptr) thing->validcount = validcount;
+				break;
+			}
+
+			case RenderJobOutput::Action:
+				worker.Actions[out.list]();
+				break;
+
+			case RenderJobOutput::Sprite:
+				if (!skipthing) rendered_sprites++;
+				break;
+			}
+		}
+	}
+	for (auto &worker : renderWorkers)
+	{
+		worker.Output.Clear();
+		worker.Actions.clear();
+	}
+}
 
 
 
@@ -530,8 +786,11 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 	for (auto p = sec->touching_renderthings; p != nullptr; p = p->m_snext)
 	{
 		auto thing = p->m_thing;
-		if (thing->validcount == validcount) continue;
-		thing->validcount = validcount;
+		if (!DeferThingCheck(thing))
+		{
+			if (thing->validcount == validcount) continue;
+			thing->validcount = validcount;
+		}
 
 		FIntCVar *cvar = thing->GetInfo()->distancecheck;
 		if (cvar != nullptr && *cvar >= 0)
@@ -562,7 +821,8 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 			sprite.Process(this, thing, sector, in_area, false);
 		}
 	}
-	
+
+	DeferThingCheck(nullptr);	// the following things are not subject to the validcount check.
 	for (msecnode_t *node = sec->sectorportal_thinglist; node; node = node->m_snext)
 	{
 		AActor *thing = node->m_thing;
@@ -596,7 +856,6 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 
 void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 {
-	SetupSprite.Clock();
 	for (uint32_t i = 0; i < sub->sprites.Size(); i++)
 	{
 		DVisualThinker *sp = sub->sprites[i];
@@ -612,7 +871,7 @@ void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 
 		sp->spr->ProcessParticle(this, &sp->PT, front, sp);
 	}
-	for (int i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
+	for (uint32_t i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
 	{
 		if (mClipPortal)
 		{
@@ -623,7 +882,6 @@ void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 		HWSprite sprite;
 		sprite.ProcessParticle(this, &Level->Particles[i], front, nullptr);
 	}
-	SetupSprite.Unclock();
 }
 
 
@@ -862,16 +1120,33 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	multithread = gl_multithread;
 	if (multithread)
 	{
+		int numworkers = gl_renderthreads;
+		if (numworkers == 0) numworkers = clamp<int>(std::thread::hardware_concurrency() / 2, 1, MAX_RENDER_WORKERS);
+		if (renderPool.size() < numworkers) renderPool.resize(numworkers);
+		multithread = numworkers;
+
 		jobQueue.ReleaseAll();
-		auto future = renderPool.push([&](int id) {
-			WorkerThread();
-		});
+		std::future<void> futures[MAX_RENDER_WORKERS];
+		for (int i = 0; i < numworkers; i++)
+		{
+			futures[i] = renderPool.push([=](int id) {
+				WorkerThread(i);
+			});
+		}
 		RenderBSPNode(node);
 
-		jobQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+		jobQueue.Finish();
 		Bsp.Unclock();
 		MTWait.Clock();
-		future.wait();
+		for (int i = 0; i < numworkers; i++)
+		{
+			futures[i].wait();
+		}
+		MergeRenderStats(numworkers);
+		if (numworkers > 1)
+		{
+			MergeRenderJobs(jobQueue.Size());
+		}
 		MTWait.Unclock();
 	}
 	else
@@ -44,81 +44,98 @@ unsigned Clipper::starttime;
 Clipper::Clipper()
 {
 	starttime++;
+	memset(touched, 0, sizeof(touched));
 }
 
 //-----------------------------------------------------------------------------
 //
-// RemoveRange
+// Clear
 //
 //-----------------------------------------------------------------------------
 
-void Clipper::RemoveRange(ClipNode * range)
+void Clipper::Clear()
 {
-	if (range == cliphead)
-	{
-		cliphead = cliphead->next;
-	}
-	else
-	{
-		if (range->prev) range->prev->next = range->next;
-		if (range->next) range->next->prev = range->prev;
-	}
-	
-	Free(range);
+	blocked = false;
+	ranges.Clear();
+	silhouette.Clear();
+	memset(touched, 0, sizeof(touched));
+	starttime++;
 }
 
 //-----------------------------------------------------------------------------
 //
-// Clear
+// SetSilhouette
 //
 //-----------------------------------------------------------------------------
 
-void Clipper::Clear()
+void Clipper::SetSilhouette()
 {
-	ClipNode *node = cliphead;
-	ClipNode *temp;
-	
-	blocked = false;
-	while (node != NULL)
+	silhouette = ranges;
+}
+
+//-----------------------------------------------------------------------------
+//
+// FindRange
+//
+// Returns the index of the first range that ends at or after the given
+// angle, i.e. the first one that can overlap something starting there.
+//
+//-----------------------------------------------------------------------------
+
+unsigned Clipper::FindRange(angle_t start) const
+{
+	unsigned lo = 0, hi = ranges.Size();
+	while (lo < hi)
 	{
-		temp = node;
-		node = node->next;
-		Free(temp);
+		unsigned mid = (lo + hi) / 2;
+		if (ranges[mid].end < start) lo = mid + 1;
+		else hi = mid;
 	}
-	node = silhouette;
+	return lo;
+}
 
-	while (node != NULL)
+//-----------------------------------------------------------------------------
+//
+// MarkTouched
+//
+//-----------------------------------------------------------------------------
+
+void Clipper::MarkTouched(angle_t startangle, angle_t endangle)
+{
+	unsigned first = startangle >> BUCKET_SHIFT;
+	unsigned last = endangle >> BUCKET_SHIFT;
+
+	for (unsigned word = first / 64; word <= last / 64; word++)
 	{
-		temp = node;
-		node = node->next;
-		Free(temp);
+		uint64_t mask = ~0ull;
+		if (word == first / 64) mask &= ~0ull << (first & 63);
+		if (word == last / 64) mask &= ~0ull >> (63 - (last & 63));
+		touched[word] |= mask;
 	}
-	
-	cliphead = NULL;
-	silhouette = NULL;
-	starttime++;
 }
 
 //-----------------------------------------------------------------------------
 //
-// SetSilhouette
+// AllTouched
+//
+// Returns false if any bucket overlapping the range has never been
+// touched, which means that some part of the range cannot be occluded.
 //
 //-----------------------------------------------------------------------------
 
-void Clipper::SetSilhouette()
+bool Clipper::AllTouched(angle_t startangle, angle_t endangle) const
 {
-	ClipNode *node = cliphead;
-	ClipNode *last = NULL;
+	unsigned first = startangle >> BUCKET_SHIFT;
+	unsigned last = endangle >> BUCKET_SHIFT;
 
-	while (node != NULL)
+	for (unsigned word = first / 64; word <= last / 64; word++)
 	{
-		ClipNode *snode = NewRange(node->start, node->end);
-		if (silhouette == NULL) silhouette = snode;
-		snode->prev = last;
-		if (last != NULL) last->next = snode;
-		last = snode;
-		node = node->next;
+		uint64_t mask = ~0ull;
+		if (word == first / 64) mask &= ~0ull << (first & 63);
+		if (word == last / 64) mask &= ~0ull >> (63 - (last & 63));
+		if ((touched[word] & mask) != mask) return false;
 	}
+	return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -129,20 +146,16 @@ void Clipper::SetSilhouette()
 
 bool Clipper::IsRangeVisible(angle_t startAngle, angle_t endAngle)
 {
-	ClipNode *ci;
-	ci = cliphead;
-	
-	if (endAngle==0 && ci && ci->start==0) return false;
-	
-	while (ci != NULL && ci->start < endAngle)
+	if (ranges.Size() == 0) return true;
+	if (endAngle == 0 && ranges[0].start == 0) return false;
+	if (!AllTouched(startAngle, endAngle)) return true;
+
+	// Ranges may touch but never overlap, so only those starting at or before
+	// the first one that reaches startAngle can contain the whole range.
+	for (unsigned i = FindRange(startAngle); i < ranges.Size() && ranges[i].start <= startAngle && ranges[i].start < endAngle; i++)
 	{
-		if (startAngle >= ci->start && endAngle <= ci->end)
-		{
-			return false;
-		}
-		ci = ci->next;
+		if (ranges[i].end >= endAngle) return false;
 	}
-	
 	return true;
 }
 
@@ -154,100 +167,33 @@ bool Clipper::IsRangeVisible(angle_t startAngle, angle_t endAngle)
 
 void Clipper::AddClipRange(angle_t start, angle_t end)
 {
-	ClipNode *node, *temp, *prevNode;
+	unsigned i = FindRange(start);
 
-	if (cliphead)
+	if (i < ranges.Size() && ranges[i].start <= end)
 	{
-		//check to see if range contains any old ranges
-		node = cliphead;
-		while (node != NULL && node->start < end)
+		// The new range overlaps or touches this one.
+		auto &range = ranges[i];
+		if (range.start <= start && range.end >= end && (range.start < start || range.end > end))
 		{
-			if (node->start >= start && node->end <= end)
-			{
-				temp = node;
-				node = node->next;
-				RemoveRange(temp);
-			}
-			else if (node->start<=start && node->end>=end)
-			{
-				return;
-			}
-			else
-			{
-				node = node->next;
-			}
+			return;
 		}
-		
-		//check to see if range overlaps a range (or possibly 2)
-		node = cliphead;
-		while (node != NULL && node->start <= end)
-		{
-			if (node->end >= start)
-			{
-				// we found the first overlapping node
-				if (node->start > start)
-				{
-					// the new range overlaps with this node's start point
-					node->start = start;
-				}
-
-				if (node->end < end) 
-				{
-					node->end = end;
-				}
-
-				ClipNode *node2 = node->next;
-				while (node2 && node2->start <= node->end)
-				{
-					if (node2->end > node->end) node->end = node2->end;
-					ClipNode *delnode = node2;
-					node2 = node2->next;
-					RemoveRange(delnode);
-				}
-				return;
-			}
-			node = node->next;		
-		}
-		
-		//just add range
-		node = cliphead;
-		prevNode = NULL;
-		temp = NewRange(start, end);
-		
-		while (node != NULL && node->start < end)
-		{
-			prevNode = node;
-			node = node->next;
-		}
-		
-		temp->next = node;
-		if (node == NULL)
-		{
-			temp->prev = prevNode;
-			if (prevNode) prevNode->next = temp;
-			if (!cliphead) cliphead = temp;
-		}
-		else
+		if (range.start > start) range.start = start;
+		if (range.end < end) range.end = end;
+
+		// Swallow all following ranges that now overlap as well.
+		unsigned j = i + 1;
+		while (j < ranges.Size() && ranges[j].start <= range.end)
 		{
-			if (node == cliphead)
-			{
-				cliphead->prev = temp;
-				cliphead = temp;
-			}
-			else
-			{
-				temp->prev = prevNode;
-				prevNode->next = temp;
-				node->prev = temp;
-			}
+			if (ranges[j].end > range.end) range.end = ranges[j].end;
+			j++;
 		}
+		if (j > i + 1) ranges.Delete(i + 1, j - i - 1);
 	}
 	else
 	{
-		temp = NewRange(start, end);
-		cliphead = temp;
-		return;
+		ranges.Insert(i, { start, end });
 	}
+	MarkTouched(start, end);
 }
 
 
@@ -259,26 +205,24 @@ void Clipper::AddClipRange(angle_t start, angle_t end)
 
 void Clipper::RemoveClipRange(angle_t start, angle_t end)
 {
-	ClipNode *node;
-
-	if (silhouette)
+	if (silhouette.Size() > 0)
 	{
-		node = silhouette;
-		while (node != NULL && node->end <= start)
+		unsigned i = 0;
+		while (i < silhouette.Size() && silhouette[i].end <= start)
 		{
-			node = node->next;
+			i++;
 		}
-		if (node != NULL && node->start <= start)
+		if (i < silhouette.Size() && silhouette[i].start <= start)
 		{
-			if (node->end >= end) return;
-			start = node->end;
-			node = node->next;
+			if (silhouette[i].end >= end) return;
+			start = silhouette[i].end;
+			i++;
 		}
-		while (node != NULL && node->start < end)
+		while (i < silhouette.Size() && silhouette[i].start < end)
 		{
-			DoRemoveClipRange(start, node->start);
-			start = node->end;
-			node = node->next;
+			DoRemoveClipRange(start, silhouette[i].start);
+			start = silhouette[i].end;
+			i++;
 		}
 		if (start >= end) return;
 	}
@@ -293,50 +237,35 @@ void Clipper::RemoveClipRange(angle_t start, angle_t end)
 
 void Clipper::DoRemoveClipRange(angle_t start, angle_t end)
 {
-	ClipNode *node, *temp;
+	unsigned i = FindRange(start);
 
-	if (cliphead)
+	while (i < ranges.Size() && ranges[i].start <= end)
 	{
-		//check to see if range contains any old ranges
-		node = cliphead;
-		while (node != NULL && node->start < end)
+		auto &range = ranges[i];
+		if (range.start >= start && range.end <= end)
+		{
+			// completely inside the removed range
+			ranges.Delete(i);
+		}
+		else if (range.start >= start)
 		{
-			if (node->start >= start && node->end <= end)
-			{
-				temp = node;
-				node = node->next;
-				RemoveRange(temp);
-			}
-			else
-			{
-				node = node->next;
-			}
+			// overlaps the end of the removed range
+			range.start = end;
+			break;
 		}
-		
-		//check to see if range overlaps a range (or possibly 2)
-		node = cliphead;
-		while (node != NULL)
+		else if (range.end <= end)
+		{
+			// overlaps the start of the removed range
+			range.end = start;
+			i++;
+		}
+		else
 		{
-			if (node->start >= start && node->start <= end)
-			{
-				node->start = end;
-				break;
-			}
-			else if (node->end >= start && node->end <= end)
-			{
-				node->end=start;
-			}
-			else if (node->start < start && node->end > end)
-			{
-				temp = NewRange(end, node->end);
-				node->end=start;
-				temp->next=node->next;
-				temp->prev=node;
-				node->next=temp;
-				if (temp->next) temp->next->prev=temp;
-				break;
-			}
-			node = node->next;
+			// contains the removed range, so it must be split
+			ClipRange tail = { end, range.end };
+			range.end = start;
+			ranges.Insert(i + 1, tail);
+			break;
 		}
 	}
 }
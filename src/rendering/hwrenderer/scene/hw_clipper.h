@@ -4,37 +4,46 @@
 #include "doomtype.h"
 #include "xs_Float.h"
 #include "r_utility.h"
-#include "memarena.h"
+#include "tarray.h"
 
-class ClipNode
+struct ClipRange
 {
-	friend class Clipper;
-	
-	ClipNode *prev, *next;
 	angle_t start, end;
-
-	bool operator== (const ClipNode &other)
-	{
-		return other.start == start && other.end == end;
-	}
 };
 
 
+//-----------------------------------------------------------------------------
+//
+// The occluded pseudo-angle ranges are kept as a sorted array of disjoint
+// intervals so that lookups are a binary search instead of a list walk.
+// On top of that a coarse bitmask records which parts of the circle have
+// ever been touched by a range since the last Clear. A query that hits an
+// untouched bucket is visible without looking at the ranges at all.
+// Bits are never cleared by RemoveClipRange, so the mask only ever errs
+// on the side of doing the exact check.
+//
+//-----------------------------------------------------------------------------
+
 class Clipper
 {
-	static unsigned starttime;
-	FMemArena nodearena;
-	ClipNode * freelist = nullptr;
+	enum
+	{
+		BUCKET_SHIFT = 20,		// 4096 buckets over the full pseudo-angle range
+		NUM_WORDS = (1u << (32 - BUCKET_SHIFT)) / 64,
+	};
 
-	ClipNode * clipnodes = nullptr;
-	ClipNode * cliphead = nullptr;
-	ClipNode * silhouette = nullptr;	// will be preserved even when RemoveClipRange is called
+	static unsigned starttime;
+	TArray<ClipRange> ranges;
+	TArray<ClipRange> silhouette;	// will be preserved even when RemoveClipRange is called
+	uint64_t touched[NUM_WORDS];
     const FRenderViewpoint *viewpoint = nullptr;
 	bool blocked = false;
 
 	static angle_t AngleToPseudo(angle_t ang);
+	unsigned FindRange(angle_t start) const;
+	void MarkTouched(angle_t startangle, angle_t endangle);
+	bool AllTouched(angle_t startangle, angle_t endangle) const;
 	bool IsRangeVisible(angle_t startangle, angle_t endangle);
-	void RemoveRange(ClipNode * cn);
 	void AddClipRange(angle_t startangle, angle_t endangle);
 	void RemoveClipRange(angle_t startangle, angle_t endangle);
 	void DoRemoveClipRange(angle_t start, angle_t end);
@@ -45,33 +54,6 @@ public:
 
 	void Clear();
 
-	void Free(ClipNode *node)
-	{
-		node->next = freelist;
-		freelist = node;
-	}
-
-	ClipNode * GetNew()
-	{
-		if (freelist)
-		{
-			ClipNode * p = freelist;
-			freelist = p->next;
-			return p;
-		}
-		else return (ClipNode*)nodearena.Alloc(sizeof(ClipNode));
-	}
-
-	ClipNode * NewRange(angle_t start, angle_t end)
-	{
-		ClipNode * c = GetNew();
-
-		c->start = start;
-		c->end = end;
-		c->next = c->prev = NULL;
-		return c;
-	}
-    
     void SetViewpoint(const FRenderViewpoint &vp)
     {
         viewpoint = &vp;
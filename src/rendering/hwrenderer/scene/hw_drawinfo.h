@@ -10,6 +10,11 @@
 #include "hw_weapon.h"
 #include "hw_drawlist.h"
 
+enum
+{
+	MAX_RENDER_WORKERS = 16
+};
+
 enum EDrawMode
 {
 	DM_MAINVIEW,
@@ -36,6 +41,12 @@ class FFlatVertexBuffer;
 class IRenderQueue;
 class HWScenePortalBase;
 class FRenderState;
+struct HWWallDispatcher;
+struct RenderJob;
+
+// Render workers keep their own counts which get added to the stats after the scene has been processed.
+void CountRenderedFlat();
+void CountRenderedSprite();
 
 //==========================================================================
 //
@@ -180,7 +191,7 @@ struct HWDrawInfo
 	BitArray CurrentMapSections;	// this cannot be a single number, because a group of portals with the same displacement may link different sections.
 	area_t	in_area;
 	fixed_t viewx, viewy;	// since the nodes are still fixed point, keeping the view position  also fixed point for node traversal is faster.
-	bool multithread;
+	int multithread;	// number of BSP worker threads, 0 if everything is done on the main thread.
 
 private:
     // For ProcessLowerMiniseg
@@ -191,7 +202,10 @@ private:
 	subsector_t *currentsubsector;	// used by the line processing code.
 	sector_t *currentsector;
 
-	void WorkerThread();
+	void WorkerThread(int workerindex);
+	void ProcessRenderJob(RenderJob *job, HWWallDispatcher &disp, bool timed);
+	void MergeRenderJobs(int numjobs);
+	void *NewDrawItem(int list, HWDrawItemType type, size_t size);
 
 	void UnclipSubsector(subsector_t *sub);
 	
@@ -232,6 +246,11 @@ public:
 		VPUniforms.mClipHeight = 0;
 	}
 
+	// These are needed to keep the output of multiple BSP worker threads deterministic.
+	// Both return false if the caller is not such a worker and should proceed as normal.
+	bool DeferToMerge(std::function<void()> &&action);
+	bool DeferThingCheck(AActor *thing);
+
 	HWPortal * FindPortal(const void * src);
 	void RenderBSPNode(void *node);
 	void RenderBSP(void *node, bool drawpsprites);
@@ -44,6 +44,7 @@ FMemArena RenderDataAllocator(1024*1024);	// Use large blocks to reduce allocati
 void ResetRenderDataAllocator()
 {
 	RenderDataAllocator.FreeAll();
+	ResetRenderWorkerAllocators();
 }
 
 //==========================================================================
@@ -792,6 +793,30 @@ HWSprite *HWDrawList::NewSprite()
 	return sprite;
 }
 
+//==========================================================================
+//
+// Links an item that was already allocated elsewhere, i.e. by one of
+// the BSP worker threads, into the list.
+//
+//==========================================================================
+void HWDrawList::AddItem(HWDrawItemType type, void *item)
+{
+	switch (type)
+	{
+	case DrawType_WALL:
+		drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push((HWWall*)item)));
+		break;
+
+	case DrawType_FLAT:
+		drawitems.Push(HWDrawItem(DrawType_FLAT, flats.Push((HWFlat*)item)));
+		break;
+
+	case DrawType_SPRITE:
+		drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push((HWSprite*)item)));
+		break;
+	}
+}
+
 //==========================================================================
 //
 //
@@ -4,6 +4,7 @@
 
 extern FMemArena RenderDataAllocator;
 void ResetRenderDataAllocator();
+void ResetRenderWorkerAllocators();
 struct HWDrawInfo;
 class HWWall;
 class HWFlat;
@@ -91,6 +92,7 @@ public:
 	HWWall *NewWall();
 	HWFlat *NewFlat();
 	HWSprite *NewSprite();
+	void AddItem(HWDrawItemType type, void *item);
 	void Reset();
 	void SortWalls();
 	void SortFlats();
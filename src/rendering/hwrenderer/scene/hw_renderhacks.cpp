@@ -196,6 +196,7 @@ void HWDrawInfo::AddOtherCeilingPlane(int sector, gl_subsectorrendernode * node)
 void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float Backheight)
 {
 	if (!side->segs[0]->backsector) return;
+	if (DeferToMerge([=]() { AddUpperMissingTexture(side, sub, Backheight); })) return;
 
 	for (int i = 0; i < side->numsegs; i++)
 	{
@@ -249,6 +250,7 @@ void HWDrawInfo::AddLowerMissingTexture(side_t * side, subsector_t *sub, float B
 {
 	sector_t *backsec = side->segs[0]->backsector;
 	if (!backsec) return;
+	if (DeferToMerge([=]() { AddLowerMissingTexture(side, sub, Backheight); })) return;
 	if (backsec->transdoor)
 	{
 		// Transparent door hacks alter the backsector's floor height so we should not
@@ -553,7 +553,10 @@ void HWWall::PutWall(HWWallDispatcher *di, bool translucent)
 					SetupLights(ddi, lightdata);
 				}
 			}
-			ProcessDecals(ddi);
+			if (!ddi->DeferToMerge([wall = *this, ddi]() mutable { wall.ProcessDecals(ddi); }))
+			{
+				ProcessDecals(ddi);
+			}
 		}
 	}
 
@@ -580,6 +583,24 @@ void HWWall::PutPortal(HWWallDispatcher *di, int ptype, int plane)
 	auto ddi = di->di;
 	if (ddi)
 	{
+		// Portals are shared by the entire scene, so a BSP worker thread may not set them up itself.
+		// The sky and horizon info may live on the caller's stack so they must be copied along with the wall.
+		HWSkyInfo skycopy = {};
+		HWHorizonInfo horizoncopy = {};
+		if (ptype == PORTALTYPE_SKY) skycopy = *sky;
+		else if (ptype == PORTALTYPE_HORIZON) horizoncopy = *horizon;
+
+		if (ddi->DeferToMerge([wall = *this, ddi, ptype, plane, skycopy, horizoncopy]() mutable
+			{
+				if (ptype == PORTALTYPE_SKY) wall.sky = &skycopy;
+				else if (ptype == PORTALTYPE_HORIZON) wall.horizon = &horizoncopy;
+				HWWallDispatcher disp(ddi);
+				wall.PutPortal(&disp, ptype, plane);
+			}))
+		{
+			return;
+		}
+
 		MakeVertices(false);
 		switch (ptype)
 		{
@@ -59,6 +59,9 @@
 #include "r_draw_sprite32_sse2.h"
 #include "r_draw_span32_sse2.h"
 #include "r_draw_sky32_sse2.h"
+#include "r_draw_wall32_avx2.h"
+#include "r_draw_span32_avx2.h"
+#include "x86.h"
 #endif
 
 #include "gi.h"
@@ -78,36 +81,74 @@ CVAR(Bool, r_mipmap, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 // Level of detail texture bias
 CVAR(Float, r_lod_bias, -1.5, 0); // To do: add CVAR_ARCHIVE | CVAR_GLOBALCONFIG when a good default has been decided
 
+// Use the AVX2 wall and span drawers when the CPU supports them
+CVAR(Bool, r_avx2drawers, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+
 namespace swrenderer
 {
+#ifndef NO_SSE
+	static bool CheckAVX2Support()
+	{
+		if (!CPU.bAVX || !CPU.bAVX2 || !CPU.bOSXSAVE)
+			return false;
+
+		// The OS must also preserve the upper halves of the YMM registers
+#ifdef _MSC_VER
+		uint64_t xcr0 = _xgetbv(0);
+#else
+		uint32_t xcr0lo, xcr0hi;
+		__asm__ __volatile__("xgetbv" : "=a" (xcr0lo), "=d" (xcr0hi) : "c" (0));
+		uint64_t xcr0 = ((uint64_t)xcr0hi << 32) | xcr0lo;
+#endif
+		return (xcr0 & 6) == 6;
+	}
+
+	static bool UseAVX2()
+	{
+		static const bool supported = CheckAVX2Support();
+		return supported && r_avx2drawers;
+	}
+
+	#define DRAWER_AVX2(avx2command, command, func, args) \
+		if (UseAVX2()) func<avx2command>(args); else func<command>(args)
+#else
+	#define DRAWER_AVX2(avx2command, command, func, args) func<command>(args)
+#endif
+
+	template<typename DrawerT>
+	static void DrawSpanColumn(const SpanDrawerArgs &args)
+	{
+		DrawerT::DrawColumn(args);
+	}
+
 	void SWTruecolorDrawers::DrawWall(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWall32Command>(args);
+		DRAWER_AVX2(DrawWall32AVX2Command, DrawWall32Command, DrawWallColumns, args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallMasked(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallMasked32Command>(args);
+		DRAWER_AVX2(DrawWallMasked32AVX2Command, DrawWallMasked32Command, DrawWallColumns, args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallAdd(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallAddClamp32Command>(args);
+		DRAWER_AVX2(DrawWallAddClamp32AVX2Command, DrawWallAddClamp32Command, DrawWallColumns, args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallAddClamp(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallAddClamp32Command>(args);
+		DRAWER_AVX2(DrawWallAddClamp32AVX2Command, DrawWallAddClamp32Command, DrawWallColumns, args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallSubClamp(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallSubClamp32Command>(args);
+		DRAWER_AVX2(DrawWallSubClamp32AVX2Command, DrawWallSubClamp32Command, DrawWallColumns, args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallRevSubClamp(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallRevSubClamp32Command>(args);
+		DRAWER_AVX2(DrawWallRevSubClamp32AVX2Command, DrawWallRevSubClamp32Command, DrawWallColumns, args);
 	}
 	
 	void SWTruecolorDrawers::DrawColumn(const SpriteDrawerArgs &args)
@@ -206,32 +247,32 @@ namespace swrenderer
 
 	void SWTruecolorDrawers::DrawSpan(const SpanDrawerArgs &args)
 	{
-		DrawSpan32Command::DrawColumn(args);
+		DRAWER_AVX2(DrawSpan32AVX2Command, DrawSpan32Command, DrawSpanColumn, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMasked(const SpanDrawerArgs &args)
 	{
-		DrawSpanMasked32Command::DrawColumn(args);
+		DRAWER_AVX2(DrawSpanMasked32AVX2Command, DrawSpanMasked32Command, DrawSpanColumn, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanTranslucent(const SpanDrawerArgs &args)
 	{
-		DrawSpanTranslucent32Command::DrawColumn(args);
+		DRAWER_AVX2(DrawSpanTranslucent32AVX2Command, DrawSpanTranslucent32Command, DrawSpanColumn, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMaskedTranslucent(const SpanDrawerArgs &args)
 	{
-		DrawSpanAddClamp32Command::DrawColumn(args);
+		DRAWER_AVX2(DrawSpanAddClamp32AVX2Command, DrawSpanAddClamp32Command, DrawSpanColumn, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanAddClamp(const SpanDrawerArgs &args)
 	{
-		DrawSpanTranslucent32Command::DrawColumn(args);
+		DRAWER_AVX2(DrawSpanTranslucent32AVX2Command, DrawSpanTranslucent32Command, DrawSpanColumn, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMaskedAddClamp(const SpanDrawerArgs &args)
 	{
-		DrawSpanAddClamp32Command::DrawColumn(args);
+		DRAWER_AVX2(DrawSpanAddClamp32AVX2Command, DrawSpanAddClamp32Command, DrawSpanColumn, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSingleSkyColumn(const SkyDrawerArgs &args)
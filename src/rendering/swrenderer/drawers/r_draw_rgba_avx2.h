@@ -0,0 +1,225 @@
+/*
+**  AVX2 helpers for the true color drawers
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#pragma once
+
+#include "swrenderer/drawers/r_draw_rgba.h"
+
+// The AVX2 drawers are compiled into the same translation unit as the SSE2 ones and are only
+// called when the CPU and OS support them. Instead of building the file with -mavx2 (which
+// would let the compiler use AVX2 in everything else included by it) each function opts in.
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+namespace swrenderer
+{
+	// Four pixels are kept in a __m256i as 16 bit BGRA channels. Pixels 0 and 1 live in
+	// the low 128 bit lane and pixels 2 and 3 in the high lane, which keeps the per-lane
+	// pack and unpack instructions behaving exactly like their SSE2 counterparts.
+	class DrawerAVX2
+	{
+	public:
+		// Expand four packed BGRA8 pixels to 16 bit channels
+		AVX2_TARGET FORCEINLINE static __m256i Unpack(__m128i pixels)
+		{
+			return _mm256_cvtepu8_epi16(pixels);
+		}
+
+		// Saturate 16 bit channels back to four packed BGRA8 pixels
+		AVX2_TARGET FORCEINLINE static __m128i Pack(__m256i color)
+		{
+			__m256i packed = _mm256_packus_epi16(color, _mm256_setzero_si256());
+			packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+			return _mm256_castsi256_si128(packed);
+		}
+
+		// Replicate the low 16 bits of each 32 bit value to all four channels of its pixel
+		AVX2_TARGET FORCEINLINE static __m256i Spread(__m128i values)
+		{
+			__m256i mask = _mm256_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 8, 9, 8, 9, 8, 9, 8, 9, 0, 1, 0, 1, 0, 1, 0, 1, 8, 9, 8, 9, 8, 9, 8, 9);
+			return _mm256_shuffle_epi8(_mm256_cvtepu32_epi64(values), mask);
+		}
+
+		// Same as Spread, but leaves the alpha channel at zero
+		AVX2_TARGET FORCEINLINE static __m256i SpreadRGB(__m128i values)
+		{
+			__m256i mask = _mm256_setr_epi8(0, 1, 0, 1, 0, 1, -1, -1, 8, 9, 8, 9, 8, 9, -1, -1, 0, 1, 0, 1, 0, 1, -1, -1, 8, 9, 8, 9, 8, 9, -1, -1);
+			return _mm256_shuffle_epi8(_mm256_cvtepu32_epi64(values), mask);
+		}
+
+		// Gather four texels
+		AVX2_TARGET FORCEINLINE static __m128i Gather(const uint32_t *source, __m128i index)
+		{
+			return _mm_i32gather_epi32((const int*)source, index, 4);
+		}
+
+		// Bilinear filter with 4 bit weights: (p00 * a * b + p01 * inv_a * b + p10 * a * inv_b + p11 * inv_a * inv_b + 127) >> 8
+		AVX2_TARGET FORCEINLINE static __m128i Filter(__m128i p00, __m128i p01, __m128i p10, __m128i p11, __m128i inv_a, __m128i inv_b)
+		{
+			__m128i m16 = _mm_set1_epi32(16);
+			__m128i a = _mm_sub_epi32(m16, inv_a);
+			__m128i b = _mm_sub_epi32(m16, inv_b);
+
+			// The weights add up to 256, so the sums never exceed 16 bits
+			__m256i color = _mm256_mullo_epi16(Unpack(p00), Spread(_mm_mullo_epi32(a, b)));
+			color = _mm256_add_epi16(color, _mm256_mullo_epi16(Unpack(p01), Spread(_mm_mullo_epi32(inv_a, b))));
+			color = _mm256_add_epi16(color, _mm256_mullo_epi16(Unpack(p10), Spread(_mm_mullo_epi32(a, inv_b))));
+			color = _mm256_add_epi16(color, _mm256_mullo_epi16(Unpack(p11), Spread(_mm_mullo_epi32(inv_a, inv_b))));
+			color = _mm256_srli_epi16(_mm256_add_epi16(color, _mm256_set1_epi16(127)), 8);
+			return Pack(color);
+		}
+
+		// ((red * 77 + green * 143 + blue * 37) >> 8) * desaturate for each pixel, in the RGB channels
+		AVX2_TARGET FORCEINLINE static __m256i Intensity(__m128i pixels, int desaturate)
+		{
+			__m128i mask = _mm_set1_epi32(0xff);
+			__m128i blue = _mm_and_si128(pixels, mask);
+			__m128i green = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+			__m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), mask);
+			__m128i intensity = _mm_mullo_epi32(red, _mm_set1_epi32(77));
+			intensity = _mm_add_epi32(intensity, _mm_mullo_epi32(green, _mm_set1_epi32(143)));
+			intensity = _mm_add_epi32(intensity, _mm_mullo_epi32(blue, _mm_set1_epi32(37)));
+			intensity = _mm_mullo_epi32(_mm_srli_epi32(intensity, 8), _mm_set1_epi32(desaturate));
+			return SpreadRGB(intensity);
+		}
+
+		AVX2_TARGET FORCEINLINE static __m256i Shade(__m256i fgcolor, __m128i pixels, bool simple, __m256i mlight, int desaturate, __m256i inv_desaturate, __m256i shade_fade, __m256i shade_light)
+		{
+			if (simple)
+			{
+				return _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, mlight), 8);
+			}
+			else
+			{
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(fgcolor, inv_desaturate), Intensity(pixels, desaturate)), 8);
+				fgcolor = _mm256_mullo_epi16(fgcolor, mlight);
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(shade_fade, fgcolor), 8);
+				return _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, shade_light), 8);
+			}
+		}
+
+		// Dynamic lights. Lxy2 is the squared distance in the plane the drawer is not stepping in,
+		// Lnormal the component used for the diffuse term and Lpos the position along the step axis.
+		AVX2_TARGET FORCEINLINE static __m256i AddLight(__m256i lit, float Lxy2, float Lnormal, float Lpos, float radius, uint32_t color, __m128 viewpos)
+		{
+			__m128 light_xy2 = _mm_set1_ps(Lxy2);
+			__m128 light_normal = _mm_set1_ps(Lnormal);
+			__m128 light_pos = _mm_set1_ps(Lpos);
+			__m128 light_radius = _mm_set1_ps(radius);
+			__m128 m256 = _mm_set1_ps(256.0f);
+
+			// L = light-pos
+			// dist = sqrt(dot(L, L))
+			// distance_attenuation = 1 - min(dist * (1/radius), 1)
+			__m128 L = _mm_sub_ps(light_pos, viewpos);
+			__m128 dist2 = _mm_add_ps(light_xy2, _mm_mul_ps(L, L));
+			__m128 rcp_dist = _mm_rsqrt_ps(dist2);
+			__m128 dist = _mm_mul_ps(dist2, rcp_dist);
+			__m128 distance_attenuation = _mm_sub_ps(m256, _mm_min_ps(_mm_mul_ps(dist, light_radius), m256));
+
+			// The simple light type
+			__m128 simple_attenuation = distance_attenuation;
+
+			// The point light type
+			// diffuse = dot(N,L) * attenuation
+			__m128 point_attenuation = _mm_mul_ps(_mm_mul_ps(light_normal, rcp_dist), distance_attenuation);
+
+			__m128 is_attenuated = _mm_cmpeq_ps(light_normal, _mm_setzero_ps());
+			__m128i attenuation = _mm_cvtps_epi32(_mm_blendv_ps(point_attenuation, simple_attenuation, is_attenuated));
+			attenuation = _mm_cvtepi16_epi32(_mm_packs_epi32(attenuation, attenuation));
+
+			__m256i light_color = _mm256_broadcastq_epi64(_mm_cvtepu8_epi16(_mm_cvtsi32_si128(color)));
+			return _mm256_add_epi16(lit, _mm256_srli_epi16(_mm256_mullo_epi16(light_color, Spread(attenuation)), 8));
+		}
+
+		AVX2_TARGET FORCEINLINE static __m256i ApplyLights(__m256i material, __m256i fgcolor, __m256i lit)
+		{
+			lit = _mm256_min_epi16(lit, _mm256_set1_epi16(256));
+			fgcolor = _mm256_add_epi16(fgcolor, _mm256_srli_epi16(_mm256_mullo_epi16(material, lit), 8));
+			return _mm256_min_epi16(fgcolor, _mm256_set1_epi16(255));
+		}
+
+		AVX2_TARGET FORCEINLINE static __m128i BlendOpaque(__m256i fgcolor)
+		{
+			return _mm_or_si128(Pack(fgcolor), _mm_set1_epi32(0xff000000));
+		}
+
+		AVX2_TARGET FORCEINLINE static __m128i BlendMasked(__m256i fgcolor, __m256i bgcolor)
+		{
+			__m256i mask = _mm256_cvtepi8_epi16(_mm_cmpeq_epi32(Pack(fgcolor), _mm_setzero_si128()));
+			__m256i outcolor = _mm256_blendv_epi8(fgcolor, bgcolor, mask);
+			return _mm_or_si128(Pack(outcolor), _mm_set1_epi32(0xff000000));
+		}
+
+		// Op is 0 for add, 1 for subtract and 2 for reverse subtract
+		AVX2_TARGET FORCEINLINE static __m128i BlendAlpha(__m256i fgcolor, __m256i bgcolor, __m256i fgalpha, __m256i bgalpha, int op)
+		{
+			fgcolor = _mm256_mullo_epi16(fgcolor, fgalpha);
+			bgcolor = _mm256_mullo_epi16(bgcolor, bgalpha);
+
+			__m256i fg_lo = _mm256_unpacklo_epi16(fgcolor, _mm256_setzero_si256());
+			__m256i bg_lo = _mm256_unpacklo_epi16(bgcolor, _mm256_setzero_si256());
+			__m256i fg_hi = _mm256_unpackhi_epi16(fgcolor, _mm256_setzero_si256());
+			__m256i bg_hi = _mm256_unpackhi_epi16(bgcolor, _mm256_setzero_si256());
+
+			__m256i out_lo, out_hi;
+			if (op == 0)
+			{
+				out_lo = _mm256_add_epi32(fg_lo, bg_lo);
+				out_hi = _mm256_add_epi32(fg_hi, bg_hi);
+			}
+			else if (op == 1)
+			{
+				out_lo = _mm256_sub_epi32(fg_lo, bg_lo);
+				out_hi = _mm256_sub_epi32(fg_hi, bg_hi);
+			}
+			else
+			{
+				out_lo = _mm256_sub_epi32(bg_lo, fg_lo);
+				out_hi = _mm256_sub_epi32(bg_hi, fg_hi);
+			}
+
+			out_lo = _mm256_srai_epi32(out_lo, 8);
+			out_hi = _mm256_srai_epi32(out_hi, 8);
+			__m256i outcolor = _mm256_packs_epi32(out_lo, out_hi);
+			return _mm_or_si128(Pack(outcolor), _mm_set1_epi32(0xff000000));
+		}
+
+		// Blend weights from the texel alpha, as used by the clamped add and subtract modes
+		AVX2_TARGET FORCEINLINE static void TexelAlpha(__m128i pixels, uint32_t srcalpha, uint32_t destalpha, __m256i &fgalpha, __m256i &bgalpha)
+		{
+			__m128i alpha = _mm_srli_epi32(pixels, 24);
+			alpha = _mm_add_epi32(alpha, _mm_srli_epi32(alpha, 7)); // 255->256
+			__m128i inv_alpha = _mm_sub_epi32(_mm_set1_epi32(256), alpha);
+
+			__m128i m128 = _mm_set1_epi32(128);
+			__m128i bga = _mm_mullo_epi32(_mm_set1_epi32(destalpha), alpha);
+			bga = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bga, _mm_slli_epi32(inv_alpha, 8)), m128), 8);
+			__m128i fga = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_set1_epi32(srcalpha), alpha), m128), 8);
+
+			fgalpha = Spread(fga);
+			bgalpha = Spread(bga);
+		}
+	};
+}
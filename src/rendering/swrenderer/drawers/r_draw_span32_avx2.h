@@ -0,0 +1,306 @@
+/*
+**  Drawer commands for spans, AVX2 version
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#pragma once
+
+#include "swrenderer/drawers/r_draw_rgba_avx2.h"
+#include "swrenderer/drawers/r_draw_span32_sse2.h"
+
+namespace swrenderer
+{
+	// Same output as DrawSpan32T, four pixels per iteration
+	template<typename BlendT>
+	class DrawSpan32AVX2T
+	{
+	public:
+		typedef typename DrawSpan32T<BlendT>::TextureData TextureData;
+
+		AVX2_TARGET static void DrawColumn(const SpanDrawerArgs& args)
+		{
+			using namespace DrawSpan32TModes;
+
+			TextureData texdata;
+			texdata.width = args.TextureWidth();
+			texdata.height = args.TextureHeight();
+			texdata.xstep = args.TextureUStep();
+			texdata.ystep = args.TextureVStep();
+			texdata.xfrac = args.TextureUPos();
+			texdata.yfrac = args.TextureVPos();
+
+			texdata.source = (const uint32_t*)args.TexturePixels();
+
+			double lod = args.TextureLOD();
+			bool mipmapped = args.MipmappedTexture();
+
+			bool magnifying = lod < 0.0;
+			if (r_mipmap && mipmapped)
+			{
+				int level = (int)lod;
+				while (level > 0)
+				{
+					if (texdata.width <= 2 || texdata.height <= 2)
+						break;
+
+					texdata.source += texdata.width * texdata.height;
+					texdata.width = max<uint32_t>(texdata.width / 2, 1);
+					texdata.height = max<uint32_t>(texdata.height / 2, 1);
+					level--;
+				}
+			}
+
+			texdata.xone = (0x80000000u / texdata.width) << 1;
+			texdata.yone = (0x80000000u / texdata.height) << 1;
+
+			bool is_nearest_filter = (magnifying && !r_magfilter) || (!magnifying && !r_minfilter);
+			bool is_64x64 = texdata.width == 64 && texdata.height == 64;
+
+			auto shade_constants = args.ColormapConstants();
+			if (shade_constants.simple_shade)
+			{
+				if (is_nearest_filter)
+				{
+					if (is_64x64)
+						Loop<SimpleShade, NearestFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<SimpleShade, NearestFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+				else
+				{
+					if (is_64x64)
+						Loop<SimpleShade, LinearFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<SimpleShade, LinearFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+			}
+			else
+			{
+				if (is_nearest_filter)
+				{
+					if (is_64x64)
+						Loop<AdvancedShade, NearestFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<AdvancedShade, NearestFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+				else
+				{
+					if (is_64x64)
+						Loop<AdvancedShade, LinearFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<AdvancedShade, LinearFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+			}
+		}
+
+		template<typename ShadeModeT, typename FilterModeT, typename TextureSizeT>
+		AVX2_TARGET FORCEINLINE static void Loop(const SpanDrawerArgs& args, TextureData texdata, ShadeConstants shade_constants)
+		{
+			using namespace DrawSpan32TModes;
+
+			// Shade constants
+			int light = 256 - (args.Light() >> (FRACBITS - 8));
+			__m256i mlight = _mm256_broadcastsi128_si256(_mm_set_epi16(256, light, light, light, 256, light, light, light));
+			__m256i inv_light = _mm256_broadcastsi128_si256(_mm_set_epi16(0, 256 - light, 256 - light, 256 - light, 0, 256 - light, 256 - light, 256 - light));
+
+			__m256i inv_desaturate, shade_fade, shade_light;
+			int desaturate;
+			if (ShadeModeT::Mode == (int)ShadeMode::Advanced)
+			{
+				inv_desaturate = _mm256_broadcastsi128_si256(_mm_setr_epi16(256, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate, 256, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate));
+				shade_fade = _mm256_broadcastsi128_si256(_mm_set_epi16(shade_constants.fade_alpha, shade_constants.fade_red, shade_constants.fade_green, shade_constants.fade_blue, shade_constants.fade_alpha, shade_constants.fade_red, shade_constants.fade_green, shade_constants.fade_blue));
+				shade_fade = _mm256_mullo_epi16(shade_fade, inv_light);
+				shade_light = _mm256_broadcastsi128_si256(_mm_set_epi16(shade_constants.light_alpha, shade_constants.light_red, shade_constants.light_green, shade_constants.light_blue, shade_constants.light_alpha, shade_constants.light_red, shade_constants.light_green, shade_constants.light_blue));
+				desaturate = shade_constants.desaturate;
+			}
+			else
+			{
+				inv_desaturate = _mm256_setzero_si256();
+				shade_fade = _mm256_setzero_si256();
+				shade_light = _mm256_setzero_si256();
+				desaturate = 0;
+			}
+
+			auto lights = args.dc_lights;
+			auto num_lights = args.dc_num_lights;
+			float vpx = args.dc_viewpos.X;
+			float stepvpx = args.dc_viewpos_step.X;
+			__m128 viewpos_x = _mm_setr_ps(vpx, vpx + stepvpx, vpx + stepvpx * 2.0f, vpx + stepvpx * 3.0f);
+			__m128 step_viewpos_x = _mm_set1_ps(stepvpx * 4.0f);
+
+			int count = args.DestX2() - args.DestX1() + 1;
+			uint32_t *dest = (uint32_t*)args.Viewport()->GetDest(args.DestX1(), args.DestY());
+
+			if (FilterModeT::Mode == (int)FilterModes::Linear)
+			{
+				texdata.xfrac -= texdata.xone / 2;
+				texdata.yfrac -= texdata.yone / 2;
+			}
+
+			__m128i steps = _mm_setr_epi32(0, 1, 2, 3);
+			__m128i xfrac = _mm_add_epi32(_mm_set1_epi32(texdata.xfrac), _mm_mullo_epi32(_mm_set1_epi32(texdata.xstep), steps));
+			__m128i yfrac = _mm_add_epi32(_mm_set1_epi32(texdata.yfrac), _mm_mullo_epi32(_mm_set1_epi32(texdata.ystep), steps));
+			__m128i xstep = _mm_set1_epi32(texdata.xstep * 4);
+			__m128i ystep = _mm_set1_epi32(texdata.ystep * 4);
+			__m128i width = _mm_set1_epi32(texdata.width);
+			__m128i height = _mm_set1_epi32(texdata.height);
+			__m128i xone = _mm_set1_epi32(texdata.xone);
+			__m128i yone = _mm_set1_epi32(texdata.yone);
+
+			uint32_t srcalpha = args.SrcAlpha() >> (FRACBITS - 8);
+			uint32_t destalpha = args.DestAlpha() >> (FRACBITS - 8);
+
+			__m256i fgalpha, bgalpha;
+			if (BlendT::Mode == (int)SpanBlendModes::Translucent)
+			{
+				fgalpha = _mm256_set1_epi16(srcalpha);
+				bgalpha = _mm256_set1_epi16(destalpha);
+			}
+
+			for (int offset = 0; offset < count; offset += 4)
+			{
+				int n = min(count - offset, 4);
+
+				__m128i texels = Sample<FilterModeT, TextureSizeT>(xfrac, yfrac, width, height, xone, yone, texdata.source);
+				xfrac = _mm_add_epi32(xfrac, xstep);
+				yfrac = _mm_add_epi32(yfrac, ystep);
+
+				__m256i fgcolor = DrawerAVX2::Unpack(texels);
+				__m256i material = fgcolor;
+				fgcolor = DrawerAVX2::Shade(fgcolor, texels, ShadeModeT::Mode == (int)ShadeMode::Simple, mlight, desaturate, inv_desaturate, shade_fade, shade_light);
+
+				__m256i lit = _mm256_setzero_si256();
+				for (int i = 0; i != num_lights; i++)
+					lit = DrawerAVX2::AddLight(lit, lights[i].y, lights[i].z, lights[i].x, lights[i].radius, lights[i].color, viewpos_x);
+				fgcolor = DrawerAVX2::ApplyLights(material, fgcolor, lit);
+				viewpos_x = _mm_add_ps(viewpos_x, step_viewpos_x);
+
+				uint32_t desttmp[4] = { 0, 0, 0, 0 };
+				__m256i bgcolor = _mm256_setzero_si256();
+				if (BlendT::Mode != (int)SpanBlendModes::Opaque)
+				{
+					if (n == 4)
+					{
+						bgcolor = DrawerAVX2::Unpack(_mm_loadu_si128((const __m128i*)(dest + offset)));
+					}
+					else
+					{
+						for (int i = 0; i < n; i++)
+							desttmp[i] = dest[offset + i];
+						bgcolor = DrawerAVX2::Unpack(_mm_loadu_si128((const __m128i*)desttmp));
+					}
+				}
+
+				__m128i outcolor;
+				if (BlendT::Mode == (int)SpanBlendModes::Opaque)
+				{
+					outcolor = DrawerAVX2::BlendOpaque(fgcolor);
+				}
+				else if (BlendT::Mode == (int)SpanBlendModes::Masked)
+				{
+					outcolor = DrawerAVX2::BlendMasked(fgcolor, bgcolor);
+				}
+				else if (BlendT::Mode == (int)SpanBlendModes::Translucent)
+				{
+					outcolor = DrawerAVX2::BlendAlpha(fgcolor, bgcolor, fgalpha, bgalpha, 0);
+				}
+				else
+				{
+					DrawerAVX2::TexelAlpha(texels, srcalpha, destalpha, fgalpha, bgalpha);
+					int op = BlendT::Mode == (int)SpanBlendModes::AddClamp ? 0 : BlendT::Mode == (int)SpanBlendModes::SubClamp ? 1 : 2;
+					outcolor = DrawerAVX2::BlendAlpha(fgcolor, bgcolor, fgalpha, bgalpha, op);
+				}
+
+				if (n == 4)
+				{
+					_mm_storeu_si128((__m128i*)(dest + offset), outcolor);
+				}
+				else
+				{
+					_mm_storeu_si128((__m128i*)desttmp, outcolor);
+					for (int i = 0; i < n; i++)
+						dest[offset + i] = desttmp[i];
+				}
+			}
+		}
+
+		template<typename FilterModeT, typename TextureSizeT>
+		AVX2_TARGET FORCEINLINE static __m128i Sample(__m128i xfrac, __m128i yfrac, __m128i width, __m128i height, __m128i xone, __m128i yone, const uint32_t *source)
+		{
+			using namespace DrawSpan32TModes;
+
+			if (FilterModeT::Mode == (int)FilterModes::Nearest && TextureSizeT::Mode == (int)SpanTextureSize::Size64x64)
+			{
+				__m128i sample_index = _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(xfrac, 32 - 6 - 6), _mm_set1_epi32(63 * 64)), _mm_srli_epi32(yfrac, 32 - 6));
+				return DrawerAVX2::Gather(source, sample_index);
+			}
+			else if (FilterModeT::Mode == (int)FilterModes::Nearest)
+			{
+				__m128i x = _mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(xfrac, 16), width), 16);
+				__m128i y = _mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(yfrac, 16), height), 16);
+				return DrawerAVX2::Gather(source, _mm_add_epi32(_mm_mullo_epi32(x, height), y));
+			}
+			else
+			{
+				__m128i i00, i01, i10, i11;
+				__m128i frac_x, frac_y;
+				if (TextureSizeT::Mode == (int)SpanTextureSize::Size64x64)
+				{
+					__m128i mask = _mm_set1_epi32(0x3f);
+					frac_x = _mm_slli_epi32(_mm_srli_epi32(xfrac, 16), 6);
+					frac_y = _mm_slli_epi32(_mm_srli_epi32(yfrac, 16), 6);
+					__m128i x0 = _mm_srli_epi32(frac_x, 16);
+					__m128i y0 = _mm_srli_epi32(frac_y, 16);
+					__m128i x1 = _mm_and_si128(_mm_add_epi32(x0, _mm_set1_epi32(1)), mask);
+					__m128i y1 = _mm_and_si128(_mm_add_epi32(y0, _mm_set1_epi32(1)), mask);
+					x0 = _mm_slli_epi32(x0, 6);
+					x1 = _mm_slli_epi32(x1, 6);
+					i00 = _mm_add_epi32(y0, x0);
+					i01 = _mm_add_epi32(y1, x0);
+					i10 = _mm_add_epi32(y0, x1);
+					i11 = _mm_add_epi32(y1, x1);
+				}
+				else
+				{
+					frac_x = _mm_mullo_epi32(_mm_srli_epi32(xfrac, 16), width);
+					frac_y = _mm_mullo_epi32(_mm_srli_epi32(yfrac, 16), height);
+					__m128i x0 = _mm_mullo_epi32(_mm_srli_epi32(frac_x, 16), height);
+					__m128i y0 = _mm_srli_epi32(frac_y, 16);
+					__m128i x1 = _mm_mullo_epi32(_mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(_mm_add_epi32(xfrac, xone), 16), width), 16), height);
+					__m128i y1 = _mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(_mm_add_epi32(yfrac, yone), 16), height), 16);
+					i00 = _mm_add_epi32(y0, x0);
+					i01 = _mm_add_epi32(y1, x0);
+					i10 = _mm_add_epi32(y0, x1);
+					i11 = _mm_add_epi32(y1, x1);
+				}
+
+				__m128i inv_b = _mm_and_si128(_mm_srli_epi32(frac_x, 12), _mm_set1_epi32(15));
+				__m128i inv_a = _mm_and_si128(_mm_srli_epi32(frac_y, 12), _mm_set1_epi32(15));
+				return DrawerAVX2::Filter(DrawerAVX2::Gather(source, i00), DrawerAVX2::Gather(source, i01), DrawerAVX2::Gather(source, i10), DrawerAVX2::Gather(source, i11), inv_a, inv_b);
+			}
+		}
+	};
+
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::OpaqueSpan> DrawSpan32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::MaskedSpan> DrawSpanMasked32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::TranslucentSpan> DrawSpanTranslucent32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::AddClampSpan> DrawSpanAddClamp32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::SubClampSpan> DrawSpanSubClamp32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::RevSubClampSpan> DrawSpanRevSubClamp32AVX2Command;
+}
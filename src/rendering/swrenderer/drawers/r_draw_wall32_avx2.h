@@ -0,0 +1,208 @@
+/*
+**  Drawer commands for walls, AVX2 version
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#pragma once
+
+#include "swrenderer/drawers/r_draw_rgba_avx2.h"
+#include "swrenderer/drawers/r_draw_wall32_sse2.h"
+
+namespace swrenderer
+{
+	// Same output as DrawWall32T, four pixels per iteration
+	template<typename BlendT>
+	class DrawWall32AVX2T
+	{
+	public:
+		AVX2_TARGET static void DrawColumn(const WallColumnDrawerArgs& args)
+		{
+			using namespace DrawWall32TModes;
+
+			bool is_nearest_filter = (args.TexturePixels2() == nullptr);
+			auto shade_constants = args.ColormapConstants();
+			if (shade_constants.simple_shade)
+			{
+				if (is_nearest_filter)
+					Loop<SimpleShade, NearestFilter>(args, shade_constants);
+				else
+					Loop<SimpleShade, LinearFilter>(args, shade_constants);
+			}
+			else
+			{
+				if (is_nearest_filter)
+					Loop<AdvancedShade, NearestFilter>(args, shade_constants);
+				else
+					Loop<AdvancedShade, LinearFilter>(args, shade_constants);
+			}
+		}
+
+		template<typename ShadeModeT, typename FilterModeT>
+		AVX2_TARGET FORCEINLINE static void Loop(const WallColumnDrawerArgs& args, ShadeConstants shade_constants)
+		{
+			using namespace DrawWall32TModes;
+
+			const uint32_t *source = (const uint32_t*)args.TexturePixels();
+			const uint32_t *source2 = (const uint32_t*)args.TexturePixels2();
+			int textureheight = args.TextureHeight();
+			uint32_t one = ((0x80000000 + textureheight - 1) / textureheight) * 2 + 1;
+
+			// Shade constants
+			int light = 256 - (args.Light() >> (FRACBITS - 8));
+			__m256i mlight = _mm256_broadcastsi128_si256(_mm_set_epi16(256, light, light, light, 256, light, light, light));
+			__m256i inv_light = _mm256_broadcastsi128_si256(_mm_set_epi16(0, 256 - light, 256 - light, 256 - light, 0, 256 - light, 256 - light, 256 - light));
+
+			__m256i inv_desaturate, shade_fade, shade_light;
+			int desaturate;
+			if (ShadeModeT::Mode == (int)ShadeMode::Advanced)
+			{
+				inv_desaturate = _mm256_broadcastsi128_si256(_mm_setr_epi16(256, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate, 256, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate, 256 - shade_constants.desaturate));
+				shade_fade = _mm256_broadcastsi128_si256(_mm_set_epi16(shade_constants.fade_alpha, shade_constants.fade_red, shade_constants.fade_green, shade_constants.fade_blue, shade_constants.fade_alpha, shade_constants.fade_red, shade_constants.fade_green, shade_constants.fade_blue));
+				shade_fade = _mm256_mullo_epi16(shade_fade, inv_light);
+				shade_light = _mm256_broadcastsi128_si256(_mm_set_epi16(shade_constants.light_alpha, shade_constants.light_red, shade_constants.light_green, shade_constants.light_blue, shade_constants.light_alpha, shade_constants.light_red, shade_constants.light_green, shade_constants.light_blue));
+				desaturate = shade_constants.desaturate;
+			}
+			else
+			{
+				inv_desaturate = _mm256_setzero_si256();
+				shade_fade = _mm256_setzero_si256();
+				shade_light = _mm256_setzero_si256();
+				desaturate = 0;
+			}
+
+			int count = args.Count();
+			if (count <= 0) return;
+
+			int pitch = args.Viewport()->RenderTarget->GetPitch();
+			uint32_t fracstep = args.TextureVStep();
+			uint32_t frac = args.TextureVPos();
+			uint32_t texturefracx = args.TextureUPos();
+			uint32_t *dest = (uint32_t*)args.Dest();
+
+			auto lights = args.dc_lights;
+			auto num_lights = args.dc_num_lights;
+			float vpz = args.dc_viewpos.Z;
+			float stepvpz = args.dc_viewpos_step.Z;
+			__m128 viewpos_z = _mm_setr_ps(vpz, vpz + stepvpz, vpz + stepvpz * 2.0f, vpz + stepvpz * 3.0f);
+			__m128 step_viewpos_z = _mm_set1_ps(stepvpz * 4.0f);
+
+			if (FilterModeT::Mode == (int)FilterModes::Linear)
+			{
+				frac -= one / 2;
+			}
+
+			__m128i mfrac = _mm_add_epi32(_mm_set1_epi32(frac), _mm_mullo_epi32(_mm_set1_epi32(fracstep), _mm_setr_epi32(0, 1, 2, 3)));
+			__m128i mfracstep = _mm_set1_epi32(fracstep * 4);
+			__m128i mheight = _mm_set1_epi32(textureheight);
+			__m128i mone = _mm_set1_epi32(one);
+			__m128i inv_b = _mm_set1_epi32(texturefracx);
+
+			uint32_t srcalpha = args.SrcAlpha() >> (FRACBITS - 8);
+			uint32_t destalpha = args.DestAlpha() >> (FRACBITS - 8);
+
+			for (int index = 0; index < count; index += 4)
+			{
+				int n = min(count - index, 4);
+				uint32_t *d = dest + index * pitch;
+
+				__m128i texels;
+				if (FilterModeT::Mode == (int)FilterModes::Nearest)
+				{
+					// A hardware gather is slower than four scalar loads for a single column
+					alignas(16) uint32_t sample_index[4];
+					_mm_store_si128((__m128i*)sample_index, _mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(mfrac, FRACBITS), mheight), FRACBITS));
+					texels = _mm_setr_epi32(source[sample_index[0]], source[sample_index[1]], source[sample_index[2]], source[sample_index[3]]);
+				}
+				else
+				{
+					__m128i frac_y0 = _mm_mullo_epi32(_mm_srli_epi32(mfrac, FRACBITS), mheight);
+					__m128i frac_y1 = _mm_mullo_epi32(_mm_srli_epi32(_mm_add_epi32(mfrac, mone), FRACBITS), mheight);
+					__m128i y0 = _mm_srli_epi32(frac_y0, FRACBITS);
+					__m128i y1 = _mm_srli_epi32(frac_y1, FRACBITS);
+					__m128i inv_a = _mm_and_si128(_mm_srli_epi32(frac_y1, FRACBITS - 4), _mm_set1_epi32(15));
+					texels = DrawerAVX2::Filter(DrawerAVX2::Gather(source, y0), DrawerAVX2::Gather(source, y1), DrawerAVX2::Gather(source2, y0), DrawerAVX2::Gather(source2, y1), inv_a, inv_b);
+				}
+				mfrac = _mm_add_epi32(mfrac, mfracstep);
+
+				__m256i fgcolor = DrawerAVX2::Unpack(texels);
+				__m256i material = fgcolor;
+				fgcolor = DrawerAVX2::Shade(fgcolor, texels, ShadeModeT::Mode == (int)ShadeMode::Simple, mlight, desaturate, inv_desaturate, shade_fade, shade_light);
+
+				__m256i lit = _mm256_setzero_si256();
+				for (int i = 0; i != num_lights; i++)
+					lit = DrawerAVX2::AddLight(lit, lights[i].x, lights[i].y, lights[i].z, lights[i].radius, lights[i].color, viewpos_z);
+				fgcolor = DrawerAVX2::ApplyLights(material, fgcolor, lit);
+				viewpos_z = _mm_add_ps(viewpos_z, step_viewpos_z);
+
+				uint32_t desttmp[4] = { 0, 0, 0, 0 };
+				__m256i bgcolor = _mm256_setzero_si256();
+				if (BlendT::Mode != (int)WallBlendModes::Opaque)
+				{
+					if (n == 4)
+					{
+						bgcolor = DrawerAVX2::Unpack(_mm_setr_epi32(d[0], d[pitch], d[pitch * 2], d[pitch * 3]));
+					}
+					else
+					{
+						for (int i = 0; i < n; i++)
+							desttmp[i] = d[i * pitch];
+						bgcolor = DrawerAVX2::Unpack(_mm_loadu_si128((const __m128i*)desttmp));
+					}
+				}
+
+				__m128i outcolor;
+				if (BlendT::Mode == (int)WallBlendModes::Opaque)
+				{
+					outcolor = DrawerAVX2::BlendOpaque(fgcolor);
+				}
+				else if (BlendT::Mode == (int)WallBlendModes::Masked)
+				{
+					outcolor = DrawerAVX2::BlendMasked(fgcolor, bgcolor);
+				}
+				else
+				{
+					__m256i fgalpha, bgalpha;
+					DrawerAVX2::TexelAlpha(texels, srcalpha, destalpha, fgalpha, bgalpha);
+					int op = BlendT::Mode == (int)WallBlendModes::AddClamp ? 0 : BlendT::Mode == (int)WallBlendModes::SubClamp ? 1 : 2;
+					outcolor = DrawerAVX2::BlendAlpha(fgcolor, bgcolor, fgalpha, bgalpha, op);
+				}
+
+				if (n == 4)
+				{
+					d[0] = _mm_cvtsi128_si32(outcolor);
+					d[pitch] = _mm_extract_epi32(outcolor, 1);
+					d[pitch * 2] = _mm_extract_epi32(outcolor, 2);
+					d[pitch * 3] = _mm_extract_epi32(outcolor, 3);
+				}
+				else
+				{
+					_mm_storeu_si128((__m128i*)desttmp, outcolor);
+					for (int i = 0; i < n; i++)
+						d[i * pitch] = desttmp[i];
+				}
+			}
+		}
+	};
+
+	typedef DrawWall32AVX2T<DrawWall32TModes::OpaqueWall> DrawWall32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::MaskedWall> DrawWallMasked32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::AddClampWall> DrawWallAddClamp32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::SubClampWall> DrawWallSubClamp32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::RevSubClampWall> DrawWallRevSubClamp32AVX2Command;
+}
@@ -1,6 +1,7 @@
 #include "textures/r_swtexture.h"
 #include "r_renderthread.cpp"
 #include "r_swrenderer.cpp"
+#include "r_swbench.cpp"
 #include "r_swcolormaps.cpp"
 #include "drawers/r_draw.cpp"
 #include "drawers/r_draw_pal.cpp"
@@ -0,0 +1,371 @@
+/*
+** r_swbench.cpp
+** Offscreen software renderer benchmark
+**
+**---------------------------------------------------------------------------
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The scene is rendered into a memory canvas which never gets presented,
+** so the results neither depend on the video backend nor on vsync. When
+** started with -swbench no video backend gets created at all.
+** Output is written as JSON lines: a header object, one object per frame
+** and, for viewpoint runs, one summary object per viewpoint.
+**
+** Viewpoint files contain one viewpoint per line: x y z yaw pitch,
+** with z being the eye height.
+**
+*/
+
+#include <stdio.h>
+#include <float.h>
+
+#include "c_dispatch.h"
+#include "c_cvars.h"
+#include "m_argv.h"
+#include "sc_man.h"
+#include "stats.h"
+#include "version.h"
+#include "d_main.h"
+#include "doomstat.h"
+#include "g_levellocals.h"
+#include "actor.h"
+#include "v_video.h"
+#include "r_utility.h"
+#include "g_level.h"
+#include "d_event.h"
+#include "r_swrenderer.h"
+#include "swrenderer/scene/r_scene.h"
+
+EXTERN_CVAR(Int, r_scene_multithreaded)
+
+CVAR(Int, swbench_frames, 100, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+struct FSWBenchView
+{
+	DVector3 Pos;
+	double Yaw, Pitch;
+};
+
+static FString BenchViewFile;
+static FString BenchOutput = "swbench.jsonl";
+static FILE *BenchDemoFile;
+static int BenchDemoFrames;
+static bool BenchPending, BenchRecordDemo;
+
+//==========================================================================
+//
+// Map names come from MAPINFO and can contain anything.
+//
+//==========================================================================
+
+static FString JsonString(const char *str)
+{
+	FString out;
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\') out << '\\' << *str;
+		else if ((unsigned char)*str < 32) out.AppendFormat("\\u%04x", (unsigned char)*str);
+		else out << *str;
+	}
+	return out;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static FILE *OpenBenchOutput(DCanvas &canvas, const char *mode)
+{
+	FILE *f = fopen(BenchOutput.GetChars(), "wt");
+	if (f == nullptr)
+	{
+		Printf("Unable to open %s for writing\n", BenchOutput.GetChars());
+		return nullptr;
+	}
+	fprintf(f, "{\"benchmark\":\"swbench\",\"version\":\"%s\",\"map\":\"%s\",\"mode\":\"%s\",\"width\":%d,\"height\":%d,\"truecolor\":%s,\"r_scene_multithreaded\":%d}\n",
+		JsonString(GetVersionString()).GetChars(), JsonString(primaryLevel->MapName.GetChars()).GetChars(), mode, canvas.GetWidth(), canvas.GetHeight(),
+		canvas.IsBgra() ? "true" : "false", *r_scene_multithreaded);
+	return f;
+}
+
+//==========================================================================
+//
+// Renders one frame and writes its timings. The breakdown uses the
+// renderer's own counters, which only cover the main render thread's slice.
+// BSP traversal and wall drawing share WallCycles, and the drawers run
+// inline within each of the passes.
+//
+//==========================================================================
+
+static double RenderBenchFrame(FILE *f, AActor *camera, DCanvas &canvas, int view, int frame)
+{
+	cycle_t frametime;
+
+	frametime.Reset();
+	frametime.Clock();
+	static_cast<FSoftwareRenderer *>(SWRenderer)->RenderOffscreen(camera, &canvas);
+	frametime.Unclock();
+
+	double ms = frametime.TimeMS();
+	fprintf(f, "{\"view\":%d,\"frame\":%d,\"total\":%.4f,\"walls\":%.4f,\"planes\":%.4f,\"masked\":%.4f}\n",
+		view, frame, ms, swrenderer::WallCycles.TimeMS(), swrenderer::PlaneCycles.TimeMS(), swrenderer::MaskedCycles.TimeMS());
+	return ms;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool ReadBenchViews(const char *filename, TArray<FSWBenchView> &views)
+{
+	FScanner sc;
+
+	if (!sc.OpenFile(filename))
+	{
+		Printf("Unable to open viewpoint file %s\n", filename);
+		return false;
+	}
+	while (sc.GetFloat())
+	{
+		FSWBenchView &view = views[views.Reserve(1)];
+		view.Pos.X = sc.Float;
+		sc.MustGetFloat();
+		view.Pos.Y = sc.Float;
+		sc.MustGetFloat();
+		view.Pos.Z = sc.Float;
+		sc.MustGetFloat();
+		view.Yaw = sc.Float;
+		sc.MustGetFloat();
+		view.Pitch = sc.Float;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// The camera is never linked into the level. It is not a thinker and is
+// neither in a sector nor in the blockmap, so the level being measured
+// looks exactly the same as without the benchmark.
+//
+//==========================================================================
+
+static AActor *CreateBenchCamera(FLevelLocals *Level)
+{
+	auto camera = static_cast<AActor *>(RUNTIME_CLASS(AActor)->CreateNew());
+	camera->Level = Level;
+	camera->flags |= MF_NOSECTOR | MF_NOBLOCKMAP;
+	// The camera position is the eye position so it needs no height.
+	camera->CameraHeight = 0;
+	GC::AddSoftRoot(camera);
+	return camera;
+}
+
+static void MoveBenchCamera(AActor *camera, const FSWBenchView &view)
+{
+	camera->SetXYZ(view.Pos);
+	camera->Sector = camera->Level->PointInSector(view.Pos);
+	camera->Angles.Yaw = DAngle::fromDeg(view.Yaw);
+	camera->Angles.Pitch = DAngle::fromDeg(view.Pitch);
+	camera->ClearInterpolation();
+}
+
+static void DestroyBenchCamera(AActor *camera)
+{
+	R_ClearPastViewer(camera);
+	GC::DelSoftRoot(camera);
+	// Without a level the camera's destruction does not get reported to the level's event handlers.
+	camera->Level = nullptr;
+	camera->Destroy();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void RunViewBenchmark(const char *filename)
+{
+	TArray<FSWBenchView> views;
+
+	if (filename == nullptr || *filename == 0)
+	{
+		// Without a file, benchmark the last rendered view.
+		FSWBenchView &view = views[views.Reserve(1)];
+		view.Pos = r_viewpoint.Pos;
+		view.Yaw = r_viewpoint.Angles.Yaw.Degrees();
+		view.Pitch = r_viewpoint.Angles.Pitch.Degrees();
+	}
+	else if (!ReadBenchViews(filename, views))
+	{
+		return;
+	}
+	else if (views.Size() == 0)
+	{
+		Printf("No viewpoints found in %s\n", filename);
+		return;
+	}
+
+	DCanvas canvas(screen->GetWidth(), screen->GetHeight(), V_IsTrueColor());
+	FILE *f = OpenBenchOutput(canvas, "views");
+	if (f == nullptr) return;
+
+	AActor *camera = CreateBenchCamera(primaryLevel);
+
+	// The camera jumps between viewpoints without any tics passing in between.
+	bool savedNoInterpolate = r_NoInterpolate;
+	r_NoInterpolate = true;
+
+	const int frames = max<int>(*swbench_frames, 1);
+	for (unsigned i = 0; i < views.Size(); i++)
+	{
+		MoveBenchCamera(camera, views[i]);
+
+		// The first frame is not timed to get textures loaded and caches warmed up.
+		static_cast<FSoftwareRenderer *>(SWRenderer)->RenderOffscreen(camera, &canvas);
+
+		double total = 0, best = DBL_MAX, worst = 0;
+		for (int j = 0; j < frames; j++)
+		{
+			double ms = RenderBenchFrame(f, camera, canvas, i, j);
+			total += ms;
+			best = min(best, ms);
+			worst = max(worst, ms);
+		}
+		fprintf(f, "{\"view\":%d,\"x\":%g,\"y\":%g,\"z\":%g,\"yaw\":%g,\"pitch\":%g,\"frames\":%d,\"avg\":%.4f,\"min\":%.4f,\"max\":%.4f}\n",
+			i, views[i].Pos.X, views[i].Pos.Y, views[i].Pos.Z, views[i].Yaw, views[i].Pitch, frames, total / frames, best, worst);
+		Printf("View %d: %.3f ms avg, %.3f ms min, %.3f ms max\n", i, total / frames, best, worst);
+	}
+
+	r_NoInterpolate = savedNoInterpolate;
+	DestroyBenchCamera(camera);
+	fclose(f);
+	Printf("Benchmark results written to %s\n", BenchOutput.GetChars());
+}
+
+//==========================================================================
+//
+// Called once per displayed frame.
+//
+//==========================================================================
+
+void CheckSWBench()
+{
+	if (gamestate != GS_LEVEL || SWRenderer == nullptr)
+		return;
+
+	if (BenchPending)
+	{
+		BenchPending = false;
+		RunViewBenchmark(BenchViewFile.GetChars());
+	}
+
+	if (BenchRecordDemo)
+	{
+		if (BenchDemoFile == nullptr && demoplayback)
+		{
+			DCanvas canvas(screen->GetWidth(), screen->GetHeight(), V_IsTrueColor());
+			BenchDemoFile = OpenBenchOutput(canvas, "demo");
+			BenchDemoFrames = 0;
+			if (BenchDemoFile == nullptr) BenchRecordDemo = false;
+		}
+		else if (BenchDemoFile != nullptr && !demoplayback)
+		{
+			fclose(BenchDemoFile);
+			BenchDemoFile = nullptr;
+			BenchRecordDemo = false;
+			Printf("Benchmark results written to %s\n", BenchOutput.GetChars());
+			return;
+		}
+
+		if (BenchDemoFile != nullptr && players[consoleplayer].mo != nullptr)
+		{
+			// Timed demos end with a fatal error, so every frame has to reach the file right away.
+			DCanvas canvas(screen->GetWidth(), screen->GetHeight(), V_IsTrueColor());
+			RenderBenchFrame(BenchDemoFile, players[consoleplayer].mo, canvas, 0, BenchDemoFrames++);
+			fflush(BenchDemoFile);
+		}
+	}
+}
+
+//==========================================================================
+//
+// -swbenchdemo					records every frame of a demo started with -playdemo or -timedemo
+// -swbenchout <file>			output file name
+//
+//==========================================================================
+
+void SWBench_CheckArgs()
+{
+	const char *v = Args->CheckValue("-swbenchout");
+	if (v != nullptr) BenchOutput = v;
+
+	if (Args->CheckParm("-swbenchdemo"))
+	{
+		BenchRecordDemo = true;
+	}
+}
+
+//==========================================================================
+//
+// -swbench <viewpoint file>	benchmarks the viewpoints, then quits
+//
+// This runs during startup, before the game loop. The video backend does
+// not get created for it, so the canvas size is taken from -width and
+// -height or vid_defwidth and vid_defheight. The level is the one given
+// with -warp or +map, otherwise the first one.
+//
+//==========================================================================
+
+void SWBench_Run(const char *viewfile, const char *mapname)
+{
+	extern void G_DoNewGame();
+
+	if (gameaction == ga_newgame) G_DoNewGame();
+	else G_InitNew(mapname, false);
+
+	if (gamestate != GS_LEVEL || SWRenderer == nullptr)
+	{
+		Printf("Unable to load %s\n", mapname);
+		return;
+	}
+	RunViewBenchmark(viewfile);
+}
+
+CCMD(swbench)
+{
+	if (gamestate != GS_LEVEL || netgame)
+	{
+		Printf("swbench can only be used in a single player game\n");
+		return;
+	}
+	BenchViewFile = argv.argc() > 1 ? argv[1] : "";
+	if (argv.argc() > 2) BenchOutput = argv[2];
+	BenchPending = true;
+}
@@ -23,6 +23,9 @@ struct FSoftwareRenderer : public FRenderer
 	void SetClearColor(int color) override;
 	void RenderTextureView (FCanvasTexture *tex, AActor *viewpoint, double fov);
 
+	// renders a view into an offscreen canvas without touching the video output
+	void RenderOffscreen (AActor *camera, DCanvas *canvas);
+
 	void SetColormap(FLevelLocals *Level) override;
 	void Init() override;
 
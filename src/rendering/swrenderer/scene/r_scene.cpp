@@ -63,11 +63,20 @@ EXTERN_CVAR(Int, r_clearbuffer)
 EXTERN_CVAR(Int, r_debug_draw)
 
 CVAR(Int, r_scene_multithreaded, 1, 0);
+CVAR(Bool, r_scene_balance, true, 0);
 CVAR(Bool, r_models, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 
 namespace swrenderer
 {
 	cycle_t WallCycles, PlaneCycles, MaskedCycles;
+
+	// Slice and timing of each thread in the last rendered frame.
+	struct SliceStat
+	{
+		int X1, X2;
+		double Time;
+	};
+	static std::vector<SliceStat> SliceStats;
 	
 	RenderScene::RenderScene()
 	{
@@ -186,14 +195,17 @@ namespace swrenderer
 			StartThreads(numThreads);
 		}
 
+		// Camera textures do not contribute to the estimate of the main view.
+		UpdateSliceBounds(numThreads, r_scene_balance && numThreads > 1 && !MainThread()->Viewport->RenderingToCanvas);
+
 		// Setup threads:
 		std::unique_lock<std::mutex> start_lock(start_mutex);
 		for (int i = 0; i < numThreads; i++)
 		{
 			*Threads[i]->Viewport = *MainThread()->Viewport;
 			*Threads[i]->Light = *MainThread()->Light;
-			Threads[i]->X1 = viewwidth * i / numThreads;
-			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
+			Threads[i]->X1 = SliceBounds[i];
+			Threads[i]->X2 = SliceBounds[i + 1];
 		}
 		run_id++;
 		FSoftwareTexture::CurrentUpdate = run_id;
@@ -221,13 +233,80 @@ namespace swrenderer
 			finished_threads = 0;
 		}
 
+		if (!MainThread()->Viewport->RenderingToCanvas)
+		{
+			SliceStats.resize(numThreads);
+			for (int i = 0; i < numThreads; i++)
+			{
+				SliceStats[i] = { Threads[i]->X1, Threads[i]->X2, Threads[i]->SliceTime };
+			}
+		}
+
 		// Change main thread back to covering the whole screen for player sprites
 		MainThread()->X1 = 0;
 		MainThread()->X2 = viewwidth;
 	}
 
+	void RenderScene::UpdateSliceBounds(int numThreads, bool balance)
+	{
+		SliceBounds.resize(numThreads + 1);
+		if (!balance || ColumnCost.size() != (size_t)viewwidth || Threads.size() != SliceStats.size())
+		{
+			for (int i = 0; i <= numThreads; i++)
+				SliceBounds[i] = viewwidth * i / numThreads;
+
+			if (balance)
+				ColumnCost.assign(viewwidth, 0.0);
+			return;
+		}
+
+		// Spread the time each thread needed for the last frame evenly over its columns and blend it
+		// into the running estimate. A few frames are enough for the boundaries to settle.
+		for (auto &stat : SliceStats)
+		{
+			int width = stat.X2 - stat.X1;
+			if (width <= 0)
+				continue;
+			double cost = stat.Time / width;
+			for (int x = stat.X1; x < stat.X2; x++)
+				ColumnCost[x] = ColumnCost[x] * 0.5 + cost * 0.5;
+		}
+
+		double total = 0.0;
+		for (double cost : ColumnCost)
+			total += cost;
+		if (total <= 0.0)
+		{
+			for (int i = 0; i <= numThreads; i++)
+				SliceBounds[i] = viewwidth * i / numThreads;
+			return;
+		}
+
+		// Cut at equal fractions of the total cost, but keep every slice at least a few columns wide
+		// so that a thread whose estimate dropped to nothing can still measure its share again.
+		const int minWidth = std::min(8, viewwidth / numThreads);
+		SliceBounds[0] = 0;
+		SliceBounds[numThreads] = viewwidth;
+		double sum = 0.0;
+		int x = 0;
+		for (int i = 1; i < numThreads; i++)
+		{
+			double target = total * i / numThreads;
+			int minX = SliceBounds[i - 1] + minWidth;
+			int maxX = viewwidth - minWidth * (numThreads - i);
+			while (x < maxX && (x < minX || sum + ColumnCost[x] <= target))
+			{
+				sum += ColumnCost[x];
+				x++;
+			}
+			SliceBounds[i] = x;
+		}
+	}
+
 	void RenderScene::RenderThreadSlice(RenderThread *thread)
 	{
+		auto startTime = std::chrono::steady_clock::now();
+
 		thread->FrameMemory->Clear();
 		thread->Clip3D->Cleanup();
 		thread->Clip3D->ResetClip(); // reset clips (floor/ceiling)
@@ -260,6 +339,8 @@ namespace swrenderer
 			thread->TranslucentPass->Render();
 		}
 
+		thread->SliceTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
 #if 0 // shows the render slice edges
 		if (thread->Viewport->RenderTarget->IsBgra())
 		{
@@ -396,6 +477,21 @@ namespace swrenderer
 		return out;
 	}
 
+	ADD_STAT(swthreads)
+	{
+		FString out;
+		double total = 0.0, longest = 0.0;
+		for (auto &stat : SliceStats)
+		{
+			out.AppendFormat("%d-%d: %04.1f ms  ", stat.X1, stat.X2, stat.Time);
+			total += stat.Time;
+			longest = std::max(longest, stat.Time);
+		}
+		if (total > 0.0)
+			out.AppendFormat("imbalance=%.2f", longest * SliceStats.size() / total);
+		return out;
+	}
+
 	static double f_acc, w_acc, p_acc, m_acc;
 	static int acc_c;
 
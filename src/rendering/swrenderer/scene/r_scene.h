@@ -59,6 +59,7 @@ namespace swrenderer
 		void RenderActorView(AActor *actor,bool renderplayersprite, bool dontmaplines);
 		void RenderThreadSlices();
 		void RenderThreadSlice(RenderThread *thread);
+		void UpdateSliceBounds(int numThreads, bool balance);
 		void RenderPSprites();
 
 		void StartThreads(size_t numThreads);
@@ -75,5 +76,9 @@ namespace swrenderer
 		std::mutex end_mutex;
 		std::condition_variable end_condition;
 		size_t finished_threads = 0;
+
+		// Estimated render cost of each column, used to balance the slices between the threads.
+		std::vector<double> ColumnCost;
+		std::vector<int> SliceBounds;
 	};
 }
@@ -55,6 +55,7 @@
 #include "thingdef.h"
 #include "zcc_parser.h"
 #include "zcc_compile_doom.h"
+#include "vmcache.h"
 
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 void InitThingdef();
@@ -444,6 +445,48 @@ void ParseScripts()
 	}
 }
 
+//==========================================================================
+//
+// State pointers are the only game specific address constants
+// the script cache needs to deal with.
+//
+//==========================================================================
+
+static TMap<FState *, PClassActor *> StateOwners;
+
+static bool EncodeStatePointer(void *ptr, FName &owner, int &index)
+{
+	// All states exist by now, so the map only needs to be set up once. AllActorClasses hasn't been set up yet.
+	if (StateOwners.CountUsed() == 0)
+	{
+		for (auto cls : PClass::AllClasses)
+		{
+			if (!cls->IsDescendantOf(RUNTIME_CLASS(AActor))) continue;
+			auto ti = static_cast<PClassActor *>(cls);
+			auto info = ti->ActorInfo();
+			if (info == nullptr) continue;
+			for (int i = 0; i < info->NumOwnedStates; i++) StateOwners[info->OwnedStates + i] = ti;
+		}
+	}
+	auto pti = StateOwners.CheckKey((FState *)ptr);
+	if (pti == nullptr) return false;
+	owner = (*pti)->TypeName;
+	index = int((FState *)ptr - (*pti)->GetStates());
+	return true;
+}
+
+static void *DecodeStatePointer(FName owner, int index)
+{
+	auto ti = PClass::FindActor(owner);
+	if (ti == nullptr || ti->ActorInfo() == nullptr || (unsigned)index >= ti->GetStateCount()) return nullptr;
+	return ti->GetStates() + index;
+}
+
+static unsigned StateLabelSize()
+{
+	return StateLabels.Storage.Size();
+}
+
 void LoadActors()
 {
 	cycle_t timer;
@@ -454,13 +497,18 @@ void LoadActors()
 	SetDoomCompileEnvironment();
 	InitThingdef();
 	FScriptPosition::StrictErrors = true;
+	VMCache_BeginSources();
 	ParseScripts();
 
 	FScriptPosition::StrictErrors = strictdecorate;
 	ParseAllDecorate();
 	SynthesizeFlagFields();
 
+	ScriptCacheHooks.EncodePointer = EncodeStatePointer;
+	ScriptCacheHooks.DecodePointer = DecodeStatePointer;
+	ScriptCacheHooks.GeneratedDataSize = StateLabelSize;
 	FunctionBuildList.Build();
+	StateOwners.Clear();
 
 	if (FScriptPosition::ErrorCounter > 0)
 	{
@@ -40,14 +40,34 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
 
 #include "doomdata.h"
 #include "nodebuild.h"
+#include "c_cvars.h"
+#include "ctpl.h"
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
 const int AAPreference = 16;
 
+// Splitter candidates are only scored in parallel if there is enough work to
+// make it worthwhile. This is measured in candidate * seg pairs.
+const int MinParallelCandidates = 16;
+const int MinParallelWork = 1 << 18;
+
+// 0 picks a thread count based on the number of cores, 1 disables threading.
+CUSTOM_CVAR(Int, nodebuild_threads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > 16) self = 16;
+}
+
+static ctpl::thread_pool nodePool;	// no threads until candidates first get scored in parallel
+
 #if 0
 #define D(x) x
 #else
@@ -428,7 +448,7 @@ bool FNodeBuilder::ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uin
 		node.dx = -node.dx;
 		node.dy = -node.dy;
 	}
-	return Heuristic (node, set, false) > 0;
+	return Heuristic (node, set, false, Touched, Colinear) > 0;
 }
 
 // Splitters are chosen to coincide with segs in the given set. To reduce the
@@ -444,6 +464,7 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	int bestvalue;
 	uint32_t bestseg;
 	uint32_t seg;
+	unsigned int segcount;
 	bool nosplitters = false;
 
 	bestvalue = 0;
@@ -451,11 +472,15 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 
 	seg = set;
 	stepleft = 0;
+	segcount = 0;
 
 	memset (&PlaneChecked[0], 0, PlaneChecked.Size());
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
+	// Collect the segs to try as splitters first. Which segs are picked only
+	// depends on their order in the set, not on how well they score.
+	Candidates.Clear();
 	while (seg != UINT_MAX)
 	{
 		FPrivSeg *pseg = &Segs[seg];
@@ -473,32 +498,39 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
-
-				int value = Heuristic (node, set, nosplit);
-
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
-
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
+				Candidates.Push(seg);
 			}
 		}
 
 		seg = pseg->next;
+		segcount++;
+	}
+
+	ScoreCandidates (set, nosplit, segcount);
+
+	for (unsigned int i = 0; i < Candidates.Size(); ++i)
+	{
+		int value = CandidateScores[i];
+
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d scores %d\n", Candidates[i], Segs[Candidates[i]].linedef, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = Candidates[i];
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
 	}
 
 	if (bestseg == UINT_MAX)
 	{
 		// No lines split any others into two sets, so this is a convex region.
 		D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
+		// The caller may still split along node, which used to be left at the last candidate scored.
+		if (Candidates.Size() > 0) SetNodeFromSeg (node, &Segs[Candidates.Last()]);
 		return nosplitters ? -1 : 0;
 	}
 
@@ -509,13 +541,65 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	return 1;
 }
 
+// Runs the heuristic for every seg in Candidates. Scoring a splitter does not
+// modify the builder, so large sets are distributed over several threads. The
+// scores are stored by candidate index, so the splitter that gets picked is
+// the same no matter how many threads were used.
+
+void FNodeBuilder::ScoreCandidates (uint32_t set, bool nosplit, unsigned int segcount)
+{
+	unsigned int numcandidates = Candidates.Size();
+	CandidateScores.Resize(numcandidates);
+
+	int numthreads = nodebuild_threads;
+	if (numthreads == 0) numthreads = clamp<int>(std::thread::hardware_concurrency(), 1, 16);
+	numthreads = min<int>(numthreads, numcandidates / MinParallelCandidates);
+
+	if (numthreads <= 1 || (double)numcandidates * segcount < MinParallelWork)
+	{
+		for (unsigned int i = 0; i < numcandidates; ++i)
+		{
+			node_t node;
+			SetNodeFromSeg (node, &Segs[Candidates[i]]);
+			CandidateScores[i] = Heuristic (node, set, nosplit, Touched, Colinear);
+		}
+		return;
+	}
+
+	if (nodePool.size() < numthreads - 1) nodePool.resize(numthreads - 1);
+
+	std::atomic<unsigned int> next{ 0 };
+	auto work = [&](TArray<int> &touched, TArray<int> &colinear)
+	{
+		unsigned int i;
+		while ((i = next++) < numcandidates)
+		{
+			node_t node;
+			SetNodeFromSeg (node, &Segs[Candidates[i]]);
+			CandidateScores[i] = Heuristic (node, set, nosplit, touched, colinear);
+		}
+	};
+
+	std::vector<std::future<void>> futures(numthreads - 1);
+	for (int i = 0; i < numthreads - 1; i++)
+	{
+		futures[i] = nodePool.push([&](int)
+		{
+			TArray<int> touched, colinear;
+			work(touched, colinear);
+		});
+	}
+	work(Touched, Colinear);
+	for (auto &f : futures) f.wait();
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
 // true. A score of 0 means that the splitter does not split any of the segs
 // in the set.
 
-int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -530,8 +614,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != UINT_MAX)
 	{
@@ -557,32 +641,32 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -699,8 +783,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -713,10 +797,10 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}